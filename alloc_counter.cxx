@@ -0,0 +1,103 @@
+#include "alloc_counter.hxx"
+
+#ifdef OPENGL_WINDOW_COUNT_ALLOCATIONS
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<std::uint64_t> allocations{ 0 };
+
+static void* counted_alloc(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+static void* counted_aligned_alloc(std::size_t size, std::align_val_t align)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t a = static_cast<std::size_t>(align);
+    if (void* p = std::aligned_alloc(a, (size + a - 1) / a * a))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size)
+{
+    return counted_alloc(size);
+}
+void* operator new[](std::size_t size)
+{
+    return counted_alloc(size);
+}
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    return counted_aligned_alloc(size, align);
+}
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+    return counted_aligned_alloc(size, align);
+}
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+namespace eng
+{
+bool allocation_counting_enabled()
+{
+    return true;
+}
+std::uint64_t heap_allocation_count()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+} // namespace eng
+#else
+namespace eng
+{
+bool allocation_counting_enabled()
+{
+    return false;
+}
+std::uint64_t heap_allocation_count()
+{
+    return 0;
+}
+} // namespace eng
+#endif
@@ -0,0 +1,14 @@
+#ifndef OPENGL_WINDOW_ALLOC_COUNTER_HXX
+#define OPENGL_WINDOW_ALLOC_COUNTER_HXX
+#include <cstdint>
+
+namespace eng
+{
+// true when the build replaces the global operator new with the counting
+// one (cmake -DOPENGL_WINDOW_COUNT_ALLOCATIONS=ON)
+bool allocation_counting_enabled();
+// number of calls to the global operator new since start, always 0 when
+// counting is disabled
+std::uint64_t heap_allocation_count();
+} // namespace eng
+#endif // OPENGL_WINDOW_ALLOC_COUNTER_HXX
@@ -0,0 +1,64 @@
+#include "camera.hxx"
+
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "engine.hxx"
+
+namespace eng
+{
+glm::mat4 camera::view() const
+{
+    glm::mat4 v = glm::rotate(glm::mat4(1.0f), -rotation, glm::vec3(0, 0, 1));
+    return glm::translate(v, glm::vec3(-position.x, -position.y, 0.0f));
+}
+
+glm::mat4 camera::projection() const
+{
+    const glm::vec2 half = extent * (0.5f / zoom);
+    return glm::ortho(-half.x, half.x, -half.y, half.y);
+}
+
+glm::mat4 camera::view_projection() const
+{
+    return projection() * view();
+}
+
+void camera::visible_rect(glm::vec2& min, glm::vec2& max) const
+{
+    const glm::vec2 half = extent * (0.5f / zoom);
+    const float     c    = std::fabs(std::cos(rotation));
+    const float     s    = std::fabs(std::sin(rotation));
+    const glm::vec2 bound{ half.x * c + half.y * s, half.x * s + half.y * c };
+    min = position - bound;
+    max = position + bound;
+}
+
+glm::ivec4 camera::pixel_viewport() const
+{
+    if (viewport.z <= 0 || viewport.w <= 0)
+    {
+        return { 0, 0, eng::width, eng::height };
+    }
+    return viewport;
+}
+
+glm::vec2 camera::screen_to_world(glm::vec2 pixel) const
+{
+    const glm::ivec4 vp = pixel_viewport();
+    // the viewport is counted from the bottom row like glViewport, pixels
+    // from the top row
+    const glm::vec2  origin(static_cast<float>(vp.x),
+                            static_cast<float>(eng::height - (vp.y + vp.w)));
+    const glm::vec2  size(static_cast<float>(vp.z), static_cast<float>(vp.w));
+    // pixel to -1..1 with y up, then undo projection scale and view
+    glm::vec2 ndc = (pixel - origin) / size;
+    ndc           = glm::vec2(ndc.x * 2.f - 1.f, 1.f - ndc.y * 2.f);
+    const glm::vec2 local = ndc * extent * (0.5f / zoom);
+    const float     c     = std::cos(rotation);
+    const float     s     = std::sin(rotation);
+    return position +
+           glm::vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+}
+} // namespace eng
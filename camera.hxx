@@ -0,0 +1,32 @@
+#ifndef OPENGL_WINDOW_CAMERA_HXX
+#define OPENGL_WINDOW_CAMERA_HXX
+#include <glm/glm.hpp>
+
+namespace eng
+{
+// binding point of the std140 camera_block shared by every program
+constexpr unsigned int camera_block_binding = 0;
+
+struct camera
+{
+    glm::vec2 position{ 0.f, 0.f };
+    float     zoom     = 1.f;
+    float     rotation = 0.f; // radians, counter clockwise
+    glm::vec2 extent{ 2.f, 2.f }; // world units visible at zoom 1
+    // pixel rectangle x, y, width, height, empty means the whole window
+    glm::ivec4 viewport{ 0, 0, 0, 0 };
+
+    // viewport with the empty default resolved to the whole window
+    glm::ivec4 pixel_viewport() const;
+
+    glm::mat4 view() const;
+    glm::mat4 projection() const;
+    glm::mat4 view_projection() const;
+
+    // world space bounding box of everything the camera can see
+    void visible_rect(glm::vec2& min, glm::vec2& max) const;
+    // pixel inside the viewport, y growing down, to world position
+    glm::vec2 screen_to_world(glm::vec2 pixel) const;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_CAMERA_HXX
@@ -0,0 +1,270 @@
+#include "debug_log.hxx"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+
+#include "glad/glad.h"
+
+namespace eng
+{
+static const char* source_to_strv(GLenum source)
+{
+    switch (source)
+    {
+        case GL_DEBUG_SOURCE_API:
+            return "API";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER:
+            return "SHADER_COMPILER";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
+            return "WINDOW_SYSTEM";
+        case GL_DEBUG_SOURCE_THIRD_PARTY:
+            return "THIRD_PARTY";
+        case GL_DEBUG_SOURCE_APPLICATION:
+            return "APPLICATION";
+        case GL_DEBUG_SOURCE_OTHER:
+            return "OTHER";
+    }
+    return "unknown";
+}
+
+static const char* type_to_strv(GLenum type)
+{
+    switch (type)
+    {
+        case GL_DEBUG_TYPE_ERROR:
+            return "ERROR";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+            return "DEPRECATED_BEHAVIOR";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+            return "UNDEFINED_BEHAVIOR";
+        case GL_DEBUG_TYPE_PERFORMANCE:
+            return "PERFORMANCE";
+        case GL_DEBUG_TYPE_PORTABILITY:
+            return "PORTABILITY";
+        case GL_DEBUG_TYPE_MARKER:
+            return "MARKER";
+        case GL_DEBUG_TYPE_PUSH_GROUP:
+            return "PUSH_GROUP";
+        case GL_DEBUG_TYPE_POP_GROUP:
+            return "POP_GROUP";
+        case GL_DEBUG_TYPE_OTHER:
+            return "OTHER";
+    }
+    return "unknown";
+}
+
+static const char* severity_to_strv(GLenum severity)
+{
+    switch (severity)
+    {
+        case GL_DEBUG_SEVERITY_HIGH:
+            return "HIGH";
+        case GL_DEBUG_SEVERITY_MEDIUM:
+            return "MEDIUM";
+        case GL_DEBUG_SEVERITY_LOW:
+            return "LOW";
+        case GL_DEBUG_SEVERITY_NOTIFICATION:
+            return "NOTIFICATION";
+    }
+    return "unknown";
+}
+
+debug_log::debug_log(std::ostream& out, std::chrono::milliseconds interval)
+    : cells(new cell[capacity])
+    , out(out)
+    , interval(interval)
+{
+    for (std::size_t i = 0; i < capacity; ++i)
+    {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    flusher = std::thread(&debug_log::flush_loop, this);
+}
+
+debug_log::~debug_log()
+{
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stop = true;
+    }
+    wake.notify_one();
+    flusher.join();
+}
+
+void debug_log::fill(debug_record& r,
+                     std::uint32_t source,
+                     std::uint32_t type,
+                     std::uint32_t id,
+                     std::uint32_t severity,
+                     int           length,
+                     const char*   message)
+{
+    // a negative length means null terminated, longer messages are cut
+    const std::size_t n =
+        length < 0 ? std::strlen(message) : static_cast<std::size_t>(length);
+    r.source   = source;
+    r.type     = type;
+    r.id       = id;
+    r.severity = severity;
+    r.length   = static_cast<std::uint32_t>(std::min(n, sizeof(r.message)));
+    std::memcpy(r.message, message, r.length);
+}
+
+int debug_log::format(const debug_record& r, char* out, std::size_t size)
+{
+    const int n = std::snprintf(out,
+                                size,
+                                "%s %s %u %s %.*s\n",
+                                source_to_strv(r.source),
+                                type_to_strv(r.type),
+                                r.id,
+                                severity_to_strv(r.severity),
+                                static_cast<int>(r.length),
+                                r.message);
+    return std::clamp(n, 0, static_cast<int>(size) - 1);
+}
+
+bool debug_log::first_occurrence(std::uint64_t key)
+{
+    const std::size_t hash =
+        static_cast<std::size_t>((key * 0x9e3779b97f4a7c15ull) >> 32);
+    // a short probe, a full table just stops deduplicating
+    for (std::size_t probe = 0; probe < 8; ++probe)
+    {
+        repeat_slot&  slot     = repeats[(hash + probe) & (dedupe_slots - 1)];
+        std::uint64_t occupant = slot.key.load(std::memory_order_acquire);
+        if (occupant == 0 &&
+            slot.key.compare_exchange_strong(
+                occupant, key, std::memory_order_acq_rel))
+        {
+            return true;
+        }
+        // occupant holds the winner when the exchange failed
+        if (occupant == key)
+        {
+            slot.repeats.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool debug_log::push(std::uint32_t source,
+                     std::uint32_t type,
+                     std::uint32_t id,
+                     std::uint32_t severity,
+                     int           length,
+                     const char*   message)
+{
+    // source and type enums fit in 16 bits, source is never zero
+    const std::uint64_t key = (std::uint64_t{ source & 0xffffu } << 48) |
+                              (std::uint64_t{ type & 0xffffu } << 32) | id;
+    if (!first_occurrence(key))
+    {
+        return true;
+    }
+
+    // Vyukov's bounded queue: a cell is free for the producer whose
+    // position matches its sequence
+    std::size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    cell*       c   = nullptr;
+    for (;;)
+    {
+        c = &cells[pos & (capacity - 1)];
+        const std::size_t seq = c->sequence.load(std::memory_order_acquire);
+        const auto        dif = static_cast<std::ptrdiff_t>(seq - pos);
+        if (dif == 0)
+        {
+            if (enqueue_pos.compare_exchange_weak(
+                    pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (dif < 0)
+        {
+            dropped_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+    fill(c->record, source, type, id, severity, length, message);
+    c->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool debug_log::pop(debug_record& r)
+{
+    cell& c = cells[dequeue_pos & (capacity - 1)];
+    if (c.sequence.load(std::memory_order_acquire) != dequeue_pos + 1)
+    {
+        return false;
+    }
+    r = c.record;
+    c.sequence.store(dequeue_pos + capacity, std::memory_order_release);
+    ++dequeue_pos;
+    return true;
+}
+
+void debug_log::flush()
+{
+    char         line[512];
+    debug_record r;
+    bool         wrote = false;
+    while (pop(r))
+    {
+        out.write(line, format(r, line, sizeof(line)));
+        wrote = true;
+    }
+    for (repeat_slot& slot : repeats)
+    {
+        const std::uint32_t n =
+            slot.repeats.exchange(0, std::memory_order_relaxed);
+        if (n == 0)
+        {
+            continue;
+        }
+        const std::uint64_t key = slot.key.load(std::memory_order_relaxed);
+        const int           length =
+            std::snprintf(line,
+                          sizeof(line),
+                          "%s %s %u repeated %u times\n",
+                          source_to_strv(static_cast<GLenum>(key >> 48)),
+                          type_to_strv(static_cast<GLenum>(key >> 32 & 0xffff)),
+                          static_cast<std::uint32_t>(key),
+                          n);
+        out.write(line,
+                  std::clamp(length, 0, static_cast<int>(sizeof(line)) - 1));
+        wrote = true;
+    }
+    const std::uint64_t dropped_now = dropped();
+    if (dropped_now != dropped_reported)
+    {
+        out << dropped_now - dropped_reported
+            << " GL debug messages dropped, the log ring was full\n";
+        dropped_reported = dropped_now;
+        wrote            = true;
+    }
+    if (wrote)
+    {
+        out.flush();
+    }
+}
+
+void debug_log::flush_loop()
+{
+    std::unique_lock<std::mutex> lock(wake_mutex);
+    while (!stop)
+    {
+        wake.wait_for(lock, interval, [this] { return stop; });
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+} // namespace eng
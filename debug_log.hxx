@@ -0,0 +1,106 @@
+#ifndef OPENGL_WINDOW_DEBUG_LOG_HXX
+#define OPENGL_WINDOW_DEBUG_LOG_HXX
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace eng
+{
+// GL debug messages as they arrive from the driver: any thread, possibly
+// inside a GL call, so nothing here may block or allocate
+struct debug_record
+{
+    std::uint32_t source;
+    std::uint32_t type;
+    std::uint32_t id;
+    std::uint32_t severity;
+    std::uint32_t length;
+    char          message[236];
+};
+
+// bounded multi producer, single consumer log for the GL debug callback.
+// Producers claim a cell with one CAS and never wait: a full ring drops the
+// record and counts it. The first message with a given source, type and id
+// is queued in full, later ones only bump a counter that the flush thread
+// reports as a repeat summary. The flush thread writes to out every
+// interval and once more on destruction
+class debug_log
+{
+public:
+    static constexpr std::size_t capacity     = 1024; // power of two
+    static constexpr std::size_t dedupe_slots = 256;  // power of two
+
+    explicit debug_log(std::ostream&             out,
+                       std::chrono::milliseconds interval =
+                           std::chrono::milliseconds(100));
+    ~debug_log();
+
+    debug_log(const debug_log&)            = delete;
+    debug_log& operator=(const debug_log&) = delete;
+
+    // any thread, false when the ring was full and the record dropped
+    bool push(std::uint32_t source,
+              std::uint32_t type,
+              std::uint32_t id,
+              std::uint32_t severity,
+              int           length,
+              const char*   message);
+
+    std::uint64_t dropped() const
+    {
+        return dropped_count.load(std::memory_order_relaxed);
+    }
+
+    // for writing a message right away, on the thread that got it
+    static void fill(debug_record& r,
+                     std::uint32_t source,
+                     std::uint32_t type,
+                     std::uint32_t id,
+                     std::uint32_t severity,
+                     int           length,
+                     const char*   message);
+    // one line the way the flush thread writes it, returns its length
+    static int format(const debug_record& r, char* out, std::size_t size);
+
+private:
+    struct cell
+    {
+        std::atomic<std::size_t> sequence;
+        debug_record             record;
+    };
+    struct repeat_slot
+    {
+        std::atomic<std::uint64_t> key{ 0 };
+        std::atomic<std::uint32_t> repeats{ 0 };
+    };
+
+    // false when the message was seen before and only counted
+    bool first_occurrence(std::uint64_t key);
+    bool pop(debug_record& out);
+    void flush();
+    void flush_loop();
+
+    std::unique_ptr<cell[]> cells;
+    // producers share the first, the flush thread owns the second
+    alignas(64) std::atomic<std::size_t> enqueue_pos{ 0 };
+    alignas(64) std::size_t dequeue_pos = 0;
+
+    repeat_slot                repeats[dedupe_slots];
+    std::atomic<std::uint64_t> dropped_count{ 0 };
+    std::uint64_t              dropped_reported = 0;
+
+    std::ostream&             out;
+    std::chrono::milliseconds interval;
+    std::mutex                wake_mutex;
+    std::condition_variable   wake;
+    bool                      stop = false;
+    std::thread               flusher;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_DEBUG_LOG_HXX
@@ -0,0 +1,55 @@
+#include "dynamic_resolution.hxx"
+
+#include <algorithm>
+#include <cmath>
+
+namespace eng
+{
+resolution_controller::resolution_controller(float target_ms, float min_scale)
+    : target(target_ms)
+    , min_scale(min_scale)
+    , filtered(target_ms)
+{
+}
+
+float resolution_controller::update(float frame_ms)
+{
+    // one slow frame, a hitch from loading or the OS, should not move it
+    filtered += (frame_ms - filtered) * 0.1f;
+    if (cooldown > 0)
+    {
+        --cooldown;
+        return current;
+    }
+
+    const bool over  = filtered > target * 1.05f;
+    const bool under = filtered < target * 0.85f;
+    if (!over && !under)
+    {
+        return current;
+    }
+    const float wanted = std::clamp(
+        current * std::sqrt(target / filtered), min_scale, 1.f);
+    // whole steps, at least one in the right direction
+    float next = std::round(wanted / step) * step;
+    if (over)
+    {
+        next = std::min(next, current - step);
+    }
+    else
+    {
+        next = std::max(next, current + step);
+    }
+    next = std::clamp(next, min_scale, 1.f);
+    if (next == current)
+    {
+        return current;
+    }
+    current = next;
+    // timer results trail by a few frames, give the new size time to show
+    // in them, and be slower to raise than to drop
+    cooldown = over ? 10 : 60;
+    filtered = target;
+    return current;
+}
+} // namespace eng
@@ -0,0 +1,31 @@
+#ifndef OPENGL_WINDOW_DYNAMIC_RESOLUTION_HXX
+#define OPENGL_WINDOW_DYNAMIC_RESOLUTION_HXX
+
+namespace eng
+{
+// picks the render scale, a fraction of the window size per axis, that keeps
+// the measured frame time near a target. The GPU cost follows the pixel
+// count, so the scale moves with the square root of the time ratio. Drops
+// are applied quickly, raises only after a stretch of headroom, and the
+// scale moves in fixed steps so the render target pool sees a handful of
+// sizes instead of a new one every frame
+class resolution_controller
+{
+public:
+    resolution_controller(float target_ms, float min_scale);
+
+    // feeds the newest frame time, returns the scale for the next frame
+    float update(float frame_ms);
+    float scale() const { return current; }
+
+    static constexpr float step = 0.05f;
+
+private:
+    float target;
+    float min_scale;
+    float current  = 1.f;
+    float filtered = 0.f;
+    int   cooldown = 0;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_DYNAMIC_RESOLUTION_HXX
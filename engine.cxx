@@ -4,12 +4,17 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cassert>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
 #include "glad/glad.h"
@@ -19,37 +24,26 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "alloc_counter.hxx"
+#include "debug_log.hxx"
+#include "dynamic_resolution.hxx"
 #include "engine.hxx"
+#include "frame_capture.hxx"
+#include "gl_check.hxx"
+#include "gl_trace.hxx"
+#include "gpu_particles.hxx"
+#include "gpu_timer.hxx"
+#include "headless_context.hxx"
+#include "particle_renderer.hxx"
+#include "perf_overlay.hxx"
+#include "png.hxx"
+#include "shader.hxx"
+#include "sprite_renderer.hxx"
+#include "text.hxx"
+#include "vertex_format.hxx"
+#include "vertex_ring.hxx"
 namespace eng
 {
-#define OM_GL_CHECK()                                                          \
-    {                                                                          \
-        const int err = static_cast<int>(glGetError());                        \
-        if (err != GL_NO_ERROR)                                                \
-        {                                                                      \
-            switch (err)                                                       \
-            {                                                                  \
-                case GL_INVALID_ENUM:                                          \
-                    std::cerr << "GL_INVALID_ENUM" << std::endl;               \
-                    break;                                                     \
-                case GL_INVALID_VALUE:                                         \
-                    std::cerr << "GL_INVALID_VALUE" << std::endl;              \
-                    break;                                                     \
-                case GL_INVALID_OPERATION:                                     \
-                    std::cerr << "GL_INVALID_OPERATION" << std::endl;          \
-                    break;                                                     \
-                case GL_INVALID_FRAMEBUFFER_OPERATION:                         \
-                    std::cerr << "GL_INVALID_FRAMEBUFFER_OPERATION"            \
-                              << std::endl;                                    \
-                    break;                                                     \
-                case GL_OUT_OF_MEMORY:                                         \
-                    std::cerr << "GL_OUT_OF_MEMORY" << std::endl;              \
-                    break;                                                     \
-            }                                                                  \
-            assert(false);                                                     \
-        }                                                                      \
-    }
-
 static void APIENTRY
 callback_opengl_debug(GLenum                       source,
                       GLenum                       type,
@@ -78,144 +72,296 @@ public:
     std::string get_name() { return this->name; }
     enum event  get_event() { return ev; }
 };
-struct Shader
+struct decoded_image;
+class engine_impl final : public eng::engine
 {
-    GLuint ID;
+    std::unique_ptr<headless_context> headless;
+    // GL debug messages, written by a thread of its own unless the build
+    // asks for synchronous debug output
+    debug_log gl_log{ std::cerr };
+
+    SDL_Window*        window  = nullptr;
+    SDL_GLContext      context = nullptr;
+    std::string        flag;
+    std::vector<CKeys> binded_keys;
+    unsigned int       ID;
 
-    Shader(std::string vertexPath, std::string fragmentPath)
+    // std140 layout of camera_block in the shaders
+    struct camera_block
     {
-        std::string   vertexCode;
-        std::string   fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        try
-        {
-            // open files
-            vShaderFile.open(vertexPath.c_str());
-            fShaderFile.open(fragmentPath.c_str());
-            std::stringstream vShaderStream, fShaderStream;
-            // read file’s buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode   = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-        }
-        catch (std::ifstream::failure e)
-        {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ"
-                      << std::endl;
-        }
-        const char*  vShaderCode = vertexCode.c_str();
-        const char*  fShaderCode = fragmentCode.c_str();
-        unsigned int vertex, fragment;
-        int          success;
-        char         infoLog[512];
-        vertex = glCreateShader(GL_VERTEX_SHADER);
+        glm::mat4 view_projection;
+        glm::vec4 viewport;
+    };
+    GLuint                  camera_ubo = 0;
+    std::unique_ptr<Shader> sprite_shader;
+    job_system              job_pool;
+    frame_arena             transient{ 4 * 1024 * 1024 };
+    std::uint64_t           frame_allocations   = 0;
+    std::uint64_t           allocations_at_swap = 0;
+    std::uint64_t           frames_presented    = 0;
+    // the steady frame that touched the heap most, reported at shutdown
+    std::uint64_t           worst_frame             = 0;
+    std::uint64_t           worst_frame_allocations = 0;
 
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
+    // sprites are recorded by draw_texture into a vertex ring and drawn in
+    // as few calls as texture changes allow by flush_sprites
+    struct sprite_batch
+    {
+        int   texture;
+        bool  text; // drawn with the distance field program
+        GLint first_vertex;
+        int   quads;
+    };
+    static constexpr int max_quads_per_draw = 16384; // 16 bit indices
 
-        glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+    // quads one ring region holds, engine_config::max_sprite_quads_per_frame
+    std::size_t sprite_quads_per_region = 0;
 
-        if (!success)
-        {
-            glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-            std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
-                      << infoLog << std::endl;
-        };
+    std::unique_ptr<vertex_ring> sprite_vertices;
+    vertex_layout                sprite_layout      = vertex_layout::compact;
+    std::size_t                  sprite_vertex_size = sizeof(eng::vertex);
+    GLuint                       sprite_vao         = 0;
+    GLuint                       sprite_ebo         = 0;
+    sprite_batch*                sprite_batches     = nullptr;
+    int                          sprite_batch_count = 0;
 
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-        if (!success)
-        {
-            glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-            std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
-                      << infoLog << std::endl;
-        };
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
-        glGetProgramiv(ID, GL_LINK_STATUS, &success);
-        if (!success)
-        {
-            glGetProgramInfoLog(ID, 512, NULL, infoLog);
-            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-                      << infoLog << std::endl;
-        }
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-    }
-    void use() const { glUseProgram(ID); }
+    std::unique_ptr<particle_renderer> particle_draw;
+    std::unique_ptr<sprite_renderer>   sprite_draw;
 
-    void setInt(const std::string& name, int value) const
+    // fonts keep their glyph metrics, the pixels only live in the texture
+    struct loaded_font
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
-    }
-    // ------------------------------------------------------------------------
-    void setFloat(const std::string& name, float value) const
+        GLuint     texture;
+        font_atlas atlas;
+    };
+    std::unique_ptr<Shader>  text_shader;
+    std::vector<loaded_font> fonts;
+    text_layout_cache        text_layouts;
+
+    bool push_sprite_quad(const eng::vertex (&quad)[4], int texture, bool text);
+
+    // the overlay is drawn in screen pixels with the text program, panel
+    // and graph sample the font's solid block so everything is one batch
+    using clock = std::chrono::steady_clock;
+    perf_overlay      overlay;
+    int               overlay_font = 0;
+    camera            current_camera;
+    render_stats      previous_stats;
+
+    render_target_pool   target_pool;
+    const render_target* bound_target = nullptr;
+
+    // dynamic resolution: the frame is drawn into scene_target, timed on
+    // the GPU and scaled up to the window by present_scene
+    std::unique_ptr<resolution_controller> resolution;
+    std::unique_ptr<gpu_timer>             scene_timer;
+    std::unique_ptr<Shader>                upscale_shader;
+    upscale_filter                         upscale = upscale_filter::sharpen;
+    GLuint                                 upscale_vao  = 0;
+    const render_target*                   scene_target = nullptr;
+
+    // with engine_config::headless there is no window, the EGL context is
+    // declared first so it outlives everything holding GL objects, and a
+    // window sized target takes the place of the window framebuffer
+    std::unique_ptr<render_target> headless_target;
+
+    bool   create_window(const engine_config& config);
+    bool   create_headless(const engine_config& config);
+    GLuint window_framebuffer() const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        return headless_target ? headless_target->framebuffer() : 0;
     }
-    void setMat3(const std::string& name, const glm::mat3& mat) const
+
+    void begin_scene();
+    void present_scene();
+    clock::time_point last_present = clock::now();
+
+    // frames asked for by capture_frame are read back right before the
+    // swap, the readback slots are created by the first request. The
+    // recorder is declared first so it outlives the captures feeding it
+    std::unique_ptr<frame_recorder>      recorder;
+    std::unique_ptr<frame_capture>       captures;
+    std::vector<frame_capture::consumer> queued_captures;
+
+    void capture_queued();
+
+    void draw_overlay();
+    void push_solid_quad(const loaded_font& f,
+                         glm::vec2          min,
+                         glm::vec2          max,
+                         glm::vec3          color);
+    bool                               has_compute = false;
+
+    void create_sprite_pipeline();
+    void begin_sprite_frame();
+
+    int upload_texture(const decoded_image& img,
+                       const std::string&   path,
+                       bool                 srgb);
+    // bytes counted in gpu_memory_bytes by texture handle
+    std::unordered_map<int, std::int64_t> texture_bytes;
+
+public:
+    ~engine_impl() override
     {
-        glUniformMatrix3fv(
-            glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        // the context may outlive the engine, its messages must not reach
+        // the destroyed log
+        if (glDebugMessageCallback)
+        {
+            glDebugMessageCallback(nullptr, nullptr);
+        }
+        stop_gl_trace();
+        if (worst_frame_allocations != 0)
+        {
+            std::cerr << "frame " << worst_frame << " made "
+                      << worst_frame_allocations
+                      << " heap allocations, the most of any steady frame\n";
+        }
     }
-    // ------------------------------------------------------------------------
-    void setMat4(const std::string& name, const glm::mat4& mat) const
+    // the forwarding overloads stay visible next to the overrides
+    using engine::initialize_engine;
+    using engine::load_font;
+    bool initialize_engine(const engine_config& config) final;
+
+    void draw_triangle(eng::triangle t1, eng::triangle t2) final;
+
+    // the overloads without srgb stay visible next to the overrides
+    using engine::load_texture;
+    using engine::load_textures;
+    int              load_texture(std::string path, bool srgb) final;
+    std::vector<int> load_textures(const std::vector<std::string>& paths,
+                                   bool srgb) final;
+    void             unload_texture(int texture) final;
+    job_system&      jobs() final { return job_pool; }
+    frame_arena&     frame_memory() final { return transient; }
+    std::uint64_t    last_frame_allocations() const final
     {
-        glUniformMatrix4fv(
-            glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        return frame_allocations;
     }
-    void setVec3(const std::string& name, float x, float y, float z) const
+    const render_stats& last_frame_stats() const final
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        return previous_stats;
     }
-    void setVec4(
-        const std::string& name, float x, float y, float z, float w) const
+    void toggle_overlay() final { overlay.toggle(); }
+    void capture_frame(frame_capture::consumer fn) final;
+    void save_screenshot(const std::string& path) final;
+    bool start_recording(const recording_config& config) final;
+    recording_stats stop_recording() final;
+    void set_render_target(const render_target* target) final;
+    void clear(glm::vec4 color) final;
+    render_target_pool& render_targets() final { return target_pool; }
+    float               render_scale() const final
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        return resolution ? resolution->scale() : 1.f;
     }
-};
-class engine_impl final : public eng::engine
-{
-    SDL_Window*        window  = nullptr;
-    SDL_GLContext      context = nullptr;
-    std::string        flag;
-    std::vector<CKeys> binded_keys;
-    unsigned int       ID;
-
-public:
-    bool initialize_engine() final;
-
-    void draw_triangle(eng::triangle t1, eng::triangle t2) final;
-
-    int load_texture(std::string path) final;
 
     bool draw_texture(eng::triangle t1,
                       eng::triangle t2,
                       int           texHandle,
                       glm::mat4     transform) final;
+    int  load_font(const std::string& ttf_path, float pixel_height) final;
+    bool draw_text(int              font,
+                   std::string_view text,
+                   glm::vec2        top_left,
+                   float            line_height,
+                   glm::vec3        color) final;
+    void set_camera(const camera& c) final;
     bool get_input(event& e) final;
     bool rebind_key() final;
+    void        flush_sprites() final;
+    std::size_t draw_particles(const particle_emitter& emitter) final
+    {
+        flush_sprites();
+        return particle_draw->draw(emitter);
+    }
+    void draw_particles(gpu_particle_system& particles) final
+    {
+        flush_sprites();
+        particles.draw();
+    }
+    sprite_instance* map_sprite_instances(std::size_t n) final
+    {
+        return sprite_draw->map(n);
+    }
+    std::size_t draw_sprite_instances(int texture) final
+    {
+        flush_sprites();
+        return sprite_draw->draw(texture);
+    }
+    bool compute_supported() const final { return has_compute; }
     bool swap_buff() final
     {
-        SDL_GL_SwapWindow(window);
+        if (scene_target)
+        {
+            present_scene();
+        }
+        else if (bound_target)
+        {
+            set_render_target(nullptr);
+        }
+        if (overlay.visible())
+        {
+            draw_overlay();
+        }
+        flush_sprites();
+        sprite_vertices->end_region();
+        particle_draw->end_frame();
+        sprite_draw->end_frame();
+        if (captures)
+        {
+            captures->poll();
+            capture_queued();
+        }
+
+        if (window)
+        {
+            SDL_GL_SwapWindow(window);
+        }
+        gl_trace_frame();
 
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        OM_GL_CHECK()
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        OM_GL_CHECK()
+        const clock::time_point now = clock::now();
+        const float             frame_ms =
+            std::chrono::duration<float, std::milli>(now - last_present)
+                .count();
+        last_present   = now;
+        previous_stats = frame_render_stats();
+        frame_render_stats() = render_stats();
+        if (overlay.visible())
+        {
+            overlay.record(frame_ms,
+                           previous_stats,
+                           gpu_memory_bytes(),
+                           render_scale(),
+                           sprite_vertices->stats().overflows);
+        }
+        float gpu_ms = 0.f;
+        if (resolution && scene_timer->latest_ms(gpu_ms))
+        {
+            resolution->update(gpu_ms);
+        }
+
+        gl_check_end_frame(std::cerr);
+
+        OM_GL(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
+        OM_GL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+        transient.begin_frame();
+        target_pool.end_frame();
+        begin_sprite_frame();
+        particle_draw->begin_frame();
+        sprite_draw->begin_frame();
+        begin_scene();
+        const std::uint64_t allocations = heap_allocation_count();
+        frame_allocations               = allocations - allocations_at_swap;
+        allocations_at_swap             = allocations;
+        // the first frames stream chunks, compile shaders and grow caches,
+        // past them a steady frame must not touch the heap
+        if (++frames_presented > 60 &&
+            frame_allocations > worst_frame_allocations)
+        {
+            worst_frame             = frames_presented;
+            worst_frame_allocations = frame_allocations;
+        }
         return true;
     }
 };
@@ -236,7 +382,17 @@ bool engine_impl::rebind_key()
     binded_keys.erase(it);
     binded_keys.push_back(new_key);
 }
-bool engine_impl::initialize_engine()
+// right after glad loaded, before the engine makes its first GL call
+static void start_trace(const engine_config& config)
+{
+    if (!config.gl_trace.empty() &&
+        !start_gl_trace(config.gl_trace, eng::width, eng::height))
+    {
+        std::cerr << "can't write GL trace " << config.gl_trace << std::endl;
+    }
+}
+
+bool engine_impl::create_window(const engine_config& config)
 {
     if (SDL_Init(SDL_INIT_VIDEO))
     {
@@ -256,8 +412,11 @@ bool engine_impl::initialize_engine()
 
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
 
-    window =
-        SDL_CreateWindow("GLES3.2", eng::width, eng::height, SDL_WINDOW_OPENGL);
+    window = SDL_CreateWindow(
+        "GLES3.2",
+        eng::width,
+        eng::height,
+        SDL_WINDOW_OPENGL | (config.hidden_window ? SDL_WINDOW_HIDDEN : 0));
     if (!window)
     {
         SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR,
@@ -266,15 +425,6 @@ bool engine_impl::initialize_engine()
                                  NULL);
         return false;
     }
-    binded_keys = { { SDLK_w, "up", event::up },
-                    { SDLK_a, "left", event::left },
-                    { SDLK_s, "down", event::down },
-                    { SDLK_d, "right", event::right },
-                    { SDLK_LCTRL, "button_one", event::button_one },
-                    { SDLK_SPACE, "button_two", event::button_two },
-                    { SDLK_ESCAPE, "select", event::select },
-                    { SDLK_RETURN, "start", event::start } };
-
     context = SDL_GL_CreateContext(window);
     if (!context)
     {
@@ -296,6 +446,10 @@ bool engine_impl::initialize_engine()
             SDL_MESSAGEBOX_ERROR, "Error", "gl version lower then 3.", NULL);
         return false;
     }
+    if (!config.vsync)
+    {
+        SDL_GL_SetSwapInterval(0);
+    }
 
     auto load_gl_pointer = [](const char* function_name)
     {
@@ -307,63 +461,398 @@ bool engine_impl::initialize_engine()
     {
         std::clog << "error: failed to initialize glad" << std::endl;
     }
+    start_trace(config);
+    return true;
+}
+
+bool engine_impl::create_headless(const engine_config& config)
+{
+    // input still arrives through SDL events, which need no display
+    if (SDL_Init(SDL_INIT_EVENTS))
+    {
+        std::cerr << "Cannot init SDL events" << std::endl;
+        return false;
+    }
+    atexit(SDL_Quit);
+
+    headless = std::make_unique<headless_context>();
+    std::string error;
+    if (!headless->create(error))
+    {
+        std::cerr << "no headless context: " << error << std::endl;
+        return false;
+    }
+    if (gladLoadGLES2Loader(headless_context::get_proc_address) == 0)
+    {
+        std::clog << "error: failed to initialize glad" << std::endl;
+        return false;
+    }
+    start_trace(config);
+    // stands in for the window framebuffer everywhere the engine binds it
+    render_target_desc desc;
+    desc.size       = glm::ivec2(eng::width, eng::height);
+    desc.depth      = true;
+    headless_target = std::make_unique<render_target>(desc);
+    glBindFramebuffer(GL_FRAMEBUFFER, window_framebuffer());
+    OM_GL_CHECK(glBindFramebuffer)
+    return true;
+}
+
+bool engine_impl::initialize_engine(const engine_config& config)
+{
+    sprite_layout = config.sprite_layout;
+    upscale       = config.upscale;
+    // one quad at least so a fresh region always takes the quad that
+    // overflowed the previous one
+    sprite_quads_per_region =
+        std::max<std::size_t>(config.max_sprite_quads_per_frame, 1);
+
+    if (!(config.headless ? create_headless(config) : create_window(config)))
+    {
+        return false;
+    }
+
+    binded_keys = { { SDLK_w, "up", event::up },
+                    { SDLK_a, "left", event::left },
+                    { SDLK_s, "down", event::down },
+                    { SDLK_d, "right", event::right },
+                    { SDLK_LCTRL, "button_one", event::button_one },
+                    { SDLK_SPACE, "button_two", event::button_two },
+                    { SDLK_ESCAPE, "select", event::select },
+                    { SDLK_RETURN, "start", event::start } };
 
     glEnable(GL_DEBUG_OUTPUT);
-    OM_GL_CHECK()
+    OM_GL_CHECK(glEnable)
+#if defined(OPENGL_WINDOW_SYNC_GL_DEBUG)
     glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-    OM_GL_CHECK()
-    glDebugMessageCallback(callback_opengl_debug, nullptr);
-    OM_GL_CHECK()
+    OM_GL_CHECK(glEnable)
+#endif
+    glDebugMessageCallback(callback_opengl_debug, &gl_log);
+    OM_GL_CHECK(glDebugMessageCallback)
     glDebugMessageControl(
         GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
-    OM_GL_CHECK()
+    OM_GL_CHECK(glDebugMessageControl)
     glEnable(GL_BLEND);
-    OM_GL_CHECK();
+    OM_GL_CHECK(glEnable);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    OM_GL_CHECK();
-    glViewport(0, 0, width, height);
+    OM_GL_CHECK(glBlendFunc);
+
+    const char* sprite_defines =
+        sprite_layout == vertex_layout::compact ? "#define COMPACT_VERTEX\n"
+                                                : "";
+    sprite_shader = std::make_unique<Shader>(
+        "vertex.vert", "fragment.frag", sprite_defines);
+    text_shader =
+        std::make_unique<Shader>("vertex.vert", "text.frag", sprite_defines);
+
+    glGenBuffers(1, &camera_ubo);
+    OM_GL_CHECK(glGenBuffers)
+    glBindBuffer(GL_UNIFORM_BUFFER, camera_ubo);
+    glBufferData(
+        GL_UNIFORM_BUFFER, sizeof(camera_block), nullptr, GL_DYNAMIC_DRAW);
+    OM_GL_CHECK(glBufferData)
+    set_camera(camera());
+    create_sprite_pipeline();
+    particle_draw =
+        std::make_unique<particle_renderer>(config.max_particles_per_frame);
+    sprite_draw =
+        std::make_unique<sprite_renderer>(config.max_sprites_per_frame);
+
+    // SDL may hand out a lower version than asked for
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    GLint invocations = 0;
+    if (major > 3 || (major == 3 && minor >= 1))
+    {
+        glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &invocations);
+    }
+    // the particle passes run 64 wide groups
+    has_compute = invocations >= 64;
+    OM_GL_CHECK(glGetIntegerv)
+
+    if (config.dynamic_resolution)
+    {
+        scene_timer = std::make_unique<gpu_timer>();
+    }
+    // the present to present time is no stand-in for the GPU time, with
+    // vsync it never drops under the refresh interval
+    if (scene_timer && !scene_timer->supported())
+    {
+        std::clog << "no GL_EXT_disjoint_timer_query, dynamic resolution off"
+                  << std::endl;
+        scene_timer.reset();
+    }
+    if (scene_timer)
+    {
+        resolution = std::make_unique<resolution_controller>(
+            config.target_gpu_ms, config.min_render_scale);
+        upscale_shader = std::make_unique<Shader>(
+            "upscale.vert",
+            "upscale.frag",
+            upscale == upscale_filter::sharpen ? "#define SHARPEN\n" : "");
+        // attributeless draw, GLES still wants a vertex array bound
+        glGenVertexArrays(1, &upscale_vao);
+        OM_GL_CHECK(glGenVertexArrays)
+        begin_scene();
+    }
     return true;
 }
-int engine_impl::load_texture(std::string path)
+void engine_impl::set_camera(const camera& c)
 {
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data =
-        stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
+    // sprites recorded so far were meant for the previous camera
+    flush_sprites();
+    current_camera = c;
 
-    unsigned int texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glm::ivec4 vp = c.pixel_viewport();
+    if (bound_target)
+    {
+        // same part of the target as of the window
+        const glm::ivec2 size = bound_target->size();
+        vp = glm::ivec4(vp.x * size.x / eng::width,
+                        vp.y * size.y / eng::height,
+                        vp.z * size.x / eng::width,
+                        vp.w * size.y / eng::height);
+    }
+    camera_block     block;
+    block.view_projection = c.view_projection();
+    block.viewport        = glm::vec4(static_cast<float>(vp.x),
+                               static_cast<float>(vp.y),
+                               static_cast<float>(vp.z),
+                               static_cast<float>(vp.w));
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindBuffer(GL_UNIFORM_BUFFER, camera_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+    OM_GL_CHECK(glBufferSubData)
+    glBindBufferBase(GL_UNIFORM_BUFFER, camera_block_binding, camera_ubo);
+    OM_GL_CHECK(glBindBufferBase)
+    glViewport(vp.x, vp.y, vp.z, vp.w);
+    OM_GL_CHECK(glViewport)
+}
+void engine_impl::set_render_target(const render_target* target)
+{
+    // recorded sprites belong to the previous target
+    flush_sprites();
+    bound_target = target ? target : scene_target;
+    target       = bound_target;
+    OM_GL(glBindFramebuffer(
+        GL_FRAMEBUFFER, target ? target->framebuffer() : window_framebuffer()));
+    set_camera(current_camera);
+}
+void engine_impl::begin_scene()
+{
+    if (!resolution)
+    {
+        return;
+    }
+    const float        scale = resolution->scale();
+    render_target_desc desc;
+    desc.size = glm::ivec2(static_cast<int>(eng::width * scale + 0.5f),
+                           static_cast<int>(eng::height * scale + 0.5f));
+    scene_target = &target_pool.acquire(desc);
+    set_render_target(nullptr);
+    clear(glm::vec4(0.f, 0.f, 0.f, 0.f));
+    scene_timer->begin();
+}
+void engine_impl::present_scene()
+{
+    flush_sprites();
+    scene_timer->end();
+    const render_target* scene = scene_target;
+    scene_target               = nullptr;
+    set_render_target(nullptr);
 
-    if (data)
+    // opaque copy, the scene already holds the blended result
+    glDisable(GL_BLEND);
+    upscale_shader->use();
+    upscale_shader->setInt("scene", 0);
+    upscale_shader->setFloat("sharpness", 0.5f);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene->color_texture());
+    glBindVertexArray(upscale_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    OM_GL_CHECK(glDrawArrays)
+    glBindVertexArray(0);
+    glEnable(GL_BLEND);
+    count_texture_bind();
+    count_draw(1);
+}
+void engine_impl::clear(glm::vec4 color)
+{
+    flush_sprites();
+    glClearColor(color.x, color.y, color.z, color.w);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    OM_GL_CHECK(glClear)
+}
+struct texture_format
+{
+    GLenum internal_format;
+    GLenum format;
+    GLint  swizzle[4];
+};
+// stb returns grey, grey+alpha, rgb or rgba depending on the file, pick the
+// smallest sized format that holds it and swizzle grey back to rgb in the
+// sampler so shaders keep reading .rgba. srgb only applies to rgb and rgba,
+// GLES has no sRGB R8 or RG8 so grey images are always stored linear
+static bool texture_format_from_channels(int             channels,
+                                         bool            srgb,
+                                         texture_format& out)
+{
+    switch (channels)
     {
-        glTexImage2D(GL_TEXTURE_2D,
-                     0,
-                     GL_RGBA,
-                     width,
-                     height,
-                     0,
-                     GL_RGBA,
-                     GL_UNSIGNED_BYTE,
-                     data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        case 1:
+            out = { GL_R8, GL_RED, { GL_RED, GL_RED, GL_RED, GL_ONE } };
+            return true;
+        case 2:
+            out = { GL_RG8, GL_RG, { GL_RED, GL_RED, GL_RED, GL_GREEN } };
+            return true;
+        case 3:
+            out = { static_cast<GLenum>(srgb ? GL_SRGB8 : GL_RGB8),
+                    GL_RGB,
+                    { GL_RED, GL_GREEN, GL_BLUE, GL_ONE } };
+            return true;
+        case 4:
+            out = { static_cast<GLenum>(srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8),
+                    GL_RGBA,
+                    { GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA } };
+            return true;
     }
-    else
+    return false;
+}
+struct decoded_image
+{
+    unsigned char* data = nullptr;
+    int            width;
+    int            height;
+    int            nrChannels;
+};
+// safe to call from several threads at once, the vertical flip flag is
+// global in stb and must be set beforehand
+static decoded_image decode_image(const std::string& path)
+{
+    decoded_image img;
+    img.data = stbi_load(
+        path.c_str(), &img.width, &img.height, &img.nrChannels, 0);
+    return img;
+}
+int engine_impl::load_texture(std::string path, bool srgb)
+{
+    stbi_set_flip_vertically_on_load(true);
+    return upload_texture(decode_image(path), path, srgb);
+}
+std::vector<int> engine_impl::load_textures(
+    const std::vector<std::string>& paths, bool srgb)
+{
+    stbi_set_flip_vertically_on_load(true);
+    std::vector<decoded_image> images(paths.size());
+    job_pool.parallel_for(0,
+                          paths.size(),
+                          1,
+                          [&](std::size_t begin, std::size_t end)
+                          {
+                              for (std::size_t i = begin; i < end; ++i)
+                              {
+                                  images[i] = decode_image(paths[i]);
+                              }
+                          });
+    // GL calls stay on the thread that owns the context
+    std::vector<int> textures(paths.size());
+    for (std::size_t i = 0; i < paths.size(); ++i)
+    {
+        textures[i] = upload_texture(images[i], paths[i], srgb);
+    }
+    return textures;
+}
+int engine_impl::upload_texture(const decoded_image& img,
+                                const std::string&   path,
+                                bool                 srgb)
+{
+    unsigned char* data       = img.data;
+    const int      width      = img.width;
+    const int      height     = img.height;
+    const int      nrChannels = img.nrChannels;
+    if (!data)
     {
-        std::cout << "Failed to load texture" << std::endl;
+        std::cout << "Failed to load texture " << path << std::endl;
         return false;
     }
+    texture_format fmt;
+    if (!texture_format_from_channels(nrChannels, srgb, fmt))
+    {
+        std::cout << "Unsupported channel count " << nrChannels << " in "
+                  << path << std::endl;
+        stbi_image_free(data);
+        return false;
+    }
+
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    OM_GL_CHECK(glGenTextures)
+    glBindTexture(GL_TEXTURE_2D, texture);
+    OM_GL_CHECK(glBindTexture)
+    // sampled with GL_NEAREST and no mipmaps, so one immutable level is all
+    // the storage the texture ever needs
+    glTexStorage2D(GL_TEXTURE_2D, 1, fmt.internal_format, width, height);
+    OM_GL_CHECK(glTexStorage2D)
+    // drivers usually pad rgb texels to four bytes
+    const std::int64_t bytes = static_cast<std::int64_t>(width) * height *
+                               (nrChannels == 3 ? 4 : nrChannels);
+    gpu_memory_bytes() += bytes;
+    texture_bytes[static_cast<int>(texture)] = bytes;
+
+    // stb rows are tightly packed, a row of an rgb or grey image is not
+    // necessarily a multiple of the default 4 byte alignment
+    const int row_bytes = width * nrChannels;
+    glPixelStorei(GL_UNPACK_ALIGNMENT,
+                  row_bytes % 4 == 0   ? 4
+                  : row_bytes % 2 == 0 ? 2
+                                       : 1);
+    OM_GL_CHECK(glPixelStorei)
+    glTexSubImage2D(GL_TEXTURE_2D,
+                    0,
+                    0,
+                    0,
+                    width,
+                    height,
+                    fmt.format,
+                    GL_UNSIGNED_BYTE,
+                    data);
+    OM_GL_CHECK(glTexSubImage2D)
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    OM_GL_CHECK(glPixelStorei)
+    stbi_image_free(data);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, fmt.swizzle[0]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, fmt.swizzle[1]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, fmt.swizzle[2]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, fmt.swizzle[3]);
+    OM_GL_CHECK(glTexParameteri)
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    OM_GL_CHECK(glTexParameteri)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    OM_GL_CHECK()
+    OM_GL_CHECK(glTexParameteri)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    OM_GL_CHECK()
-    stbi_image_free(data);
+    OM_GL_CHECK(glTexParameteri)
     return texture;
 }
 
+void engine_impl::unload_texture(int texture)
+{
+    const auto it = texture_bytes.find(texture);
+    if (it == texture_bytes.end())
+    {
+        return;
+    }
+    // recorded sprites may still sample it
+    flush_sprites();
+    const GLuint name = static_cast<GLuint>(texture);
+    glDeleteTextures(1, &name);
+    OM_GL_CHECK(glDeleteTextures)
+    gpu_memory_bytes() -= it->second;
+    texture_bytes.erase(it);
+}
+
 void engine_impl::draw_triangle(eng::triangle t1, eng::triangle t2)
 {
     Shader s("/home/apachai/CLionProjects/opengl_window/vertex.vert",
@@ -399,72 +888,461 @@ void engine_impl::draw_triangle(eng::triangle t1, eng::triangle t2)
     glUniform1f(vertexTimeLocation, 3.14159 * time / 8);
     glUniform2f(vertexColorLocation, eng::width, eng::height);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
-    OM_GL_CHECK()
+    OM_GL_CHECK(glDrawElements)
 }
 bool engine_impl::draw_texture(eng::triangle t1,
                                eng::triangle t2,
                                int           texHandle,
                                glm::mat4     transform)
 {
-
-    Shader s("vertex.vert", "fragment.frag");
-
+    // positions are transformed here so sprites with different transforms
+    // still share one draw call
     eng::vertex vertices[] = {
         t1.v[0],
         t1.v[1],
         t1.v[2],
         t2.v[0],
     };
-    unsigned int indices[] = {
-        0, 1, 3, // first triangle
-        1, 2, 3  // second triangle
+    for (eng::vertex& v : vertices)
+    {
+        const glm::vec4 p = transform * glm::vec4(v.x, v.y, v.z, 1.0f);
+        v.x               = p.x;
+        v.y               = p.y;
+        v.z               = p.z;
+    }
+    return push_sprite_quad(vertices, texHandle, false);
+}
+bool engine_impl::push_sprite_quad(const eng::vertex (&vertices)[4],
+                                   int                 texture,
+                                   bool                text)
+{
+    const std::size_t quad_bytes = 4 * sprite_vertex_size;
+    std::size_t       offset;
+    void*             dst =
+        sprite_vertices->allocate(quad_bytes, sprite_vertex_size, offset);
+    if (!dst)
+    {
+        // region full: draw what it holds and continue in the next one
+        flush_sprites();
+        sprite_vertices->begin_region();
+        dst = sprite_vertices->allocate(quad_bytes, sprite_vertex_size, offset);
+        if (!dst)
+        {
+            return false;
+        }
+    }
+
+    if (sprite_layout == vertex_layout::compact)
+    {
+        compact_vertex packed[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            const eng::vertex& v = vertices[i];
+            packed[i]            = { v.x,
+                                     v.y,
+                                     float_to_half(v.tx),
+                                     float_to_half(v.ty),
+                                     float_to_unorm8(v.r),
+                                     float_to_unorm8(v.g),
+                                     float_to_unorm8(v.b),
+                                     255 };
+        }
+        std::memcpy(dst, packed, sizeof(packed));
+    }
+    else
+    {
+        std::memcpy(dst, vertices, sizeof(vertices));
+    }
+
+    const GLint first_vertex = static_cast<GLint>(offset / sprite_vertex_size);
+    if (sprite_batch_count != 0)
+    {
+        sprite_batch& last = sprite_batches[sprite_batch_count - 1];
+        if (last.texture == texture && last.text == text &&
+            last.first_vertex + last.quads * 4 == first_vertex &&
+            last.quads < max_quads_per_draw)
+        {
+            ++last.quads;
+            return true;
+        }
+    }
+    sprite_batches[sprite_batch_count++] = { texture, text, first_vertex, 1 };
+    return true;
+}
+int engine_impl::load_font(const std::string& ttf_path, float pixel_height)
+{
+    loaded_font font;
+    if (ttf_path.empty() ||
+        !load_font_atlas(ttf_path, pixel_height, font.atlas))
+    {
+        if (!ttf_path.empty())
+        {
+            std::clog << "could not load font " << ttf_path
+                      << ", using the built-in one" << std::endl;
+        }
+        builtin_font_atlas(font.atlas);
+    }
+    const font_atlas& atlas = font.atlas;
+
+    glGenTextures(1, &font.texture);
+    glBindTexture(GL_TEXTURE_2D, font.texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, atlas.width, atlas.height);
+    gpu_memory_bytes() += static_cast<std::int64_t>(atlas.width) * atlas.height;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D,
+                    0,
+                    0,
+                    0,
+                    atlas.width,
+                    atlas.height,
+                    GL_RED,
+                    GL_UNSIGNED_BYTE,
+                    atlas.pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    // the field is only meaningful interpolated
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    OM_GL_CHECK(glTexParameteri)
+
+    font.atlas.pixels = std::vector<std::uint8_t>();
+    fonts.push_back(std::move(font));
+    return static_cast<int>(fonts.size());
+}
+bool engine_impl::draw_text(int              font,
+                            std::string_view text,
+                            glm::vec2        top_left,
+                            float            line_height,
+                            glm::vec3        color)
+{
+    if (font < 1 || font > static_cast<int>(fonts.size()))
+    {
+        return false;
+    }
+    const loaded_font& f = fonts[font - 1];
+    // quads come in ems, an em is the requested line height
+    const float scale = line_height / f.atlas.line_height;
+    for (const glyph_quad& q : text_layouts.layout(font, f.atlas, text))
+    {
+        const float x0 = top_left.x + q.x0 * scale;
+        const float x1 = top_left.x + q.x1 * scale;
+        const float y0 = top_left.y + q.y0 * scale;
+        const float y1 = top_left.y + q.y1 * scale;
+        // same corner order as the sprite quads: top right, bottom right,
+        // bottom left, top left
+        const eng::vertex quad[4] = {
+            { x1, y1, 0.f, color.x, color.y, color.z, q.u1, q.v0 },
+            { x1, y0, 0.f, color.x, color.y, color.z, q.u1, q.v1 },
+            { x0, y0, 0.f, color.x, color.y, color.z, q.u0, q.v1 },
+            { x0, y1, 0.f, color.x, color.y, color.z, q.u0, q.v0 },
+        };
+        if (!push_sprite_quad(quad, static_cast<int>(f.texture), true))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+void engine_impl::push_solid_quad(const loaded_font& f,
+                                  glm::vec2          min,
+                                  glm::vec2          max,
+                                  glm::vec3          color)
+{
+    const float       u = f.atlas.solid_u;
+    const float       v = f.atlas.solid_v;
+    const eng::vertex quad[4] = {
+        { max.x, max.y, 0.f, color.x, color.y, color.z, u, v },
+        { max.x, min.y, 0.f, color.x, color.y, color.z, u, v },
+        { min.x, min.y, 0.f, color.x, color.y, color.z, u, v },
+        { min.x, max.y, 0.f, color.x, color.y, color.z, u, v },
     };
-    unsigned int VBO, VAO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    push_sprite_quad(quad, static_cast<int>(f.texture), true);
+}
+void engine_impl::capture_frame(frame_capture::consumer fn)
+{
+    if (!captures)
+    {
+        captures = std::make_unique<frame_capture>(
+            job_pool, glm::ivec2(eng::width, eng::height));
+    }
+    queued_captures.push_back(std::move(fn));
+}
 
-    glBindVertexArray(VAO);
+bool engine_impl::start_recording(const recording_config& config)
+{
+    stop_recording();
+    auto r = std::make_unique<frame_recorder>(
+        config, glm::ivec2(eng::width, eng::height));
+    if (!r->good())
+    {
+        std::cerr << "can't record to " << config.path << std::endl;
+        return false;
+    }
+    if (!captures)
+    {
+        captures = std::make_unique<frame_capture>(
+            job_pool, glm::ivec2(eng::width, eng::height));
+    }
+    recorder = std::move(r);
+    return true;
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+recording_stats engine_impl::stop_recording()
+{
+    if (!recorder)
+    {
+        return recording_stats();
+    }
+    // jobs still reading into the recorder must be done before it closes
+    captures->finish();
+    const recording_stats stats = recorder->close();
+    recorder.reset();
+    return stats;
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+void engine_impl::save_screenshot(const std::string& path)
+{
+    capture_frame(
+        [path](const captured_image& image)
+        {
+            // rows arrive bottom up, a negative stride writes them flipped
+            const std::ptrdiff_t row =
+                static_cast<std::ptrdiff_t>(image.width) * 4;
+            if (!write_png(path,
+                           image.width,
+                           image.height,
+                           image.pixels + row * (image.height - 1),
+                           -row))
+            {
+                std::cerr << "can't write screenshot " << path << std::endl;
+            }
+        });
+}
 
-    // position attribute
-    glVertexAttribPointer(
-        0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+void engine_impl::capture_queued()
+{
+    // the window framebuffer holds the finished frame at this point
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, window_framebuffer());
+    const glm::ivec4 window_rect(0, 0, eng::width, eng::height);
+    if (recorder && recorder->wants(frames_presented))
+    {
+        frame_recorder* r = recorder.get();
+        if (!captures->capture(window_rect,
+                               frames_presented,
+                               [r](const captured_image& image)
+                               { r->submit(image); }))
+        {
+            recorder->note_readback_drop();
+        }
+    }
+    for (frame_capture::consumer& fn : queued_captures)
+    {
+        if (!captures->capture(window_rect, frames_presented, std::move(fn)))
+        {
+            std::cerr << "frame " << frames_presented
+                      << " not captured, every readback slot is busy"
+                      << std::endl;
+        }
+    }
+    queued_captures.clear();
+}
+
+void engine_impl::draw_overlay()
+{
+    if (overlay_font == 0)
+    {
+        overlay_font = load_font("", 48.f);
+    }
+    const loaded_font& f = fonts[overlay_font - 1];
+
+    // one world unit per pixel with y up, the game's camera comes back after
+    const camera game_camera = current_camera;
+    camera       screen;
+    screen.extent   = glm::vec2(eng::width, eng::height);
+    screen.position = screen.extent * 0.5f;
+    set_camera(screen);
+
+    constexpr float margin      = 8.f;
+    constexpr float line        = 16.f;
+    constexpr float bar_width   = 3.f;
+    constexpr float graph_h     = 60.f;
+    constexpr float graph_ms    = 100.f / 3.f; // full height, 30 fps
+    constexpr float panel_w     = perf_overlay::graph_bars * bar_width;
+    const float     top         = eng::height - margin;
+    const float     graph_top   = top - 4 * line - margin;
+    const float     graph_floor = graph_top - graph_h;
+
+    push_solid_quad(f,
+                    glm::vec2(0.f, graph_floor - margin),
+                    glm::vec2(panel_w + 2 * margin, eng::height),
+                    glm::vec3(0.1f, 0.1f, 0.1f));
+    draw_text(overlay_font,
+              overlay.text(),
+              glm::vec2(margin, top),
+              line,
+              glm::vec3(1.f, 1.f, 1.f));
+
+    // green within 60 fps, yellow within 30 fps, red beyond
+    const std::size_t bars = overlay.graph_size();
+    for (std::size_t i = 0; i < bars; ++i)
+    {
+        const float     ms    = overlay.graph_value(i);
+        const float     h     = std::min(ms / graph_ms, 1.f) * graph_h;
+        const float     x     = margin + i * bar_width;
+        const glm::vec3 color = ms <= 1000.f / 60.f
+                                    ? glm::vec3(0.2f, 0.8f, 0.2f)
+                                : ms <= graph_ms ? glm::vec3(0.9f, 0.8f, 0.2f)
+                                                 : glm::vec3(0.9f, 0.2f, 0.2f);
+        push_solid_quad(f,
+                        glm::vec2(x, graph_floor),
+                        glm::vec2(x + bar_width - 1.f, graph_floor + h),
+                        color);
+    }
+    // 16.7 ms line
+    const float target = graph_floor + graph_h * (1000.f / 60.f) / graph_ms;
+    push_solid_quad(f,
+                    glm::vec2(margin, target),
+                    glm::vec2(margin + panel_w, target + 1.f),
+                    glm::vec3(0.6f, 0.6f, 0.6f));
+
+    set_camera(game_camera);
+}
+void engine_impl::flush_sprites()
+{
+    if (sprite_batch_count == 0)
+    {
+        return;
+    }
+    sprite_vertices->unmap();
+
+    for (const Shader* s : { sprite_shader.get(), text_shader.get() })
+    {
+        s->use();
+        s->setInt("ourTexture", 0);
+        s->setMat4("transform", glm::mat4(1.0f));
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(sprite_vao);
+    OM_GL_CHECK(glBindVertexArray)
+    GLuint bound_texture = 0;
+    bool   text_program  = true; // the last one used above
+    for (int i = 0; i < sprite_batch_count; ++i)
+    {
+        const sprite_batch& b = sprite_batches[i];
+        if (b.text != text_program)
+        {
+            text_program = b.text;
+            (text_program ? text_shader : sprite_shader)->use();
+        }
+        if (static_cast<GLuint>(b.texture) != bound_texture)
+        {
+            bound_texture = static_cast<GLuint>(b.texture);
+            glBindTexture(GL_TEXTURE_2D, bound_texture);
+            count_texture_bind();
+        }
+        glDrawElementsBaseVertex(GL_TRIANGLES,
+                                 b.quads * 6,
+                                 GL_UNSIGNED_SHORT,
+                                 nullptr,
+                                 b.first_vertex);
+        OM_GL_CHECK(glDrawElementsBaseVertex)
+        count_draw(static_cast<std::uint64_t>(b.quads) * 2);
+    }
+    glBindVertexArray(0);
+    sprite_batch_count = 0;
+}
+void engine_impl::begin_sprite_frame()
+{
+    sprite_vertices->begin_region();
+    // a batch per quad is the worst case one region can hold
+    sprite_batches =
+        transient.allocate_array<sprite_batch>(sprite_quads_per_region);
+    sprite_batch_count = 0;
+}
+void engine_impl::create_sprite_pipeline()
+{
+    sprite_vertex_size = sprite_layout == vertex_layout::compact
+                             ? sizeof(compact_vertex)
+                             : sizeof(eng::vertex);
+    sprite_vertices    = std::make_unique<vertex_ring>(
+        GL_ARRAY_BUFFER, sprite_quads_per_region * 4 * sprite_vertex_size);
+
+    // quads share vertices like the original two triangle layout:
+    // 0 1 3 and 1 2 3, with 16 bit indices covering a whole region
+    std::vector<std::uint16_t> indices;
+    indices.reserve(max_quads_per_draw * 6);
+    for (int q = 0; q < max_quads_per_draw; ++q)
+    {
+        const std::uint16_t base = static_cast<std::uint16_t>(q * 4);
+        for (std::uint16_t i : { 0, 1, 3, 1, 2, 3 })
+        {
+            indices.push_back(base + i);
+        }
+    }
+
+    glGenVertexArrays(1, &sprite_vao);
+    glGenBuffers(1, &sprite_ebo);
+    glBindVertexArray(sprite_vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sprite_ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 indices.size() * sizeof(std::uint16_t),
+                 indices.data(),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, sprite_vertices->buffer());
+    if (sprite_layout == vertex_layout::compact)
+    {
+        const GLsizei stride = sizeof(compact_vertex);
+        // position attribute
+        glVertexAttribPointer(0,
+                              2,
+                              GL_FLOAT,
+                              GL_FALSE,
+                              stride,
+                              (void*)offsetof(compact_vertex, x));
+        // color attribute
+        glVertexAttribPointer(1,
+                              4,
+                              GL_UNSIGNED_BYTE,
+                              GL_TRUE,
+                              stride,
+                              (void*)offsetof(compact_vertex, r));
+        // texture coord attribute
+        glVertexAttribPointer(2,
+                              2,
+                              GL_HALF_FLOAT,
+                              GL_FALSE,
+                              stride,
+                              (void*)offsetof(compact_vertex, tx));
+    }
+    else
+    {
+        // position attribute
+        glVertexAttribPointer(
+            0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        // color attribute
+        glVertexAttribPointer(1,
+                              3,
+                              GL_FLOAT,
+                              GL_FALSE,
+                              8 * sizeof(float),
+                              (void*)(3 * sizeof(float)));
+        // texture coord attribute
+        glVertexAttribPointer(2,
+                              2,
+                              GL_FLOAT,
+                              GL_FALSE,
+                              8 * sizeof(float),
+                              (void*)(6 * sizeof(float)));
+    }
     glEnableVertexAttribArray(0);
-    // color attribute
-    glVertexAttribPointer(1,
-                          3,
-                          GL_FLOAT,
-                          GL_FALSE,
-                          8 * sizeof(float),
-                          (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
-    // texture coord attribute
-    glVertexAttribPointer(2,
-                          2,
-                          GL_FLOAT,
-                          GL_FALSE,
-                          8 * sizeof(float),
-                          (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
-    s.use();
+    glBindVertexArray(0);
+    OM_GL_CHECK(glBindVertexArray)
 
-    glBindTexture(GL_TEXTURE_2D, texHandle);
-    glActiveTexture(GL_TEXTURE0);
-    s.setInt("ourTexture", 0);
-    s.setMat4("transform", transform);
-    OM_GL_CHECK()
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
-    return true;
+    begin_sprite_frame();
 }
 
 engine* create_engine()
@@ -513,6 +1391,10 @@ bool engine_impl::get_input(eng::event& e)
                 return true;
             }
             e = it->get_event();
+            if (e == event::select)
+            {
+                overlay.toggle();
+            }
             std::cout << it->get_name() << " Key Down" << std::endl;
             return true;
         }
@@ -534,70 +1416,6 @@ bool engine_impl::get_input(eng::event& e)
     }
     return false;
 }
-static const char* source_to_strv(GLenum source)
-{
-    switch (source)
-    {
-        case GL_DEBUG_SOURCE_API:
-            return "API";
-        case GL_DEBUG_SOURCE_SHADER_COMPILER:
-            return "SHADER_COMPILER";
-        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
-            return "WINDOW_SYSTEM";
-        case GL_DEBUG_SOURCE_THIRD_PARTY:
-            return "THIRD_PARTY";
-        case GL_DEBUG_SOURCE_APPLICATION:
-            return "APPLICATION";
-        case GL_DEBUG_SOURCE_OTHER:
-            return "OTHER";
-    }
-    return "unknown";
-}
-
-static const char* type_to_strv(GLenum type)
-{
-    switch (type)
-    {
-        case GL_DEBUG_TYPE_ERROR:
-            return "ERROR";
-        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
-            return "DEPRECATED_BEHAVIOR";
-        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
-            return "UNDEFINED_BEHAVIOR";
-        case GL_DEBUG_TYPE_PERFORMANCE:
-            return "PERFORMANCE";
-        case GL_DEBUG_TYPE_PORTABILITY:
-            return "PORTABILITY";
-        case GL_DEBUG_TYPE_MARKER:
-            return "MARKER";
-        case GL_DEBUG_TYPE_PUSH_GROUP:
-            return "PUSH_GROUP";
-        case GL_DEBUG_TYPE_POP_GROUP:
-            return "POP_GROUP";
-        case GL_DEBUG_TYPE_OTHER:
-            return "OTHER";
-    }
-    return "unknown";
-}
-
-static const char* severity_to_strv(GLenum severity)
-{
-    switch (severity)
-    {
-        case GL_DEBUG_SEVERITY_HIGH:
-            return "HIGH";
-        case GL_DEBUG_SEVERITY_MEDIUM:
-            return "MEDIUM";
-        case GL_DEBUG_SEVERITY_LOW:
-            return "LOW";
-        case GL_DEBUG_SEVERITY_NOTIFICATION:
-            return "NOTIFICATION";
-    }
-    return "unknown";
-}
-
-static std::array<char, GL_MAX_DEBUG_MESSAGE_LENGTH> local_log_buff;
-
 static void APIENTRY
 callback_opengl_debug(GLenum                       source,
                       GLenum                       type,
@@ -607,21 +1425,17 @@ callback_opengl_debug(GLenum                       source,
                       const GLchar*                message,
                       [[maybe_unused]] const void* userParam)
 {
-    auto& buff{ local_log_buff };
-    int   num_chars = std::snprintf(buff.data(),
-                                  buff.size(),
-                                  "%s %s %d %s %.*s\n",
-                                  source_to_strv(source),
-                                  type_to_strv(type),
-                                  id,
-                                  severity_to_strv(severity),
-                                  length,
-                                  message);
-
-    if (num_chars > 0)
-    {
-
-        std::cerr.write(buff.data(), num_chars);
-    }
+#if defined(OPENGL_WINDOW_SYNC_GL_DEBUG)
+    // written inside the GL call that caused it, a breakpoint here shows
+    // the culprit on the stack
+    debug_record r;
+    debug_log::fill(r, source, type, id, severity, length, message);
+    char line[512];
+    std::cerr.write(line, debug_log::format(r, line, sizeof(line)));
+#else
+    // may be a driver thread, the log never blocks it
+    static_cast<debug_log*>(const_cast<void*>(userParam))
+        ->push(source, type, id, severity, length, message);
+#endif
 }
 } // namespace eng
\ No newline at end of file
@@ -1,14 +1,32 @@
 #ifndef OPENGL_WINDOW_ENGINE_HXX
 #define OPENGL_WINDOW_ENGINE_HXX
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iosfwd>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "camera.hxx"
+#include "frame_arena.hxx"
+#include "frame_recorder.hxx"
+#include "job_system.hxx"
+#include "render_stats.hxx"
+#include "render_target.hxx"
+
 namespace eng
 {
+struct captured_image;
+struct sprite_instance;
+class gpu_particle_system;
+class particle_emitter;
+
 constexpr int width  = 1200;
 constexpr int height = 920;
 enum class event
@@ -24,6 +42,54 @@ enum class event
     exit
 };
 
+// vertex format of the sprite stream behind draw_texture
+enum class vertex_layout
+{
+    full,   // eng::vertex as is, 32 bytes
+    compact // float2 position, half2 texcoord, unorm8x4 colour, 16 bytes
+};
+
+// filter that scales a dynamic resolution frame up to the window
+enum class upscale_filter
+{
+    bilinear,
+    sharpen // bilinear plus a contrast limited unsharp mask
+};
+
+struct engine_config
+{
+    vertex_layout sprite_layout = vertex_layout::compact;
+    // draw the frame into an offscreen target whose size follows the GPU
+    // time of the previous frames, then scale it up to the window. Ignored
+    // when the context can't time the GPU (GL_EXT_disjoint_timer_query)
+    bool           dynamic_resolution = false;
+    float          target_gpu_ms      = 14.f; // leaves room under 60 fps
+    float          min_render_scale   = 0.5f; // per axis
+    upscale_filter upscale            = upscale_filter::sharpen;
+    // a hidden window still gets a context, for tools that only render
+    // offscreen or read frames back
+    bool hidden_window = false;
+    // false presents as fast as the GPU allows, for benchmarks
+    bool vsync = true;
+    // no window at all: an EGL context, software rendered on Mesa's
+    // llvmpipe when there is no GPU, draws into an offscreen framebuffer
+    // that capture_frame reads. Input only arrives through pushed SDL events
+    bool headless = false;
+    // writes every GL call from context creation on to this file for
+    // gl_replay, empty traces nothing
+    std::string gl_trace;
+    // particles draw_particles streams per frame over all emitters, the
+    // ring holds 16 bytes each for every frame in flight
+    std::size_t max_particles_per_frame = 1 << 16;
+    // instances map_sprite_instances hands out per frame, the ring holds 40
+    // bytes each for every frame in flight
+    std::size_t max_sprites_per_frame = 1 << 14;
+    // quads draw_texture and draw_text record per frame, the ring holds
+    // four vertices each for every frame in flight. A frame past it draws
+    // early and may wait on the fence of the next region
+    std::size_t max_sprite_quads_per_frame = 1 << 14;
+};
+
 struct vertex
 {
     float x = 0.f; // vertex position
@@ -58,16 +124,110 @@ struct triangle
 class engine
 {
 public:
-    virtual bool initialize_engine()                     = 0;
+    virtual ~engine() = default;
+    // config is read once, the sprite layout is fixed afterwards
+    virtual bool initialize_engine(const engine_config& config) = 0;
+    bool initialize_engine() { return initialize_engine(engine_config()); }
+
     virtual bool get_input(event& e)                     = 0;
     virtual bool rebind_key()                            = 0;
     virtual void draw_triangle(triangle t1, triangle t2) = 0;
     virtual bool swap_buff()                             = 0;
-    virtual int  load_texture(std::string path)          = 0;
+    // srgb: rgb and rgba textures are stored as sRGB and linearized on
+    // sampling. Grey and grey+alpha images stay linear, GLES has no sRGB
+    // format of one or two channels
+    virtual int load_texture(std::string path, bool srgb) = 0;
+    int         load_texture(std::string path)
+    {
+        return load_texture(std::move(path), false);
+    }
+    // decodes the images in parallel on the job system, then uploads them
+    virtual std::vector<int> load_textures(
+        const std::vector<std::string>& paths, bool srgb) = 0;
+    std::vector<int> load_textures(const std::vector<std::string>& paths)
+    {
+        return load_textures(paths, false);
+    }
+    // frees a texture of load_texture or load_textures, sprites recorded
+    // with it are drawn first. Other handles are ignored
+    virtual void unload_texture(int texture) = 0;
+    // transform is the model matrix, view and projection come from the
+    // camera set for the frame. The quad is recorded, not drawn: sprites are
+    // drawn in submission order by flush_sprites, set_camera or swap_buff
     virtual bool draw_texture(triangle  t1,
                               triangle  t2,
                               int       texHandle,
-                              glm::mat4 transform)       = 0;
+                              glm::mat4 transform)                 = 0;
+    // one instanced draw, returns the number of particles drawn
+    virtual std::size_t draw_particles(const particle_emitter& emitter) = 0;
+    // indirect draw of a GPU simulated system, only when compute_supported
+    virtual void draw_particles(gpu_particle_system& particles) = 0;
+    // reserves n sprites of the instanced stream, every one has to be
+    // written before draw_sprite_instances. Null when the frame's stream is
+    // full. Animated sprites get their uv from sprite_animator::write_uvs
+    virtual sprite_instance* map_sprite_instances(std::size_t n) = 0;
+    // one instanced draw of the sprites mapped last, all from texture or
+    // plain white for texture 0, returns how many were drawn
+    virtual std::size_t draw_sprite_instances(int texture) = 0;
+    // true when the context runs compute shaders (GLES 3.1 and up)
+    virtual bool compute_supported() const = 0;
+    // builds a signed distance field atlas from a TrueType file, an empty
+    // path or a font that fails to load gives the built-in 5x7 font.
+    // Returns the font handle for draw_text
+    virtual int load_font(const std::string& ttf_path, float pixel_height) = 0;
+    int         load_font(const std::string& ttf_path)
+    {
+        return load_font(ttf_path, 48.f);
+    }
+    // records text like draw_texture records sprites, top_left and
+    // line_height are in world units of the current camera
+    virtual bool draw_text(int              font,
+                           std::string_view text,
+                           glm::vec2        top_left,
+                           float            line_height,
+                           glm::vec3        color) = 0;
+    // call before drawing with GL directly so recorded sprites stay behind
+    virtual void flush_sprites() = 0;
+    // uploads the camera into the shared uniform block, call once per frame
+    virtual void set_camera(const camera& c)                       = 0;
+    // draws go to target from now on, null is the window or, with dynamic
+    // resolution, the frame's scene target. Camera viewports are window
+    // pixels and get scaled to the target's size
+    virtual void set_render_target(const render_target* target) = 0;
+    // clears colour and depth of the current target or the window
+    virtual void clear(glm::vec4 color) = 0;
+    // transient targets, everything acquired is returned by swap_buff
+    virtual render_target_pool& render_targets() = 0;
+    // fraction of the window size per axis the frame is drawn at, 1 unless
+    // engine_config::dynamic_resolution is on
+    virtual float render_scale() const = 0;
+    // worker threads shared by the engine subsystems
+    virtual job_system& jobs() = 0;
+    // scratch memory valid for frame_arena::frames_in_flight frames,
+    // recycled by swap_buff
+    virtual frame_arena& frame_memory() = 0;
+    // draw calls, triangles and texture binds of the last presented frame
+    virtual const render_stats& last_frame_stats() const = 0;
+    // shows or hides the performance overlay, get_input also toggles it on
+    // the key bound to event::select
+    virtual void toggle_overlay() = 0;
+    // reads back the next presented frame without stalling, fn runs on a
+    // job thread once the pixels arrived. Frames that find every readback
+    // slot busy are not captured
+    virtual void capture_frame(
+        std::function<void(const captured_image&)> fn) = 0;
+    // captures the next presented frame into a PNG file
+    virtual void save_screenshot(const std::string& path) = 0;
+    // records every config.every_nth presented frame to config.path through
+    // the same readback, false when the file can't be created. A recording
+    // already running is stopped first
+    virtual bool start_recording(const recording_config& config) = 0;
+    // waits for the frames in flight, closes the file and returns how many
+    // frames made it and how many were dropped
+    virtual recording_stats stop_recording() = 0;
+    // heap allocations made during the last frame, always 0 unless the build
+    // counts them (OPENGL_WINDOW_COUNT_ALLOCATIONS)
+    virtual std::uint64_t last_frame_allocations() const = 0;
 };
 
 engine* create_engine();
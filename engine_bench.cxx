@@ -0,0 +1,391 @@
+#include <SDL.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "glad/glad.h"
+
+#include "alloc_counter.hxx"
+#include "engine.hxx"
+#include "shader.hxx"
+#include "sprite_animation.hxx"
+#include "sprite_renderer.hxx"
+
+// repeatable engine scenarios, rendered headless where EGL is available.
+// Each is reported as timing percentiles over its samples plus the average
+// render counters of a frame, as JSON so builds can be compared by a
+// script:
+//   engine_bench [output.json] [frames] [sprites]
+// runs from the directory holding the shaders and images, like the game.
+// Builds counting allocations (OPENGL_WINDOW_COUNT_ALLOCATIONS) exit with
+// failure when a frame past the warm-up touched the heap
+
+namespace
+{
+using clock = std::chrono::steady_clock;
+
+struct scenario_result
+{
+    std::string         name;
+    std::string         sample; // what one timing sample covers
+    std::size_t         items = 0;
+    std::vector<double> ms;
+    double              draw_calls    = 0.0;
+    double              triangles     = 0.0;
+    double              texture_binds = 0.0;
+    double              program_binds = 0.0;
+    double              allocations   = 0.0; // heap allocations per frame
+};
+
+double elapsed_ms(clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(clock::now() - start)
+        .count();
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    const std::size_t i =
+        static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+// draws sprites spread over the window, sprite i with textures[i % size]
+// so more textures mean more binds. A frame is timed from the first
+// recorded sprite until the GPU finished it
+scenario_result run_sprites(eng::engine&            engine,
+                            const std::string&      name,
+                            const std::vector<int>& textures,
+                            std::size_t             sprites,
+                            int                     frames)
+{
+    scenario_result r;
+    r.name   = name;
+    r.sample = "frame";
+    r.items  = sprites;
+
+    const int   columns = 100;
+    const float size    = 2.f / columns;
+    std::vector<eng::triangle> quads;
+    quads.reserve(sprites * 2);
+    for (std::size_t i = 0; i < sprites; ++i)
+    {
+        const float x = -1.f + size * static_cast<float>(i % columns);
+        const float y =
+            -1.f + size * 0.5f * static_cast<float>(i / columns % columns);
+        const eng::vertex a = { x, y, 0.f, 1.f, 1.f, 1.f, 0.f, 0.f };
+        const eng::vertex b = { x + size, y, 0.f, 1.f, 1.f, 1.f, 1.f, 0.f };
+        const eng::vertex c = {
+            x + size, y + size, 0.f, 1.f, 1.f, 1.f, 1.f, 1.f
+        };
+        const eng::vertex d = { x, y + size, 0.f, 1.f, 1.f, 1.f, 0.f, 1.f };
+        quads.push_back(eng::triangle(a, b, c));
+        quads.push_back(eng::triangle(c, d, a));
+    }
+
+    const int warmup = 30;
+    r.ms.reserve(frames);
+    for (int f = -warmup; f < frames; ++f)
+    {
+        const clock::time_point start = clock::now();
+        engine.set_camera(eng::camera());
+        for (std::size_t i = 0; i < sprites; ++i)
+        {
+            engine.draw_texture(quads[i * 2],
+                                quads[i * 2 + 1],
+                                textures[i % textures.size()],
+                                glm::mat4(1.f));
+        }
+        engine.swap_buff();
+        glFinish();
+        if (f < 0)
+        {
+            continue;
+        }
+        r.ms.push_back(elapsed_ms(start));
+        const eng::render_stats& stats = engine.last_frame_stats();
+        r.draw_calls += stats.draw_calls;
+        r.triangles += static_cast<double>(stats.triangles);
+        r.texture_binds += stats.texture_binds;
+        r.program_binds += stats.program_binds;
+        r.allocations += static_cast<double>(engine.last_frame_allocations());
+    }
+    r.draw_calls /= frames;
+    r.triangles /= frames;
+    r.texture_binds /= frames;
+    r.program_binds /= frames;
+    r.allocations /= frames;
+    return r;
+}
+
+// the same grid as run_sprites through the instanced stream, every sprite
+// playing one of four flipbook clips cut from a 4x4 atlas. A frame covers
+// advancing the animations, writing the instances and the draw
+scenario_result run_animated_sprites(eng::engine& engine,
+                                     int          texture,
+                                     std::size_t  sprites,
+                                     int          frames)
+{
+    scenario_result r;
+    r.name   = "animated_sprites_instanced";
+    r.sample = "frame";
+    r.items  = sprites;
+
+    eng::flipbook_library library;
+    const std::uint32_t   first = library.add_grid_frames(4, 4, 0, 16);
+    for (std::uint32_t clip = 0; clip < 4; ++clip)
+    {
+        library.add_clip({ first + clip * 4, 4, 8.f + 4.f * clip, true });
+    }
+    eng::sprite_animator animator(library, sprites);
+    for (std::size_t i = 0; i < sprites; ++i)
+    {
+        animator.add(static_cast<std::uint16_t>(i % 4), 0.01f * (i % 97));
+    }
+
+    const int   columns = 100;
+    const float size    = 2.f / columns;
+    const int   warmup  = 30;
+    r.ms.reserve(frames);
+    for (int f = -warmup; f < frames; ++f)
+    {
+        const clock::time_point start = clock::now();
+        engine.set_camera(eng::camera());
+        animator.advance(1.f / 60.f, engine.jobs());
+        eng::sprite_instance* out = engine.map_sprite_instances(sprites);
+        if (out)
+        {
+            for (std::size_t i = 0; i < sprites; ++i)
+            {
+                const glm::vec2 at(
+                    -1.f + size * (static_cast<float>(i % columns) + 0.5f),
+                    -1.f + size * 0.5f *
+                               static_cast<float>(i / columns % columns) +
+                        size * 0.5f);
+                eng::place_sprite(
+                    out[i], at, glm::vec2(size), 0.1f * (i % 7));
+            }
+            animator.write_uvs(out, 0, sprites);
+            engine.draw_sprite_instances(texture);
+        }
+        engine.swap_buff();
+        glFinish();
+        if (f < 0)
+        {
+            continue;
+        }
+        r.ms.push_back(elapsed_ms(start));
+        const eng::render_stats& stats = engine.last_frame_stats();
+        r.draw_calls += stats.draw_calls;
+        r.triangles += static_cast<double>(stats.triangles);
+        r.texture_binds += stats.texture_binds;
+        r.program_binds += stats.program_binds;
+        r.allocations += static_cast<double>(engine.last_frame_allocations());
+    }
+    r.draw_calls /= frames;
+    r.triangles /= frames;
+    r.texture_binds /= frames;
+    r.program_binds /= frames;
+    r.allocations /= frames;
+    return r;
+}
+
+// decode on the job system plus upload, batches of the same two images
+scenario_result run_texture_loads(eng::engine& engine, int batches)
+{
+    scenario_result r;
+    r.name   = "texture_load";
+    r.sample = "batch";
+    r.items  = 16;
+    std::vector<std::string> paths;
+    for (std::size_t i = 0; i < r.items; ++i)
+    {
+        paths.push_back(i % 2 ? "tank.png" : "fone.png");
+    }
+    for (int b = 0; b < batches; ++b)
+    {
+        const clock::time_point start = clock::now();
+        const std::vector<int>  handles = engine.load_textures(paths);
+        glFinish();
+        r.ms.push_back(elapsed_ms(start));
+        for (int h : handles)
+        {
+            engine.unload_texture(h);
+        }
+    }
+    return r;
+}
+
+// every program gets a define of its own so the driver can't hand back a
+// cached binary
+scenario_result run_shader_compiles(int programs)
+{
+    scenario_result r;
+    r.name   = "shader_compile";
+    r.sample = "program";
+    r.items  = 1;
+    for (int i = 0; i < programs; ++i)
+    {
+        const std::string defines =
+            "#define BENCH_VARIANT " + std::to_string(i) + "\n";
+        const clock::time_point start = clock::now();
+        eng::Shader             s("vertex.vert", "fragment.frag", defines);
+        GLint                   linked = 0;
+        glGetProgramiv(s.ID, GL_LINK_STATUS, &linked);
+        r.ms.push_back(elapsed_ms(start));
+        glDeleteProgram(s.ID);
+    }
+    return r;
+}
+
+// queues key events nobody binds, so the engine does the lookup without
+// logging, and times draining them through get_input
+scenario_result run_input_drain(eng::engine& engine, int batches)
+{
+    scenario_result r;
+    r.name   = "input_drain";
+    r.sample = "batch";
+    r.items  = 4096;
+    for (int b = 0; b < batches; ++b)
+    {
+        for (std::size_t i = 0; i < r.items; ++i)
+        {
+            SDL_Event e{};
+            e.type           = SDL_EVENT_KEY_DOWN;
+            e.key.keysym.sym = SDLK_q;
+            SDL_PushEvent(&e);
+        }
+        const clock::time_point start = clock::now();
+        eng::event              e;
+        while (engine.get_input(e))
+        {
+        }
+        r.ms.push_back(elapsed_ms(start));
+    }
+    return r;
+}
+
+void write_json(std::ostream&                       out,
+                const std::vector<scenario_result>& results)
+{
+    const char* renderer =
+        reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    out << "{\n  \"renderer\": \"" << (renderer ? renderer : "") << "\",\n"
+        << "  \"scenarios\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const scenario_result& r      = results[i];
+        std::vector<double>    sorted = r.ms;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (double v : sorted)
+        {
+            sum += v;
+        }
+        out << "    {\"name\": \"" << r.name << "\", \"sample\": \""
+            << r.sample << "\", \"items\": " << r.items
+            << ", \"samples\": " << sorted.size()
+            << ", \"mean_ms\": " << sum / sorted.size()
+            << ", \"p50_ms\": " << percentile(sorted, 0.5)
+            << ", \"p99_ms\": " << percentile(sorted, 0.99)
+            << ", \"max_ms\": " << sorted.back()
+            << ", \"draw_calls\": " << r.draw_calls
+            << ", \"triangles\": " << r.triangles
+            << ", \"texture_binds\": " << r.texture_binds
+            << ", \"program_binds\": " << r.program_binds
+            << ", \"heap_allocations_per_frame\": " << r.allocations << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const std::string output  = argc > 1 ? argv[1] : "";
+    const int         frames  = argc > 2 ? std::stoi(argv[2]) : 300;
+    // signed so a negative count is rejected instead of wrapping around
+    const long long sprite_count = argc > 3 ? std::stoll(argv[3]) : 10000;
+    if (frames < 1 || sprite_count < 1)
+    {
+        std::cerr << "engine_bench: frames and sprites must be at least 1"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::size_t sprites = static_cast<std::size_t>(sprite_count);
+
+    std::unique_ptr<eng::engine, void (*)(eng::engine*)> engine(
+        eng::create_engine(), eng::destroy_engine);
+    // headless runs on machines without a display, a hidden window is the
+    // fallback for builds without EGL
+    eng::engine_config config;
+    config.headless      = true;
+    config.hidden_window = true;
+    config.vsync         = false;
+    // the instanced scenario maps every sprite at once
+    config.max_sprites_per_frame = sprites;
+    bool ready = engine->initialize_engine(config);
+    if (!ready)
+    {
+        config.headless = false;
+        ready           = engine->initialize_engine(config);
+    }
+    if (!ready)
+    {
+        std::cerr << "engine_bench: no GL context" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // textures of the scenarios below are loaded once, outside the timing
+    std::vector<std::string> paths;
+    for (int i = 0; i < 16; ++i)
+    {
+        paths.push_back(i % 2 ? "tank.png" : "fone.png");
+    }
+    const std::vector<int> textures = engine->load_textures(paths);
+
+    std::vector<scenario_result> results;
+    results.push_back(run_sprites(
+        *engine, "sprites_one_texture", { textures[0] }, sprites, frames));
+    results.push_back(run_sprites(
+        *engine, "sprites_16_textures", textures, sprites, frames));
+    results.push_back(
+        run_animated_sprites(*engine, textures[0], sprites, frames));
+    results.push_back(run_texture_loads(*engine, 20));
+    results.push_back(run_shader_compiles(20));
+    results.push_back(run_input_drain(*engine, 20));
+
+    bool allocated = false;
+    for (const scenario_result& r : results)
+    {
+        if (r.allocations != 0.0)
+        {
+            std::cerr << "engine_bench: " << r.name << " made " << r.allocations
+                      << " heap allocations per frame" << std::endl;
+            allocated = true;
+        }
+    }
+
+    if (output.empty())
+    {
+        write_json(std::cout, results);
+    }
+    else
+    {
+        std::ofstream file(output);
+        write_json(file, results);
+        if (!file)
+        {
+            std::cerr << "engine_bench: can't write " << output << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    return allocated && eng::allocation_counting_enabled() ? EXIT_FAILURE
+                                                           : EXIT_SUCCESS;
+}
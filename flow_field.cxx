@@ -0,0 +1,630 @@
+#include "flow_field.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "job_system.hxx"
+
+namespace eng
+{
+namespace
+{
+constexpr int   side     = flow_field_cache::sector_size;
+constexpr int   halo     = side + 2; // a sector and a ring of its neighbours
+constexpr int   area     = side * side;
+constexpr float infinity = std::numeric_limits<float>::infinity();
+// smaller improvements don't reopen a tile, so rounds settle
+constexpr float epsilon = 1e-3f;
+
+// the eight neighbours counter clockwise from +x, then none
+constexpr std::uint8_t none     = 8;
+constexpr int          step_x[] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+constexpr int          step_y[] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+// sector edges in flow_field_cache::lowest
+constexpr int edge_left   = 0;
+constexpr int edge_right  = 1;
+constexpr int edge_bottom = 2;
+constexpr int edge_top    = 3;
+// a round takes the active sectors whose lowest new input is at most this
+// much above the lowest one, a couple of sectors of open ground. Sectors far
+// behind the front would only be relaxed again once it reaches them
+constexpr float band = 2.f * side;
+
+struct heap_entry
+{
+    float         value;
+    std::uint16_t cell; // in the halo'd sector
+};
+
+bool later(const heap_entry& a, const heap_entry& b)
+{
+    return a.value > b.value;
+}
+
+// tile centres h.x apart along x and h.y along y, w = 1 / h^2
+struct eikonal_spacing
+{
+    explicit eikonal_spacing(glm::vec2 spacing)
+        : h(spacing)
+        , w(1.f / (spacing * spacing))
+        , inv_w_sum(1.f / (w.x + w.y))
+    {
+    }
+
+    glm::vec2 h;
+    glm::vec2 w;
+    float     inv_w_sum;
+};
+
+// first order upwind solution of |grad T| = cost from the cheaper neighbour
+// along x and along y, the eikonal update of fast marching. Paths are
+// straight at any angle instead of the 45 degree zigzag of a plain
+// Dijkstra over eight neighbours
+float eikonal(float                  along_x,
+              float                  along_y,
+              float                  cost,
+              const eikonal_spacing& s)
+{
+    const float from_x = along_x + cost * s.h.x;
+    const float from_y = along_y + cost * s.h.y;
+    // a neighbour reached no sooner than the other one alone gets there adds
+    // nothing
+    if (from_x <= along_y || from_y <= along_x)
+    {
+        return std::min(from_x, from_y);
+    }
+    const float d = along_x - along_y;
+    return (s.w.x * along_x + s.w.y * along_y +
+            std::sqrt((s.w.x + s.w.y) * cost * cost - s.w.x * s.w.y * d * d)) *
+           s.inv_w_sum;
+}
+} // namespace
+
+flow_field::flow_field(const flow_field_cache& cache)
+    : grid(&cache)
+{
+}
+
+glm::vec2 flow_field::direction(glm::vec2 position) const
+{
+    const glm::ivec2 tile = grid->tile_at(position);
+    if (!grid->contains(tile))
+    {
+        return glm::vec2(0.f);
+    }
+    return grid->steps[flow[grid->index(tile.x, tile.y)]];
+}
+
+float flow_field::remaining(glm::vec2 position) const
+{
+    const glm::ivec2 tile = grid->tile_at(position);
+    if (!grid->contains(tile))
+    {
+        return infinity;
+    }
+    return integration[grid->index(tile.x, tile.y)];
+}
+
+flow_field_cache::flow_field_cache(glm::ivec2  size_in_tiles,
+                                   glm::vec2   tile_size_,
+                                   glm::vec2   origin_,
+                                   std::size_t max_fields_)
+    : tiles(size_in_tiles)
+    , tile_size(tile_size_)
+    , spacing(tile_size_ / std::min(tile_size_.x, tile_size_.y))
+    , origin(origin_)
+    , sectors_x((size_in_tiles.x + side - 1) / side)
+    , sectors_y((size_in_tiles.y + side - 1) / side)
+    , max_fields(std::max<std::size_t>(max_fields_, 1))
+{
+    // the padding of partial sectors is wall, so solving never enters it
+    const std::size_t sectors =
+        static_cast<std::size_t>(sectors_x) * sectors_y;
+    costs.assign(sectors * area, wall);
+    for (int y = 0; y < tiles.y; ++y)
+    {
+        for (int x = 0; x < tiles.x; ++x)
+        {
+            costs[index(x, y)] = 1;
+        }
+    }
+    active.assign(sectors, infinity);
+    touched.assign(sectors, 0);
+    reopen.assign(sectors, 0);
+    lowest.resize(sectors);
+
+    // non square tiles bend the diagonals
+    for (int d = 0; d < 8; ++d)
+    {
+        steps[d] = glm::normalize(glm::vec2(step_x[d], step_y[d]) * tile_size);
+    }
+    steps[none] = glm::vec2(0.f);
+}
+
+flow_field_cache::~flow_field_cache() = default;
+
+std::size_t flow_field_cache::index(int x, int y) const
+{
+    const std::size_t sector = sector_of(x, y);
+    return sector * area + (y % side) * side + x % side;
+}
+
+int flow_field_cache::sector_of(int x, int y) const
+{
+    return (y / side) * sectors_x + x / side;
+}
+
+glm::ivec2 flow_field_cache::tile_at(glm::vec2 position) const
+{
+    const glm::vec2 t = (position - origin) / tile_size;
+    return glm::ivec2(static_cast<int>(std::floor(t.x)),
+                      static_cast<int>(std::floor(t.y)));
+}
+
+bool flow_field_cache::contains(glm::ivec2 tile) const
+{
+    return tile.x >= 0 && tile.y >= 0 && tile.x < tiles.x && tile.y < tiles.y;
+}
+
+std::uint8_t flow_field_cache::cost(glm::ivec2 tile) const
+{
+    return costs[index(tile.x, tile.y)];
+}
+
+void flow_field_cache::set_cost(glm::ivec2 tile, std::uint8_t new_cost)
+{
+    std::uint8_t& c = costs[index(tile.x, tile.y)];
+    if (c == new_cost)
+    {
+        return;
+    }
+    // past this many changes a field is cheaper to solve from scratch
+    constexpr std::size_t max_pending = 64;
+    for (const auto& f : fields)
+    {
+        if (f->stale)
+        {
+            continue;
+        }
+        if (f->pending.size() == max_pending)
+        {
+            f->stale = true;
+            f->pending.clear();
+            continue;
+        }
+        f->pending.push_back({ tile, c, new_cost });
+    }
+    c = new_cost;
+}
+
+const flow_field& flow_field_cache::field(glm::ivec2 target)
+{
+    flow_field& f = find(target);
+    update(f, nullptr);
+    return f;
+}
+
+const flow_field& flow_field_cache::field(glm::ivec2 target, job_system& jobs)
+{
+    flow_field& f = find(target);
+    update(f, &jobs);
+    return f;
+}
+
+void flow_field_cache::pin(const flow_field& f)
+{
+    f.pins.fetch_add(1, std::memory_order_relaxed);
+}
+
+void flow_field_cache::unpin(const flow_field& f)
+{
+    // the reads of the pinning thread end before find may reuse the arrays
+    f.pins.fetch_sub(1, std::memory_order_release);
+}
+
+flow_field& flow_field_cache::find(glm::ivec2 target)
+{
+    target.x = std::clamp(target.x, 0, tiles.x - 1);
+    target.y = std::clamp(target.y, 0, tiles.y - 1);
+    ++uses;
+    flow_field* oldest = nullptr;
+    for (const auto& f : fields)
+    {
+        if (f->goal == target)
+        {
+            f->last_used = uses;
+            return *f;
+        }
+        const bool evictable = f->pins.load(std::memory_order_acquire) == 0;
+        if (evictable && (!oldest || f->last_used < oldest->last_used))
+        {
+            oldest = f.get();
+        }
+    }
+    // a new target reuses the arrays of the field it evicts
+    flow_field* f = oldest;
+    if (fields.size() < max_fields || !oldest)
+    {
+        fields.push_back(std::unique_ptr<flow_field>(new flow_field(*this)));
+        f = fields.back().get();
+    }
+    f->goal      = target;
+    f->stale     = true;
+    f->last_used = uses;
+    f->pending.clear();
+    return *f;
+}
+
+void flow_field_cache::update(flow_field& f, job_system* jobs)
+{
+    if (!f.stale && f.pending.empty())
+    {
+        return;
+    }
+    std::fill(active.begin(), active.end(), infinity);
+    std::fill(touched.begin(), touched.end(), 0);
+    std::fill(reopen.begin(), reopen.end(), 0);
+    if (f.stale)
+    {
+        f.integration.assign(costs.size(), infinity);
+        f.flow.assign(costs.size(), none);
+        f.stale = false;
+    }
+    else
+    {
+        for (const flow_field::tile_change& change : f.pending)
+        {
+            if (change.new_cost == wall ||
+                (change.old_cost != wall && change.new_cost > change.old_cost))
+            {
+                forget_downstream(f, change.tile);
+            }
+            // the flow around it changes even when the values don't, walls
+            // decide which diagonals are open
+            const int s = sector_of(change.tile.x, change.tile.y);
+            active[s]  = 0.f;
+            touched[s] = 1;
+            reopen[s]  = 1;
+        }
+        f.pending.clear();
+    }
+    const std::size_t goal = index(f.goal.x, f.goal.y);
+    if (costs[goal] != wall)
+    {
+        f.integration[goal] = 0.f;
+        const int s = sector_of(f.goal.x, f.goal.y);
+        active[s] = 0.f;
+        reopen[s] = 1;
+    }
+    solve(f, jobs);
+}
+
+// the tiles whose value was reached through tile, directly or by a chain of
+// rising values, go back to unreached. The rest of the field stays and
+// their sectors are solved again from it
+void flow_field_cache::forget_downstream(flow_field& f, glm::ivec2 tile)
+{
+    struct reached
+    {
+        glm::ivec2 tile;
+        float      value;
+    };
+    float& start = f.integration[index(tile.x, tile.y)];
+    if (start == infinity)
+    {
+        return;
+    }
+    std::vector<reached> open{ { tile, start } };
+    start = infinity;
+    while (!open.empty())
+    {
+        const reached r = open.back();
+        open.pop_back();
+        const int s = sector_of(r.tile.x, r.tile.y);
+        active[s]  = 0.f;
+        touched[s] = 1;
+        reopen[s]  = 1;
+        for (int d = 0; d < 8; d += 2)
+        {
+            const glm::ivec2 n = r.tile + glm::ivec2(step_x[d], step_y[d]);
+            if (!contains(n))
+            {
+                continue;
+            }
+            float& value = f.integration[index(n.x, n.y)];
+            if (value != infinity && value > r.value)
+            {
+                open.push_back({ n, value });
+                value = infinity;
+            }
+        }
+    }
+}
+
+void flow_field_cache::for_each_queued(job_system*                     jobs,
+                                       const std::function<void(int)>& fn)
+{
+    if (!jobs)
+    {
+        for (const int s : queued)
+        {
+            fn(s);
+        }
+        return;
+    }
+    // a sector is a few thousand heap operations, enough for a job alone
+    jobs->parallel_for(0,
+                       queued.size(),
+                       1,
+                       [&](std::size_t begin, std::size_t end)
+                       {
+                           for (std::size_t i = begin; i < end; ++i)
+                           {
+                               fn(queued[i]);
+                           }
+                       });
+}
+
+// label correcting over sectors: a round relaxes active sectors from their
+// own values and their neighbours' edges as they were when the round
+// started, so the sectors of a round share no writes. Values only drop, a
+// sector whose edge dropped wakes the neighbour behind it, and taking the
+// sectors in bands of their lowest input keeps the rounds near the order
+// a single Dijkstra over the whole map would settle them in
+void flow_field_cache::solve(flow_field& f, job_system* jobs)
+{
+    for (;;)
+    {
+        const float front = *std::min_element(active.begin(), active.end());
+        if (front == infinity)
+        {
+            break;
+        }
+        queued.clear();
+        for (std::size_t s = 0; s < active.size(); ++s)
+        {
+            if (active[s] <= front + band)
+            {
+                queued.push_back(static_cast<int>(s));
+                active[s] = infinity;
+            }
+        }
+        snapshot.assign(f.integration.begin(), f.integration.end());
+        for_each_queued(jobs, [&](int s) { relax_sector(f, s); });
+
+        for (const int s : queued)
+        {
+            const int                   sx  = s % sectors_x;
+            const int                   sy  = s / sectors_x;
+            const std::array<float, 4>& low = lowest[s];
+            const auto wake = [&](int neighbour, float value)
+            { active[neighbour] = std::min(active[neighbour], value); };
+            if (sx > 0)
+            {
+                wake(s - 1, low[edge_left]);
+            }
+            if (sx + 1 < sectors_x)
+            {
+                wake(s + 1, low[edge_right]);
+            }
+            if (sy > 0)
+            {
+                wake(s - sectors_x, low[edge_bottom]);
+            }
+            if (sy + 1 < sectors_y)
+            {
+                wake(s + sectors_x, low[edge_top]);
+            }
+        }
+    }
+
+    // flow reads the neighbouring sectors' edges, so the sectors next to a
+    // changed one are built again as well
+    queued.clear();
+    for (int sy = 0; sy < sectors_y; ++sy)
+    {
+        for (int sx = 0; sx < sectors_x; ++sx)
+        {
+            bool near_change = false;
+            for (int y = std::max(sy - 1, 0);
+                 y <= std::min(sy + 1, sectors_y - 1) && !near_change;
+                 ++y)
+            {
+                for (int x = std::max(sx - 1, 0);
+                     x <= std::min(sx + 1, sectors_x - 1);
+                     ++x)
+                {
+                    near_change = near_change || touched[y * sectors_x + x];
+                }
+            }
+            if (near_change)
+            {
+                queued.push_back(sy * sectors_x + sx);
+            }
+        }
+    }
+    for_each_queued(jobs, [&](int s) { build_flow(f, s); });
+}
+
+// the sector's values padded by a ring of its neighbours' from around,
+// infinity past the map
+void flow_field_cache::load_sector(const flow_field& f,
+                                   const float*      around,
+                                   int               sector,
+                                   float*            local) const
+{
+    const int    sx     = sector % sectors_x;
+    const int    sy     = sector / sectors_x;
+    const float* values = f.integration.data() + sector * area;
+    for (int ly = -1; ly <= side; ++ly)
+    {
+        for (int lx = -1; lx <= side; ++lx)
+        {
+            const int  x    = sx * side + lx;
+            const int  y    = sy * side + ly;
+            const int  cell = (ly + 1) * halo + lx + 1;
+            const bool mine = lx >= 0 && ly >= 0 && lx < side && ly < side;
+            if (mine)
+            {
+                local[cell] = values[ly * side + lx];
+            }
+            else if (x >= 0 && y >= 0 && x < sectors_x * side &&
+                     y < sectors_y * side)
+            {
+                local[cell] = around[index(x, y)];
+            }
+            else
+            {
+                local[cell] = infinity;
+            }
+        }
+    }
+}
+
+// fast marching inside one sector padded by a ring of its neighbours'
+// values, the padding only feeds the sector. Tiles are reopened when they
+// improve, which is what lets later rounds lower values already settled.
+// The sector's own values agree with each other after a relax, so later
+// ones start from the padding alone unless tiles inside were reopened.
+// Writes only the sector's own values and scratch entries
+void flow_field_cache::relax_sector(flow_field& f, int sector)
+{
+    float local[halo * halo];
+    load_sector(f, snapshot.data(), sector, local);
+    float*              values = f.integration.data() + sector * area;
+    const std::uint8_t* cost   = costs.data() + sector * area;
+
+    // kept per worker, a sector never grows it past a few thousand entries
+    thread_local std::vector<heap_entry> heap;
+    heap.clear();
+    const bool from_inside = reopen[sector] != 0;
+    reopen[sector]         = 0;
+    for (int cell = 0; cell < halo * halo; ++cell)
+    {
+        const int  lx     = cell % halo;
+        const int  ly     = cell / halo;
+        const bool inside = lx > 0 && ly > 0 && lx <= side && ly <= side;
+        if (local[cell] != infinity && (from_inside || !inside))
+        {
+            heap.push_back({ local[cell], static_cast<std::uint16_t>(cell) });
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), later);
+
+    const int             offsets[] = { -1, 1, -halo, halo };
+    const eikonal_spacing along(spacing);
+    while (!heap.empty())
+    {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        const heap_entry e = heap.back();
+        heap.pop_back();
+        if (e.value > local[e.cell])
+        {
+            continue; // reopened since
+        }
+        for (const int offset : offsets)
+        {
+            const int n  = e.cell + offset;
+            const int lx = n % halo - 1;
+            const int ly = n / halo - 1;
+            if (n < 0 || n >= halo * halo || lx < 0 || ly < 0 || lx >= side ||
+                ly >= side)
+            {
+                continue;
+            }
+            const std::uint8_t c = cost[ly * side + lx];
+            if (c == wall)
+            {
+                continue;
+            }
+            const float t = eikonal(std::min(local[n - 1], local[n + 1]),
+                                    std::min(local[n - halo], local[n + halo]),
+                                    static_cast<float>(c),
+                                    along);
+            if (t + epsilon < local[n])
+            {
+                local[n] = t;
+                heap.push_back({ t, static_cast<std::uint16_t>(n) });
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+        }
+    }
+
+    std::array<float, 4>& low = lowest[sector];
+    low.fill(infinity);
+    for (int ly = 0; ly < side; ++ly)
+    {
+        for (int lx = 0; lx < side; ++lx)
+        {
+            const float now = local[(ly + 1) * halo + lx + 1];
+            float&      was = values[ly * side + lx];
+            if (now == was)
+            {
+                continue;
+            }
+            was             = now;
+            touched[sector] = 1;
+            const auto edge = [&](int e) { low[e] = std::min(low[e], now); };
+            if (lx == 0)
+            {
+                edge(edge_left);
+            }
+            if (lx == side - 1)
+            {
+                edge(edge_right);
+            }
+            if (ly == 0)
+            {
+                edge(edge_bottom);
+            }
+            if (ly == side - 1)
+            {
+                edge(edge_top);
+            }
+        }
+    }
+}
+
+// each tile points at its cheapest neighbour, a diagonal only when both
+// tiles beside it are open so units don't clip wall corners. Next to a
+// reached tile, open and reached are the same
+void flow_field_cache::build_flow(flow_field& f, int sector) const
+{
+    float local[halo * halo];
+    load_sector(f, f.integration.data(), sector, local);
+
+    int offsets[8];
+    for (int d = 0; d < 8; ++d)
+    {
+        offsets[d] = step_y[d] * halo + step_x[d];
+    }
+    std::uint8_t* way = f.flow.data() + sector * area;
+    for (int ly = 0; ly < side; ++ly)
+    {
+        for (int lx = 0; lx < side; ++lx)
+        {
+            const int    cell = (ly + 1) * halo + lx + 1;
+            float        best = local[cell];
+            std::uint8_t next = none;
+            for (int d = 0; d < 8 && best != infinity; ++d)
+            {
+                if ((d & 1) && (local[cell + step_x[d]] == infinity ||
+                                local[cell + step_y[d] * halo] == infinity))
+                {
+                    continue;
+                }
+                const float v = local[cell + offsets[d]];
+                if (v < best)
+                {
+                    best = v;
+                    next = static_cast<std::uint8_t>(d);
+                }
+            }
+            way[ly * side + lx] = next;
+        }
+    }
+}
+} // namespace eng
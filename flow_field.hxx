@@ -0,0 +1,148 @@
+#ifndef OPENGL_WINDOW_FLOW_FIELD_HXX
+#define OPENGL_WINDOW_FLOW_FIELD_HXX
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace eng
+{
+class flow_field_cache;
+class job_system;
+
+// the way to one target tile from every tile of the map: the integration
+// field holds the cost of the cheapest path, the flow field the neighbour
+// each tile steps to on it. Owned by a flow_field_cache
+class flow_field
+{
+public:
+    glm::ivec2 target() const { return goal; }
+
+    // world space unit vector toward the next tile on the way, zero on the
+    // target tile, on walls, off the map and where the target is out of reach
+    glm::vec2 direction(glm::vec2 position) const;
+    // path cost left from the tile under position, 0 on the target tile and
+    // infinity where it can't be reached. A tile's cost is per length of
+    // its shorter side, so crossing a 1x2 tile lengthwise costs it twice
+    float remaining(glm::vec2 position) const;
+
+private:
+    friend class flow_field_cache;
+
+    struct tile_change
+    {
+        glm::ivec2   tile;
+        std::uint8_t old_cost;
+        std::uint8_t new_cost;
+    };
+
+    explicit flow_field(const flow_field_cache& grid);
+
+    const flow_field_cache*   grid;
+    glm::ivec2                goal{ 0, 0 };
+    bool                      stale     = true; // solved again from scratch
+    std::uint64_t             last_used = 0;
+    mutable std::atomic<int>  pins{ 0 }; // evicted only at 0
+    std::vector<float>        integration; // in the grid's sector order
+    std::vector<std::uint8_t> flow;
+    std::vector<tile_change>  pending; // applied on the next use
+};
+
+// flow fields over a tile grid with a cost per tile, kept for the most
+// recently used targets so every unit heading to the same place shares
+// one field and steers by a lookup. Tiles are stored in square sectors,
+// each one a contiguous block: solving runs rounds of a fast marching pass
+// per sector on a copy of it that fits the L1 cache, the sectors of a round
+// in parallel, until no sector's edge changes any more. field and set_cost
+// are for one thread at a time, tile_at and lookups on a field that isn't
+// being repaired may run beside them
+class flow_field_cache
+{
+public:
+    static constexpr int          sector_size = 16; // tiles per sector side
+    static constexpr std::uint8_t wall        = 0;  // cost of a blocked tile
+
+    // tiles cost 1 to cross until set_cost. The geometry matches tilemap:
+    // tile (0, 0) is the bottom left one and starts at origin
+    flow_field_cache(glm::ivec2  size_in_tiles,
+                     glm::vec2   tile_size,
+                     glm::vec2   origin,
+                     std::size_t max_fields = 16);
+    ~flow_field_cache();
+
+    flow_field_cache(const flow_field_cache&)            = delete;
+    flow_field_cache& operator=(const flow_field_cache&) = delete;
+
+    glm::ivec2 size() const { return tiles; }
+    // the tile under a world position, outside the map when it is
+    glm::ivec2 tile_at(glm::vec2 position) const;
+    bool       contains(glm::ivec2 tile) const;
+
+    std::uint8_t cost(glm::ivec2 tile) const;
+    // wall blocks the tile. Cached fields are repaired on their next use:
+    // a cheaper tile only reopens its sector, a dearer one first forgets
+    // the tiles whose cost was reached through it
+    void set_cost(glm::ivec2 tile, std::uint8_t cost);
+
+    // the field toward target, clamped onto the map, solved on first use
+    // and repaired after set_cost. The reference stays valid until a call
+    // for a target that isn't cached evicts the least recently used field
+    // that isn't pinned. With every field pinned the cache grows instead
+    const flow_field& field(glm::ivec2 target);
+    // same, the sectors of each round solved on the job system
+    const flow_field& field(glm::ivec2 target, job_system& jobs);
+
+    // keeps f from being evicted until the matching unpin, pins nest. Safe
+    // beside field on another thread, a field unpinned there may be reused
+    // by that call right away
+    static void pin(const flow_field& f);
+    static void unpin(const flow_field& f);
+
+    std::size_t cached() const { return fields.size(); }
+
+private:
+    friend class flow_field;
+
+    flow_field& find(glm::ivec2 target);
+    void        update(flow_field& f, job_system* jobs);
+    void        forget_downstream(flow_field& f, glm::ivec2 tile);
+    void        solve(flow_field& f, job_system* jobs);
+    void        load_sector(const flow_field& f,
+                            const float*      around,
+                            int               sector,
+                            float*            local) const;
+    void        relax_sector(flow_field& f, int sector);
+    void        build_flow(flow_field& f, int sector) const;
+    void        for_each_queued(job_system*                     jobs,
+                                const std::function<void(int)>& fn);
+
+    std::size_t index(int x, int y) const;
+    int         sector_of(int x, int y) const;
+
+    glm::ivec2                               tiles;
+    glm::vec2                                tile_size;
+    glm::vec2                                spacing; // over the shorter side
+    glm::vec2                                origin;
+    int                                      sectors_x;
+    int                                      sectors_y;
+    std::size_t                              max_fields;
+    std::uint64_t                            uses = 0;
+    std::vector<std::uint8_t>                costs; // sector order
+    std::vector<std::unique_ptr<flow_field>> fields;
+    glm::vec2                                steps[9]; // world directions
+    // scratch of the field being updated, relax_sector only writes the
+    // entries of its own sector
+    std::vector<float>                       snapshot; // round start values
+    std::vector<float>                       active;   // lowest new input
+    std::vector<std::uint8_t>                touched;  // values changed
+    std::vector<std::uint8_t>                reopen;   // relax from inside too
+    std::vector<std::array<float, 4>>        lowest;   // dropped edge values
+    std::vector<int>                         queued;   // sectors of a pass
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_FLOW_FIELD_HXX
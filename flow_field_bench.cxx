@@ -0,0 +1,132 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "flow_field.hxx"
+#include "job_system.hxx"
+
+// solves flow fields over a map of open ground, rough ground and walls,
+// repairs them after a few tiles change and steers a crowd by lookups.
+// Reported as milliseconds per solve and repair and lookups per ms
+namespace
+{
+using clock = std::chrono::steady_clock;
+
+struct result
+{
+    double solve_ms  = 0.0; // per field
+    double repair_ms = 0.0;
+    double lookup_ms = 0.0; // for every unit
+    double steered   = 0.0; // share of units with a way to the target
+};
+
+double since(clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(clock::now() - start)
+        .count();
+}
+
+result run(int map, std::size_t units, int targets, eng::job_system* jobs)
+{
+    eng::flow_field_cache paths(
+        glm::ivec2(map, map), glm::vec2(1.f), glm::vec2(0.f), 4);
+
+    std::uint32_t seed   = 1u;
+    auto          random = [&]
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return static_cast<float>(seed >> 8) / 16777216.f;
+    };
+    auto any_tile = [&]
+    {
+        return glm::ivec2(static_cast<int>(random() * map),
+                          static_cast<int>(random() * map));
+    };
+    for (int y = 0; y < map; ++y)
+    {
+        for (int x = 0; x < map; ++x)
+        {
+            const float r = random();
+            paths.set_cost(glm::ivec2(x, y),
+                           r < 0.15f ? eng::flow_field_cache::wall
+                           : r < 0.3f ? 4
+                                      : 1);
+        }
+    }
+    std::vector<glm::vec2> positions(units);
+    for (glm::vec2& p : positions)
+    {
+        p = glm::vec2(random(), random()) * static_cast<float>(map);
+    }
+
+    // every target is new to the cache, so each one is a full solve
+    auto field = [&](glm::ivec2 target) -> const eng::flow_field&
+    { return jobs ? paths.field(target, *jobs) : paths.field(target); };
+    result r;
+    for (int t = 0; t < targets; ++t)
+    {
+        const glm::ivec2        target = any_tile();
+        const clock::time_point start  = clock::now();
+        field(target);
+        r.solve_ms += since(start);
+
+        // a wall goes up and another comes down, both usually on paths the
+        // field already settled
+        paths.set_cost(any_tile(), eng::flow_field_cache::wall);
+        paths.set_cost(any_tile(), 1);
+        const clock::time_point repair = clock::now();
+        const eng::flow_field&  f      = field(target);
+        r.repair_ms += since(repair);
+
+        const clock::time_point lookup  = clock::now();
+        std::size_t             steered = 0;
+        for (const glm::vec2& p : positions)
+        {
+            const glm::vec2 d = f.direction(p);
+            steered += d.x != 0.f || d.y != 0.f;
+        }
+        r.lookup_ms += since(lookup);
+        r.steered += static_cast<double>(steered) / units;
+    }
+    r.solve_ms /= targets;
+    r.repair_ms /= targets;
+    r.lookup_ms /= targets;
+    r.steered /= targets;
+    return r;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int map = argc > 1 ? std::stoi(argv[1]) : 512;
+    // signed so a negative count is rejected instead of wrapping around
+    const long long unit_count = argc > 2 ? std::stoll(argv[2]) : 100000;
+    const int       targets    = argc > 3 ? std::stoi(argv[3]) : 20;
+    if (map < 1 || unit_count < 1 || targets < 1)
+    {
+        std::cerr
+            << "flow_field_bench: map, units and targets must be at least 1"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::size_t units = static_cast<std::size_t>(unit_count);
+
+    const result    single = run(map, units, targets, nullptr);
+    eng::job_system jobs;
+    const result    parallel = run(map, units, targets, &jobs);
+
+    std::cout << "map " << map << "x" << map << " units " << units
+              << " targets " << targets << std::endl;
+    std::cout << "single   " << single.solve_ms << " ms per solve, "
+              << single.repair_ms << " ms per repair, "
+              << units / single.lookup_ms << " lookups/ms, "
+              << single.steered * 100.0 << "% of units steered" << std::endl;
+    std::cout << "parallel " << parallel.solve_ms << " ms per solve, "
+              << parallel.repair_ms << " ms per repair with "
+              << jobs.worker_count() + 1 << " threads" << std::endl;
+    return EXIT_SUCCESS;
+}
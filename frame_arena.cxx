@@ -0,0 +1,87 @@
+#include "frame_arena.hxx"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+namespace eng
+{
+frame_arena::frame_arena(std::size_t bytes_per_frame)
+    : capacity(bytes_per_frame)
+{
+    for (frame_buffer& f : frames)
+    {
+        f.memory.reset(new unsigned char[capacity]);
+        // overflow blocks are rare, room for a few keeps them from
+        // allocating bookkeeping on top
+        f.overflow.reserve(16);
+    }
+}
+
+frame_arena::~frame_arena()
+{
+    for (frame_buffer& f : frames)
+    {
+        release_overflow(f);
+    }
+}
+
+void* frame_arena::allocate(std::size_t size, std::size_t align)
+{
+    frame_buffer&     f    = frames[current];
+    const std::size_t base = reinterpret_cast<std::size_t>(f.memory.get());
+    const std::size_t aligned =
+        (base + f.offset + align - 1) / align * align - base;
+    if (aligned + size <= capacity)
+    {
+        f.offset = aligned + size;
+        return f.memory.get() + aligned;
+    }
+
+    if (overflows++ == 0)
+    {
+        std::cerr << "frame arena of " << capacity
+                  << " bytes exhausted, falling back to the heap" << std::endl;
+    }
+    const std::size_t rounded = (size + align - 1) / align * align;
+    void*             block   = std::aligned_alloc(align, rounded);
+    f.overflow.push_back(block);
+    f.overflow_bytes += rounded;
+    return block;
+}
+
+void frame_arena::begin_frame()
+{
+    const frame_buffer& done = frames[current];
+    peak = std::max(peak, done.offset + done.overflow_bytes);
+
+    current = (current + 1) % frames_in_flight;
+    ++frame;
+    frame_buffer& f = frames[current];
+    f.offset        = 0;
+    release_overflow(f);
+}
+
+frame_arena::usage frame_arena::stats() const
+{
+    const frame_buffer& f = frames[current];
+    usage               u;
+    u.capacity       = capacity;
+    u.used           = f.offset;
+    u.peak           = std::max(peak, f.offset + f.overflow_bytes);
+    u.overflow_bytes = f.overflow_bytes;
+    u.overflows      = overflows;
+    u.frame          = frame;
+    return u;
+}
+
+void frame_arena::release_overflow(frame_buffer& f)
+{
+    for (void* block : f.overflow)
+    {
+        std::free(block);
+    }
+    f.overflow.clear();
+    f.overflow_bytes = 0;
+}
+} // namespace eng
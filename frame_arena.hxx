@@ -0,0 +1,72 @@
+#ifndef OPENGL_WINDOW_FRAME_ARENA_HXX
+#define OPENGL_WINDOW_FRAME_ARENA_HXX
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace eng
+{
+// bump allocator for data that lives for one frame: command lists, vertex
+// staging, culling results. Memory handed out during frame N stays valid
+// until frame N + frames_in_flight starts, the same window the GPU fences
+// guard, so data still read by worker threads or the driver is never
+// overwritten. Nothing is freed individually.
+class frame_arena
+{
+public:
+    static constexpr int frames_in_flight = 3;
+
+    struct usage
+    {
+        std::size_t   capacity       = 0; // bytes per frame buffer
+        std::size_t   used           = 0; // bytes used by the current frame
+        std::size_t   peak           = 0; // highest per frame use so far
+        std::size_t   overflow_bytes = 0; // current frame, taken from heap
+        std::uint64_t overflows      = 0; // allocations that hit the heap
+        std::uint64_t frame          = 0;
+    };
+
+    explicit frame_arena(std::size_t bytes_per_frame);
+    ~frame_arena();
+
+    frame_arena(const frame_arena&)            = delete;
+    frame_arena& operator=(const frame_arena&) = delete;
+
+    // never fails, when the frame buffer is exhausted the block comes from
+    // the heap and is counted in usage::overflows
+    void* allocate(std::size_t size,
+                   std::size_t align = alignof(std::max_align_t));
+
+    // storage for count objects, T must be trivially destructible
+    template <typename T>
+    T* allocate_array(std::size_t count)
+    {
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // switches to the oldest frame buffer and recycles it
+    void begin_frame();
+
+    usage stats() const;
+
+private:
+    struct frame_buffer
+    {
+        std::unique_ptr<unsigned char[]> memory;
+        std::size_t                      offset = 0;
+        std::vector<void*>               overflow;
+        std::size_t                      overflow_bytes = 0;
+    };
+
+    void release_overflow(frame_buffer& f);
+
+    frame_buffer  frames[frames_in_flight];
+    std::size_t   capacity;
+    int           current   = 0;
+    std::size_t   peak      = 0;
+    std::uint64_t overflows = 0;
+    std::uint64_t frame     = 0;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_FRAME_ARENA_HXX
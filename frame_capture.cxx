@@ -0,0 +1,138 @@
+#include "frame_capture.hxx"
+
+#include "gl_check.hxx"
+#include "render_stats.hxx"
+
+namespace eng
+{
+frame_capture::frame_capture(job_system& jobs, glm::ivec2 max_size)
+    : jobs(jobs)
+    , slot_bytes(static_cast<std::size_t>(max_size.x) * max_size.y * 4)
+{
+    for (slot& s : ring)
+    {
+        glGenBuffers(1, &s.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER,
+                     static_cast<GLsizeiptr>(slot_bytes),
+                     nullptr,
+                     GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    OM_GL_CHECK(glBindBuffer)
+    gpu_memory_bytes() += static_cast<std::int64_t>(slot_bytes) * slots;
+}
+
+frame_capture::~frame_capture()
+{
+    finish();
+    for (slot& s : ring)
+    {
+        glDeleteBuffers(1, &s.pbo);
+    }
+    gpu_memory_bytes() -= static_cast<std::int64_t>(slot_bytes) * slots;
+}
+
+bool frame_capture::capture(glm::ivec4 rect, std::uint64_t frame, consumer fn)
+{
+    if (static_cast<std::size_t>(rect.z) * rect.w * 4 > slot_bytes ||
+        rect.z <= 0 || rect.w <= 0)
+    {
+        return false;
+    }
+    slot& s = ring[next];
+    if (s.st != state::idle)
+    {
+        ++dropped_count;
+        return false;
+    }
+    next = (next + 1) % slots;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    // with a pack buffer bound the pointer is an offset and the call
+    // returns without waiting for the GPU
+    glReadPixels(
+        rect.x, rect.y, rect.z, rect.w, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    OM_GL_CHECK(glBindBuffer)
+    s.fence        = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    s.st           = state::reading;
+    s.image.width  = rect.z;
+    s.image.height = rect.w;
+    s.image.pixels = nullptr;
+    s.image.frame  = frame;
+    s.fn           = std::move(fn);
+    return true;
+}
+
+void frame_capture::start_consumer(slot& s)
+{
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+    s.image.pixels = static_cast<const std::uint8_t*>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER,
+                         0,
+                         static_cast<GLsizeiptr>(s.image.width) *
+                             s.image.height * 4,
+                         GL_MAP_READ_BIT));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    OM_GL_CHECK(glBindBuffer)
+    s.st = state::consuming;
+    if (!s.image.pixels)
+    {
+        // nothing to hand out, the slot is unmapped and freed by poll
+        return;
+    }
+    // the mapping stays valid for other threads until the GL thread
+    // unmaps it, which poll does only after the job finished
+    jobs.run([&s] { s.fn(s.image); }, &s.done);
+}
+
+void frame_capture::poll()
+{
+    for (slot& s : ring)
+    {
+        if (s.st == state::reading)
+        {
+            const GLenum status = glClientWaitSync(s.fence, 0, 0);
+            if (status == GL_ALREADY_SIGNALED ||
+                status == GL_CONDITION_SATISFIED)
+            {
+                glDeleteSync(s.fence);
+                s.fence = nullptr;
+                start_consumer(s);
+            }
+        }
+        if (s.st == state::consuming && s.done.done())
+        {
+            jobs.wait(s.done); // lets the finishing job release the counter
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            s.fn = nullptr;
+            s.st = state::idle;
+        }
+    }
+}
+
+void frame_capture::finish()
+{
+    for (slot& s : ring)
+    {
+        if (s.st == state::reading)
+        {
+            glClientWaitSync(
+                s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1) << 40);
+        }
+    }
+    poll();
+    for (slot& s : ring)
+    {
+        if (s.st == state::consuming)
+        {
+            jobs.wait(s.done);
+        }
+    }
+    poll();
+}
+} // namespace eng
@@ -0,0 +1,82 @@
+#ifndef OPENGL_WINDOW_FRAME_CAPTURE_HXX
+#define OPENGL_WINDOW_FRAME_CAPTURE_HXX
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "glad/glad.h"
+
+#include <glm/glm.hpp>
+
+#include "frame_arena.hxx"
+#include "job_system.hxx"
+
+namespace eng
+{
+// RGBA8 pixels of a capture, rows bottom up the way GL returns them.
+// Only valid during the consumer call
+struct captured_image
+{
+    int                 width  = 0;
+    int                 height = 0;
+    const std::uint8_t* pixels = nullptr;
+    std::uint64_t       frame  = 0; // value passed to capture
+};
+
+// asynchronous glReadPixels: each capture reads into a pixel pack buffer
+// and fences it, poll maps the buffers whose fence has signaled and hands
+// the mapped memory to a job. The buffer is unmapped once the job is done,
+// so the render thread neither waits for the GPU nor copies the pixels
+class frame_capture
+{
+public:
+    using consumer = std::function<void(const captured_image&)>;
+
+    static constexpr int slots = frame_arena::frames_in_flight;
+
+    // max_size bounds every capture
+    frame_capture(job_system& jobs, glm::ivec2 max_size);
+    // waits for the captures in flight
+    ~frame_capture();
+
+    frame_capture(const frame_capture&)            = delete;
+    frame_capture& operator=(const frame_capture&) = delete;
+
+    // reads rect of the bound read framebuffer, fn runs on a job thread
+    // once the pixels arrived. False when every slot is busy, the frame is
+    // then not captured
+    bool capture(glm::ivec4 rect, std::uint64_t frame, consumer fn);
+    // once per frame on the GL thread
+    void poll();
+    // blocks until every capture is consumed
+    void finish();
+
+    std::uint64_t dropped() const { return dropped_count; }
+
+private:
+    enum class state
+    {
+        idle,
+        reading,  // fence pending
+        consuming // mapped, a job reads it
+    };
+    struct slot
+    {
+        GLuint         pbo   = 0;
+        GLsync         fence = nullptr;
+        state          st    = state::idle;
+        captured_image image;
+        consumer       fn;
+        job_counter    done;
+    };
+
+    void start_consumer(slot& s);
+
+    job_system&   jobs;
+    std::size_t   slot_bytes;
+    slot          ring[slots];
+    int           next          = 0;
+    std::uint64_t dropped_count = 0;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_FRAME_CAPTURE_HXX
@@ -0,0 +1,164 @@
+#include "frame_recorder.hxx"
+
+#include <algorithm>
+#include <cstring>
+
+#include "frame_capture.hxx"
+
+namespace eng
+{
+frame_recorder::frame_recorder(const recording_config& config,
+                               glm::ivec2              size)
+    : cfg(config)
+    , size(size)
+    , file(config.path, std::ios::binary)
+{
+    cfg.every_nth    = std::max(cfg.every_nth, 1);
+    cfg.queue_frames = std::max<std::size_t>(cfg.queue_frames, 1);
+    opened           = static_cast<bool>(file);
+    if (cfg.format == recording_format::y4m)
+    {
+        file << "YUV4MPEG2 W" << size.x << " H" << size.y << " F" << cfg.fps
+             << ":1 Ip A1:1 C444\n";
+        planes.resize(static_cast<std::size_t>(size.x) * size.y * 3);
+    }
+    else
+    {
+        index.open(config.path + ".idx");
+        opened = opened && static_cast<bool>(index);
+        index << "rgba " << size.x << ' ' << size.y << '\n';
+    }
+    if (!opened)
+    {
+        return;
+    }
+    counters.bytes = static_cast<std::uint64_t>(file.tellp());
+
+    const std::size_t frame_bytes =
+        static_cast<std::size_t>(size.x) * size.y * 4;
+    for (std::size_t i = 0; i < cfg.queue_frames; ++i)
+    {
+        auto f = std::make_unique<queued_frame>();
+        f->pixels.resize(frame_bytes);
+        free_frames.push_back(std::move(f));
+    }
+    writer = std::thread(&frame_recorder::writer_loop, this);
+}
+
+recording_stats frame_recorder::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stop = true;
+    }
+    queue_cv.notify_one();
+    if (writer.joinable())
+    {
+        writer.join();
+        file.close();
+        index.close();
+    }
+    return stats();
+}
+
+void frame_recorder::submit(const captured_image& image)
+{
+    if (!opened || image.width != size.x || image.height != size.y)
+    {
+        return;
+    }
+    std::unique_ptr<queued_frame> f;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (free_frames.empty())
+        {
+            ++counters.dropped_queue;
+            return;
+        }
+        f = std::move(free_frames.back());
+        free_frames.pop_back();
+    }
+    // flip the bottom up rows while copying, the writer gets top down frames
+    const std::size_t row = static_cast<std::size_t>(size.x) * 4;
+    for (int y = 0; y < size.y; ++y)
+    {
+        std::memcpy(f->pixels.data() + row * y,
+                    image.pixels + row * (size.y - 1 - y),
+                    row);
+    }
+    f->frame = image.frame;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        ready_frames.push_back(std::move(f));
+    }
+    queue_cv.notify_one();
+}
+
+void frame_recorder::note_readback_drop()
+{
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    ++counters.dropped_readback;
+}
+
+recording_stats frame_recorder::stats() const
+{
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    return counters;
+}
+
+void frame_recorder::writer_loop()
+{
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    for (;;)
+    {
+        queue_cv.wait(lock, [this] { return stop || !ready_frames.empty(); });
+        if (ready_frames.empty())
+        {
+            return; // stopped and drained
+        }
+        std::unique_ptr<queued_frame> f = std::move(ready_frames.front());
+        ready_frames.pop_front();
+
+        lock.unlock();
+        write_frame(*f);
+        const auto written = static_cast<std::uint64_t>(file.tellp());
+        lock.lock();
+
+        counters.bytes = written;
+        ++counters.written;
+        free_frames.push_back(std::move(f));
+    }
+}
+
+void frame_recorder::write_frame(const queued_frame& f)
+{
+    if (cfg.format == recording_format::rgba)
+    {
+        index << f.frame << ' ' << file.tellp() << '\n';
+        file.write(reinterpret_cast<const char*>(f.pixels.data()),
+                   static_cast<std::streamsize>(f.pixels.size()));
+        return;
+    }
+    // BT.601 limited range, the y4m default players assume
+    const std::size_t   count = static_cast<std::size_t>(size.x) * size.y;
+    std::uint8_t*       py    = planes.data();
+    std::uint8_t*       pu    = py + count;
+    std::uint8_t*       pv    = pu + count;
+    const std::uint8_t* rgba  = f.pixels.data();
+    for (std::size_t i = 0; i < count; ++i, rgba += 4)
+    {
+        const int r = rgba[0];
+        const int g = rgba[1];
+        const int b = rgba[2];
+        py[i] = static_cast<std::uint8_t>(
+            ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        pu[i] = static_cast<std::uint8_t>(
+            ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        pv[i] = static_cast<std::uint8_t>(
+            ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+    file << "FRAME\n";
+    file.write(reinterpret_cast<const char*>(planes.data()),
+               static_cast<std::streamsize>(planes.size()));
+}
+} // namespace eng
@@ -0,0 +1,104 @@
+#ifndef OPENGL_WINDOW_FRAME_RECORDER_HXX
+#define OPENGL_WINDOW_FRAME_RECORDER_HXX
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace eng
+{
+struct captured_image;
+
+enum class recording_format
+{
+    // YUV4MPEG2 4:4:4, plays in ffmpeg and mpv, frames carry no numbers
+    y4m,
+    // top down RGBA frames back to back plus path.idx, a text index with
+    // the engine frame number and byte offset of every frame, so dropped
+    // frames show up as gaps
+    rgba
+};
+
+struct recording_config
+{
+    std::string      path;
+    recording_format format    = recording_format::y4m;
+    int              every_nth = 1;  // records frames numbered a multiple
+    int              fps       = 60; // written to the y4m header only
+    // frames waiting for the writer, a full queue drops the new frame
+    // instead of stalling the job that delivers it
+    std::size_t queue_frames = 8;
+};
+
+struct recording_stats
+{
+    std::uint64_t written          = 0;
+    std::uint64_t dropped_queue    = 0; // writer fell behind
+    std::uint64_t dropped_readback = 0; // no free readback slot
+    std::uint64_t bytes            = 0;
+};
+
+// writes captured frames to a file from its own thread. submit copies the
+// frame into one of queue_frames preallocated buffers, the writer thread
+// converts and writes them in order and hands the buffers back
+class frame_recorder
+{
+public:
+    frame_recorder(const recording_config& config, glm::ivec2 size);
+    ~frame_recorder() { close(); }
+
+    frame_recorder(const frame_recorder&)            = delete;
+    frame_recorder& operator=(const frame_recorder&) = delete;
+
+    // false when the file could not be created
+    bool good() const { return opened; }
+    bool wants(std::uint64_t frame) const
+    {
+        return frame % static_cast<std::uint64_t>(cfg.every_nth) == 0;
+    }
+
+    // any thread, image must have the size given to the constructor
+    void submit(const captured_image& image);
+    void note_readback_drop();
+
+    recording_stats stats() const;
+    // writes what is queued, closes the file and returns the final numbers.
+    // Nothing may be submitted afterwards
+    recording_stats close();
+
+private:
+    struct queued_frame
+    {
+        std::uint64_t             frame;
+        std::vector<std::uint8_t> pixels; // top down RGBA
+    };
+
+    void writer_loop();
+    void write_frame(const queued_frame& f);
+
+    recording_config cfg;
+    glm::ivec2       size;
+    bool             opened = false;
+    std::ofstream    file;
+    std::ofstream    index;
+
+    mutable std::mutex                         queue_mutex;
+    std::condition_variable                    queue_cv;
+    std::vector<std::unique_ptr<queued_frame>> free_frames;
+    std::deque<std::unique_ptr<queued_frame>>  ready_frames;
+    recording_stats                            counters;
+    bool                                       stop = false;
+
+    std::vector<std::uint8_t> planes; // y4m conversion, writer thread only
+    std::thread               writer;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_FRAME_RECORDER_HXX
@@ -1,8 +1,25 @@
 #include "engine.hxx"
+#include "flow_field.hxx"
+#include "gpu_particles.hxx"
+#include "kinematics.hxx"
+#include "particles.hxx"
+#include "projectiles.hxx"
+#include "sprite_renderer.hxx"
+#include "tilemap.hxx"
+#include "unit_grid.hxx"
 #include <SDL_events.h>
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
 #include <cstdlib>
 #include <fstream>
+#include <functional>
+#include <iostream>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace eng;
 int main()
@@ -11,32 +28,179 @@ int main()
     std::unique_ptr<eng::engine, void (*)(eng::engine*)> engine(
         eng::create_engine(), eng::destroy_engine);
 
-    engine->initialize_engine();
+    // heavy scenes drop the render resolution instead of the frame rate,
+    // where the driver can time the GPU
+    eng::engine_config config;
+    config.dynamic_resolution = true;
+    // OPENGL_WINDOW_GL_TRACE=run.gltrace records the session for gl_replay
+    if (const char* trace_path = std::getenv("OPENGL_WINDOW_GL_TRACE"))
+    {
+        config.gl_trace = trace_path;
+    }
+    engine->initialize_engine(config);
 
-    int tex_fone = engine->load_texture("fone.png");
-    int tex_tank = engine->load_texture("tank.png");
+    const std::vector<int> textures =
+        engine->load_textures({ "fone.png", "tank.png" });
+    int tex_fone = textures[0];
+    int tex_tank = textures[1];
 
-    eng::vertex   v0 = { 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 2.0f, 1.0f };
-    eng::vertex   v1 = { 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 2.0f, 0.0f };
-    eng::vertex   v2 = { -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
-    eng::vertex   v3 = { -1.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f };
-    eng::triangle t1(v0, v1, v2);
-    eng::triangle t2(v3, v2, v1);
+    // the background is one tile of fone.png repeated over the whole map, a
+    // tile covers the same area the stretched fone.png used to
+    const glm::ivec2 map_size{ 256, 128 };
+    eng::tilemap     background(
+        map_size,
+        glm::vec2(1.0f, 2.0f),
+        glm::vec2(-1.0f, -1.0f),
+        eng::tileset{ tex_fone, 1, 1 },
+        eng::make_grid_loader(
+            std::vector<std::uint16_t>(map_size.x * map_size.y, 0), map_size));
 
-    eng::vertex   v4 = { -0.9f, -0.9f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f };
-    eng::vertex   v5 = { -0.9f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f };
-    eng::vertex   v6 = { -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
-    eng::vertex   v7 = { -1.0f, -0.9f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f };
+    // the tank is the unit quad, its model matrix comes from the
+    // kinematics. The art faces down, a quarter turn from the +x heading
+    eng::vertex   v4 = { 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f };
+    eng::vertex   v5 = { 0.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f };
+    eng::vertex   v6 = { -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+    eng::vertex   v7 = { -0.5f, 0.5f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f };
     eng::triangle t3(v4, v5, v6);
     eng::triangle t4(v7, v6, v5);
-    glm::mat4     transform = glm::mat4(1.0f);
-    transform               = glm::scale(transform, glm::vec3(1, 1, 1));
-
-    glm::mat4 transform0    = glm::mat4(1.0f);
-    float     angle         = 0.0f;
-    float     dx            = 0.0f;
-    float     dy            = 0.0f;
-    bool      continue_loop = true;
+    glm::mat4     transform    = glm::mat4(1.0f);
+    const float   quarter_turn = 1.57079633f;
+    const float   tank_size    = 0.1f;
+
+    eng::kinematics_desc drive_desc;
+    drive_desc.max_speed  = 1.5f;
+    drive_desc.damping    = 2.0f;
+    drive_desc.bounds_min = glm::vec2(-1.0f, -1.0f);
+    drive_desc.bounds_max =
+        drive_desc.bounds_min + glm::vec2(map_size.x * 1.0f, map_size.y * 2.0f);
+    drive_desc.radius = tank_size * 0.5f;
+    // the player's tank first, then a pack of them hunting it
+    const std::size_t    pack = 200;
+    eng::unit_kinematics units(drive_desc, 1 + pack);
+    const std::size_t    tank =
+        units.add(glm::vec2(-0.95f, -0.95f), quarter_turn);
+    for (std::size_t i = 0; i < pack; ++i)
+    {
+        units.add(glm::vec2(-0.2f + 0.12f * (i % 20), 0.3f + 0.12f * (i / 20)),
+                  quarter_turn);
+    }
+    // pathfinding over the background's tiles, the pack shares the field
+    // toward the tile under the player
+    eng::flow_field_cache paths(
+        map_size, glm::vec2(1.0f, 2.0f), glm::vec2(-1.0f, -1.0f));
+    // a solve takes milliseconds, too long for a frame, so the field toward
+    // a new player tile is solved on a thread of its own while the pack
+    // keeps following the last one ready. The solver pins the field it
+    // published and a frame pins the one it steers by, the cache never
+    // evicts a pinned field
+    std::mutex              solve_mutex;
+    std::condition_variable solve_wake;
+
+    glm::ivec2             wanted       = paths.tile_at(units.position(tank));
+    glm::ivec2             ready_for    = wanted;
+    const eng::flow_field* ready        = &paths.field(wanted, engine->jobs());
+    bool                   stop_solving = false;
+    eng::flow_field_cache::pin(*ready);
+    std::thread            solver(
+        [&]
+        {
+            std::unique_lock<std::mutex> lock(solve_mutex);
+            for (;;)
+            {
+                solve_wake.wait(
+                    lock, [&] { return stop_solving || wanted != ready_for; });
+                if (stop_solving)
+                {
+                    return;
+                }
+                const glm::ivec2 target = wanted;
+                lock.unlock();
+                const eng::flow_field& solved = paths.field(target);
+                lock.lock();
+                eng::flow_field_cache::pin(solved);
+                eng::flow_field_cache::unpin(*ready);
+                ready     = &solved;
+                ready_for = target;
+            }
+        });
+
+    // shells are swept against a grid of the unit boxes rebuilt every
+    // frame, a cell per background tile
+    eng::unit_grid grid(drive_desc.bounds_min, drive_desc.bounds_max, 1.0f);
+    eng::projectile_pool     shells(1024);
+    const float              shell_speed = 4.0f;
+    const float              shell_life  = 1.5f;
+    const glm::vec2          shell_size(0.03f, 0.01f);
+    std::vector<std::size_t> destroyed;
+    // spread in radians of the shells one shot fires
+    auto fire = [&](const std::vector<float>& spread)
+    {
+        const float     heading = units.angle(tank);
+        const glm::vec2 muzzle =
+            units.position(tank) +
+            glm::vec2(std::cos(heading), std::sin(heading)) *
+                (tank_size * 0.5f);
+        for (const float offset : spread)
+        {
+            const float a = heading + offset;
+            shells.fire(muzzle,
+                        glm::vec2(std::cos(a), std::sin(a)) * shell_speed +
+                            units.velocity(tank),
+                        shell_life,
+                        static_cast<std::uint32_t>(tank));
+        }
+    };
+
+    eng::camera view;
+    // one world unit per pixel, y up, for text on top of the scene
+    eng::camera screen;
+    screen.extent   = glm::vec2(eng::width, eng::height);
+    screen.position = screen.extent * 0.5f;
+    const int font  = engine->load_font("");
+
+    // exhaust smoke trailing the tank
+    eng::particle_emitter_desc smoke_desc;
+    smoke_desc.rate        = 60.f;
+    smoke_desc.life_min    = 0.6f;
+    smoke_desc.life_max    = 1.2f;
+    smoke_desc.speed_min   = 0.02f;
+    smoke_desc.speed_max   = 0.06f;
+    smoke_desc.gravity     = glm::vec2(0.0f, 0.05f);
+    smoke_desc.drag        = 1.0f;
+    smoke_desc.color_start = glm::vec4(0.5f, 0.5f, 0.5f, 0.6f);
+    smoke_desc.color_end   = glm::vec4(0.3f, 0.3f, 0.3f, 0.0f);
+    eng::particle_emitter smoke(smoke_desc);
+    // the same smoke simulated by compute shaders when the context has them
+    std::unique_ptr<eng::gpu_particle_system> gpu_smoke;
+    if (engine->compute_supported())
+    {
+        gpu_smoke = std::make_unique<eng::gpu_particle_system>(smoke_desc);
+    }
+    // OPENGL_WINDOW_RECORD=run.y4m records the session, any other extension
+    // writes raw RGBA frames with an index. OPENGL_WINDOW_RECORD_EVERY=n
+    // keeps every nth frame only
+    if (const char* record_path = std::getenv("OPENGL_WINDOW_RECORD"))
+    {
+        eng::recording_config recording;
+        recording.path = record_path;
+        const bool y4m = recording.path.size() >= 4 &&
+                         recording.path.compare(
+                             recording.path.size() - 4, 4, ".y4m") == 0;
+        recording.format =
+            y4m ? eng::recording_format::y4m : eng::recording_format::rgba;
+        if (const char* every = std::getenv("OPENGL_WINDOW_RECORD_EVERY"))
+        {
+            recording.every_nth = std::atoi(every);
+        }
+        engine->start_recording(recording);
+    }
+    std::uint64_t last_ticks    = SDL_GetTicks();
+    bool          forward       = false;
+    bool          backward      = false;
+    bool          left          = false;
+    bool          right         = false;
+    bool          continue_loop = true;
+    int           screenshots   = 0;
     while (continue_loop)
     {
         SDL_Event e;
@@ -48,43 +212,188 @@ int main()
                 continue_loop = false;
                 break;
             }
-            if (e.type == SDL_EVENT_KEY_DOWN)
+            if (e.type == SDL_EVENT_KEY_DOWN || e.type == SDL_EVENT_KEY_UP)
             {
-                if (e.key.keysym.sym == SDLK_w)
+                // driving follows the keys held, not the repeats
+                const bool down = e.type == SDL_EVENT_KEY_DOWN;
+                switch (e.key.keysym.sym)
                 {
-                    dy += 0.01f;
-                    angle = -180.0f;
+                    case SDLK_w:
+                        forward = down;
+                        break;
+                    case SDLK_s:
+                        backward = down;
+                        break;
+                    case SDLK_a:
+                        left = down;
+                        break;
+                    case SDLK_d:
+                        right = down;
+                        break;
+                    default:
+                        break;
                 }
-                if (e.key.keysym.sym == SDLK_s)
+            }
+            if (e.type == SDL_EVENT_KEY_DOWN && !e.key.repeat)
+            {
+                // the keys engine::get_input binds to event::button_one and
+                // event::button_two: a single shell and a spread of three
+                if (e.key.keysym.sym == SDLK_LCTRL)
+                {
+                    fire({ 0.0f });
+                }
+                if (e.key.keysym.sym == SDLK_SPACE)
                 {
-                    dy -= 0.01f;
-                    angle = 0;
+                    fire({ -0.15f, 0.0f, 0.15f });
                 }
-                if (e.key.keysym.sym == SDLK_d)
+            }
+            if (e.type == SDL_EVENT_KEY_DOWN)
+            {
+                // the key engine::get_input binds to event::select
+                if (e.key.keysym.sym == SDLK_ESCAPE)
                 {
-                    dx += 0.01f;
-                    angle = -90.0f;
+                    engine->toggle_overlay();
                 }
-                if (e.key.keysym.sym == SDLK_a)
+                if (e.key.keysym.sym == SDLK_F12)
                 {
-                    dx -= 0.01f;
-                    angle = 90.0f;
+                    engine->save_screenshot(
+                        "screenshot_" + std::to_string(screenshots++) + ".png");
                 }
             }
         }
-        transform = glm::translate(transform, glm::vec3(dx, dy, 0.0f));
-        // transform = glm::translate(transform, glm::vec3(1.0f, 1.0f, 0.0f));
-        //  transform = glm::rotate(
-        //  transform, glm::radians(angle), glm::vec3(0.0, 0.0, 1.0));
-        //  transform = glm::translate(transform, glm::vec3(-1.0f, -1.0f,
-        //  0.0f));
-        engine->draw_texture(t1, t2, tex_fone, transform0);
+        const std::uint64_t ticks = SDL_GetTicks();
+        const float         dt    = (ticks - last_ticks) / 1000.0f;
+        last_ticks                = ticks;
+        units.drive(tank,
+                    3.0f * (static_cast<float>(forward) - backward),
+                    2.5f * (static_cast<float>(left) - right));
+        // a lookup per tank, turning toward the way and driving once it
+        // faces it. On the player's own tile they go straight for it
+        const glm::vec2        player = units.position(tank);
+        const eng::flow_field* field  = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(solve_mutex);
+            wanted = paths.tile_at(player);
+            field  = ready;
+            eng::flow_field_cache::pin(*field);
+        }
+        solve_wake.notify_one();
+        const eng::flow_field& to_player = *field;
+        for (std::size_t u = tank + 1; u < units.size(); ++u)
+        {
+            const glm::vec2 p   = units.position(u);
+            glm::vec2       way = to_player.direction(p);
+            if (to_player.remaining(p) == 0.0f)
+            {
+                const glm::vec2 to = player - p;
+                way = glm::length(to) > 3.0f * tank_size ? glm::normalize(to)
+                                                         : glm::vec2(0.0f);
+            }
+            if (way.x == 0.0f && way.y == 0.0f)
+            {
+                units.drive(u, 0.0f, 0.0f);
+                continue;
+            }
+            const float turn = std::remainder(
+                std::atan2(way.y, way.x) - units.angle(u), 6.28318531f);
+            units.drive(u,
+                        2.0f * std::max(0.0f, std::cos(turn)),
+                        std::clamp(4.0f * turn, -2.0f, 2.0f));
+        }
+        eng::flow_field_cache::unpin(to_player);
+        units.step(dt);
+
+        // a tank of the pack hit by a shell is gone. Removal moves the last
+        // unit into the hole, so the highest indices go first
+        grid.build(units.x(), units.y(), units.size(), drive_desc.radius);
+        shells.update(dt, grid);
+        destroyed.clear();
+        for (std::size_t h = 0; h < shells.hit_count(); ++h)
+        {
+            destroyed.push_back(shells.hits()[h].unit);
+        }
+        std::sort(destroyed.begin(), destroyed.end(), std::greater<>());
+        destroyed.erase(std::unique(destroyed.begin(), destroyed.end()),
+                        destroyed.end());
+        for (const std::size_t unit : destroyed)
+        {
+            units.remove(unit);
+        }
+
+        units.write_transforms(
+            &transform, tank, 1, glm::vec2(tank_size), quarter_turn);
+
+        // the camera follows the tank
+        const glm::vec2 at = units.position(tank);
+        view.position      = at;
+        engine->set_camera(view);
+
+        background.update(view);
+        background.draw();
+
+        const float     heading = units.angle(tank);
+        const glm::vec2 exhaust =
+            at - glm::vec2(std::cos(heading), std::sin(heading)) *
+                     (tank_size * 0.5f);
+        if (gpu_smoke)
+        {
+            gpu_smoke->position = exhaust;
+            gpu_smoke->update(dt);
+            engine->draw_particles(*gpu_smoke);
+        }
+        else
+        {
+            smoke.position = exhaust;
+            smoke.update(dt, engine->jobs());
+            engine->draw_particles(smoke);
+        }
+        // the pack in one instanced draw
+        const std::size_t hunters = units.size() - 1;
+        if (eng::sprite_instance* out = engine->map_sprite_instances(hunters))
+        {
+            units.write_instances(
+                out, tank + 1, hunters, glm::vec2(tank_size), quarter_turn);
+            for (std::size_t i = 0; i < hunters; ++i)
+            {
+                out[i].uv = eng::atlas_rect{};
+            }
+            engine->draw_sprite_instances(tex_tank);
+        }
         engine->draw_texture(t3, t4, tex_tank, transform);
+        // every shell in one instanced draw, plain white quads
+        if (eng::sprite_instance* out =
+                engine->map_sprite_instances(shells.size()))
+        {
+            shells.write_instances(out, shells.size(), shell_size);
+            engine->draw_sprite_instances(0);
+        }
+
+        engine->set_camera(screen);
+        engine->draw_text(font,
+                          "WASD to drive, CTRL or SPACE to fire",
+                          glm::vec2(8.0f, 32.0f),
+                          24.0f,
+                          glm::vec3(1.0f, 1.0f, 1.0f));
         engine->swap_buff();
-        dx    = 0.0f;
-        dy    = 0.0f;
-        angle = 0.0f;
     }
+    {
+        std::lock_guard<std::mutex> lock(solve_mutex);
+        stop_solving = true;
+    }
+    solve_wake.notify_one();
+    solver.join();
 
+    const eng::recording_stats recorded = engine->stop_recording();
+    if (recorded.written != 0)
+    {
+        std::cout << "recorded " << recorded.written << " frames, "
+                  << recorded.bytes << " bytes, dropped "
+                  << recorded.dropped_queue << " behind the writer and "
+                  << recorded.dropped_readback << " at readback" << std::endl;
+    }
+    const eng::frame_arena::usage arena = engine->frame_memory().stats();
+    std::cout << "frame arena peak " << arena.peak << " of " << arena.capacity
+              << " bytes, " << arena.overflows << " heap fallbacks"
+              << std::endl;
     return EXIT_SUCCESS;
 }
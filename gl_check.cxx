@@ -0,0 +1,102 @@
+#include "gl_check.hxx"
+
+#include <cstdint>
+#include <string_view>
+
+namespace eng
+{
+namespace
+{
+struct error_site
+{
+    const char*   file;
+    int           line;
+    const char*   what;
+    GLenum        error;
+    std::uint32_t count;
+};
+
+// sites with errors since the last report, a frame rarely has more than a
+// couple and a full table only loses the attribution, not the count
+constexpr int max_sites = 32;
+error_site    sites[max_sites];
+int           site_count   = 0;
+std::uint32_t unattributed = 0;
+
+const char* error_name(GLenum error)
+{
+    switch (error)
+    {
+        case GL_INVALID_ENUM:
+            return "GL_INVALID_ENUM";
+        case GL_INVALID_VALUE:
+            return "GL_INVALID_VALUE";
+        case GL_INVALID_OPERATION:
+            return "GL_INVALID_OPERATION";
+        case GL_INVALID_FRAMEBUFFER_OPERATION:
+            return "GL_INVALID_FRAMEBUFFER_OPERATION";
+        case GL_OUT_OF_MEMORY:
+            return "GL_OUT_OF_MEMORY";
+    }
+    return "unknown GL error";
+}
+} // namespace
+
+void gl_check_record(GLenum      error,
+                     const char* file,
+                     int         line,
+                     const char* what)
+{
+    for (int i = 0; i < site_count; ++i)
+    {
+        error_site& s = sites[i];
+        if (s.line == line && s.file == file && s.error == error)
+        {
+            ++s.count;
+            return;
+        }
+    }
+    if (site_count == max_sites)
+    {
+        ++unattributed;
+        return;
+    }
+    sites[site_count++] = { file, line, what, error, 1 };
+}
+
+#if OPENGL_WINDOW_GL_CHECK_LEVEL >= OPENGL_WINDOW_GL_CHECK_PER_FRAME
+void gl_check_end_frame(std::ostream& out)
+{
+    // per call checks leave nothing behind, per frame builds learn here
+    // that the frame went wrong somewhere
+    gl_check_site(nullptr, 0, "the frame");
+    for (int i = 0; i < site_count; ++i)
+    {
+        const error_site& s = sites[i];
+        // OM_GL passes the call as written, keep the function name
+        const std::string_view what(s.what);
+        out << error_name(s.error);
+        if (s.count > 1)
+        {
+            out << " x" << s.count;
+        }
+        out << " in " << what.substr(0, what.find('('));
+        if (s.file)
+        {
+            out << " at " << s.file << ':' << s.line;
+        }
+        out << '\n';
+    }
+    if (unattributed != 0)
+    {
+        out << unattributed << " more GL errors at other sites\n";
+    }
+    if (site_count != 0 || unattributed != 0)
+    {
+        out.flush();
+    }
+    site_count   = 0;
+    unattributed = 0;
+}
+#endif
+} // namespace eng
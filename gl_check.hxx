@@ -0,0 +1,81 @@
+#ifndef OPENGL_WINDOW_GL_CHECK_HXX
+#define OPENGL_WINDOW_GL_CHECK_HXX
+#include <cassert>
+#include <iostream>
+
+#include "glad/glad.h"
+
+// how much glGetError the build pays for, set by the
+// OPENGL_WINDOW_GL_CHECK CMake cache entry:
+//   off        no checks at all
+//   per_frame  one glGetError loop per presented frame
+//   per_call   after every OM_GL_CHECK and OM_GL, errors carry the site
+#define OPENGL_WINDOW_GL_CHECK_OFF 0
+#define OPENGL_WINDOW_GL_CHECK_PER_FRAME 1
+#define OPENGL_WINDOW_GL_CHECK_PER_CALL 2
+
+#ifndef OPENGL_WINDOW_GL_CHECK_LEVEL
+#ifdef NDEBUG
+#define OPENGL_WINDOW_GL_CHECK_LEVEL OPENGL_WINDOW_GL_CHECK_OFF
+#else
+#define OPENGL_WINDOW_GL_CHECK_LEVEL OPENGL_WINDOW_GL_CHECK_PER_CALL
+#endif
+#endif
+
+namespace eng
+{
+// counts error at the site, what is the checked call as written or the
+// name of the last call a check covers. GL thread only
+void gl_check_record(GLenum      error,
+                     const char* file,
+                     int         line,
+                     const char* what);
+
+inline void gl_check_site(const char* file, int line, const char* what)
+{
+    // several error flags can be set at once, a lost context keeps one
+    // set, so the loop is bounded
+    for (int i = 0; i < 8; ++i)
+    {
+        const GLenum error = glGetError();
+        if (error == GL_NO_ERROR)
+        {
+            return;
+        }
+        gl_check_record(error, file, line, what);
+    }
+}
+
+#if OPENGL_WINDOW_GL_CHECK_LEVEL >= OPENGL_WINDOW_GL_CHECK_PER_FRAME
+// collects what the frame left behind and writes every error counted since
+// the previous call, grouped by site. Once per presented frame
+void gl_check_end_frame(std::ostream& out);
+#else
+inline void gl_check_end_frame(std::ostream&) {}
+#endif
+} // namespace eng
+
+#if OPENGL_WINDOW_GL_CHECK_LEVEL >= OPENGL_WINDOW_GL_CHECK_PER_CALL
+// checks everything since the previous check, attributed to this line and
+// named after the last GL call it covers: OM_GL_CHECK(glBufferData)
+#define OM_GL_CHECK(last_call)                                                 \
+    {                                                                          \
+        ::eng::gl_check_site(__FILE__, __LINE__, #last_call);                  \
+    }
+// makes the GL call and checks it alone: OM_GL(glBindBuffer(target, b));
+#define OM_GL(call)                                                            \
+    {                                                                          \
+        call;                                                                  \
+        ::eng::gl_check_site(__FILE__, __LINE__, #call);                       \
+    }
+#else
+#define OM_GL_CHECK(last_call)                                                 \
+    {                                                                          \
+    }
+#define OM_GL(call)                                                            \
+    {                                                                          \
+        call;                                                                  \
+    }
+#endif
+
+#endif // OPENGL_WINDOW_GL_CHECK_HXX
@@ -0,0 +1,502 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "glad/glad.h"
+
+#include "gl_trace_format.hxx"
+#include "headless_context.hxx"
+
+// plays a trace written through engine_config::gl_trace back on a headless
+// context the size of the traced window and reports where the time goes:
+//   gl_replay trace.gltrace [functions_listed]
+// every call is timed on the CPU, every frame additionally until glFinish
+// returns. Object names, uniform locations and fences are used as
+// recorded, which holds on a fresh context of the same driver since names
+// are handed out in creation order; created names that differ are counted
+
+namespace
+{
+using clock = std::chrono::steady_clock;
+using eng::gl_traced;
+using eng::trace_pointer;
+
+class trace_reader
+{
+public:
+    trace_reader(const std::uint8_t* first, const std::uint8_t* last)
+        : at(first)
+        , end(last)
+    {
+    }
+
+    bool done() const { return at == end; }
+
+    template <typename T>
+    T value()
+    {
+        T v{};
+        if (static_cast<std::size_t>(end - at) < sizeof(T))
+        {
+            failed = true;
+            at     = end;
+            return v;
+        }
+        std::memcpy(&v, at, sizeof(T));
+        at += sizeof(T);
+        return v;
+    }
+    const std::uint8_t* bytes(std::size_t n)
+    {
+        if (static_cast<std::size_t>(end - at) < n)
+        {
+            failed = true;
+            at     = end;
+            return nullptr;
+        }
+        const std::uint8_t* p = at;
+        at += n;
+        return p;
+    }
+
+    bool failed = false;
+
+private:
+    const std::uint8_t* at;
+    const std::uint8_t* end;
+};
+
+// keyed by buffer name like the trace, names are replayed as recorded
+struct mapping
+{
+    GLuint        buffer;
+    std::uint8_t* data;
+};
+
+GLuint bound_buffer(GLenum target)
+{
+    const GLenum binding = eng::gl_buffer_binding(target);
+    GLint        buffer  = 0;
+    if (binding != GL_NONE)
+    {
+        glGetIntegerv(binding, &buffer);
+    }
+    return static_cast<GLuint>(buffer);
+}
+
+struct replay_state
+{
+    explicit replay_state(trace_reader reader)
+        : in(reader)
+    {
+        scratch.resize(1 << 16);
+    }
+
+    trace_reader               in;
+    std::vector<std::uint8_t>  scratch; // whatever output arguments get
+    std::vector<const GLchar*> sources;
+    std::unordered_map<std::uint64_t, GLsync> fences;
+    std::vector<mapping>                      mappings;
+    const char*                               missing        = nullptr;
+    std::uint64_t                             names_differed = 0;
+};
+
+// data pointers point straight into the loaded trace, it outlives the call
+template <typename T>
+T read_arg(replay_state& s)
+{
+    if constexpr (std::is_same_v<T, GLsync>)
+    {
+        const auto it = s.fences.find(s.in.value<std::uint64_t>());
+        return it == s.fences.end() ? nullptr : it->second;
+    }
+    else if constexpr (!std::is_pointer_v<T>)
+    {
+        return s.in.value<T>();
+    }
+    else
+    {
+        switch (s.in.value<trace_pointer>())
+        {
+            case trace_pointer::null:
+                return nullptr;
+            case trace_pointer::offset:
+                return reinterpret_cast<T>(static_cast<std::uintptr_t>(
+                    s.in.value<std::uint64_t>()));
+            case trace_pointer::data:
+            {
+                const auto          size = s.in.value<std::uint32_t>();
+                const std::uint8_t* p    = s.in.bytes(size);
+                if constexpr (std::is_same_v<T, const GLchar* const*>)
+                {
+                    // glShaderSource, terminated strings back to back
+                    s.sources.clear();
+                    for (std::uint32_t i = 0; p && i < size;)
+                    {
+                        const auto* text =
+                            reinterpret_cast<const GLchar*>(p + i);
+                        s.sources.push_back(text);
+                        i += static_cast<std::uint32_t>(std::strlen(text));
+                        ++i;
+                    }
+                    return s.sources.data();
+                }
+                else if constexpr (std::is_const_v<std::remove_pointer_t<T>>)
+                {
+                    return reinterpret_cast<T>(p);
+                }
+                else
+                {
+                    // the writer never stores data GL would write over
+                    s.in.failed = true;
+                    return nullptr;
+                }
+            }
+            case trace_pointer::output:
+            {
+                // a second output of the same call shares the buffer,
+                // nothing reads either
+                const auto size = s.in.value<std::uint32_t>();
+                if (size > s.scratch.size())
+                {
+                    s.scratch.resize(size);
+                }
+                return reinterpret_cast<T>(s.scratch.data());
+            }
+        }
+        s.in.failed = true;
+        return nullptr;
+    }
+}
+
+template <gl_traced C, typename Args, typename R>
+void after_call(replay_state& s, const Args& args, R result)
+{
+    using G = gl_traced;
+    if constexpr (std::is_same_v<R, GLsync>)
+    {
+        s.fences[s.in.value<std::uint64_t>()] = result;
+    }
+    else if constexpr (!std::is_pointer_v<R>)
+    {
+        const R recorded = s.in.value<R>();
+        if constexpr (C == G::fn_glCreateProgram ||
+                      C == G::fn_glCreateShader ||
+                      C == G::fn_glGetUniformLocation)
+        {
+            s.names_differed += recorded != result;
+        }
+    }
+    if constexpr (C == G::fn_glMapBufferRange)
+    {
+        if (result)
+        {
+            s.mappings.push_back({ bound_buffer(std::get<0>(args)),
+                                   static_cast<std::uint8_t*>(result) });
+        }
+    }
+    else if constexpr (C == G::fn_glUnmapBuffer)
+    {
+        const GLuint buffer = bound_buffer(std::get<0>(args));
+        const auto   it     = std::find_if(s.mappings.begin(),
+                                     s.mappings.end(),
+                                     [buffer](const mapping& m)
+                                     { return m.buffer == buffer; });
+        if (it != s.mappings.end())
+        {
+            *it = s.mappings.back();
+            s.mappings.pop_back();
+        }
+    }
+}
+
+// reads the arguments of the call at Slot, makes it and returns the
+// nanoseconds it took
+template <gl_traced C,
+          auto*      Slot,
+          typename F = std::remove_pointer_t<decltype(Slot)>>
+struct replayed;
+
+template <gl_traced C, auto* Slot, typename R, typename... A>
+struct replayed<C, Slot, R(APIENTRY*)(A...)>
+{
+    static double run(replay_state& s, const char* name)
+    {
+        std::tuple<A...> args{ read_arg<A>(s)... };
+        if (s.in.failed)
+        {
+            return 0.0;
+        }
+        if (!*Slot)
+        {
+            s.missing   = name;
+            s.in.failed = true;
+            return 0.0;
+        }
+        const clock::time_point start = clock::now();
+        if constexpr (std::is_void_v<R>)
+        {
+            std::apply(*Slot, args);
+            return std::chrono::duration<double, std::nano>(clock::now() -
+                                                            start)
+                .count();
+        }
+        else
+        {
+            const R      result = std::apply(*Slot, args);
+            const double ns = std::chrono::duration<double, std::nano>(
+                                  clock::now() - start)
+                                  .count();
+            after_call<C>(s, args, result);
+            return ns;
+        }
+    }
+};
+
+struct replay_function
+{
+    const char* name;
+    double (*run)(replay_state&, const char*);
+};
+
+#define OM_GL_REPLAY_ENTRY(name)                                               \
+    { #name, &replayed<gl_traced::fn_##name, &glad_##name>::run },
+const replay_function replay_functions[] = { OM_GL_TRACED_FUNCTIONS(
+    OM_GL_REPLAY_ENTRY) };
+#undef OM_GL_REPLAY_ENTRY
+
+struct function_time
+{
+    const replay_function* function = nullptr;
+    std::uint64_t          calls    = 0;
+    double                 total_ns = 0.0;
+    double                 max_ns   = 0.0;
+};
+
+struct frame_time
+{
+    double calls_ms;
+    double finish_ms;
+};
+
+bool read_file(const char* path, std::vector<std::uint8_t>& bytes)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return false;
+    }
+    bytes.resize(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(bytes.data()),
+              static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(file);
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    const std::size_t i =
+        static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+void report(const std::vector<function_time>& functions,
+            const std::vector<frame_time>&    frames,
+            std::size_t                       listed)
+{
+    std::vector<double> totals;
+    for (const frame_time& f : frames)
+    {
+        totals.push_back(f.calls_ms + f.finish_ms);
+    }
+    std::sort(totals.begin(), totals.end());
+    std::cout << std::fixed << std::setprecision(3);
+    if (!totals.empty())
+    {
+        double sum = 0.0;
+        for (double t : totals)
+        {
+            sum += t;
+        }
+        std::cout << "frame ms (calls + finish): mean " << sum / totals.size()
+                  << " p50 " << percentile(totals, 0.5) << " p99 "
+                  << percentile(totals, 0.99) << " max " << totals.back()
+                  << "\n";
+    }
+
+    std::vector<function_time> sorted;
+    for (const function_time& f : functions)
+    {
+        if (f.calls != 0)
+        {
+            sorted.push_back(f);
+        }
+    }
+    std::sort(sorted.begin(),
+              sorted.end(),
+              [](const function_time& a, const function_time& b)
+              { return a.total_ns > b.total_ns; });
+    std::cout << std::left << std::setw(28) << "function" << std::right
+              << std::setw(10) << "calls" << std::setw(12) << "total ms"
+              << std::setw(12) << "mean us" << std::setw(12) << "max us"
+              << "\n";
+    for (std::size_t i = 0; i < sorted.size() && i < listed; ++i)
+    {
+        const function_time& f = sorted[i];
+        std::cout << std::left << std::setw(28) << f.function->name
+                  << std::right << std::setw(10) << f.calls << std::setw(12)
+                  << f.total_ns * 1e-6 << std::setw(12)
+                  << f.total_ns * 1e-3 / f.calls << std::setw(12)
+                  << f.max_ns * 1e-3 << "\n";
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: gl_replay trace.gltrace [functions_listed]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::size_t listed =
+        argc > 2 ? std::stoul(argv[2]) : std::size_t{ 25 };
+
+    std::vector<std::uint8_t> bytes;
+    if (!read_file(argv[1], bytes))
+    {
+        std::cerr << "gl_replay: can't read " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+    trace_reader        header(bytes.data(), bytes.data() + bytes.size());
+    const std::uint8_t* magic = header.bytes(sizeof(eng::gl_trace_magic));
+    if (!magic ||
+        std::memcmp(magic, eng::gl_trace_magic, sizeof(eng::gl_trace_magic)))
+    {
+        std::cerr << "gl_replay: " << argv[1] << " is no GL trace"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    const auto width  = header.value<std::uint32_t>();
+    const auto height = header.value<std::uint32_t>();
+    const auto count  = header.value<std::uint16_t>();
+
+    // the trace numbers functions the way the writer's list did
+    std::vector<function_time> functions(count);
+    for (function_time& f : functions)
+    {
+        const auto          length = header.value<std::uint8_t>();
+        const std::uint8_t* name   = header.bytes(length);
+        const std::string   traced(reinterpret_cast<const char*>(name),
+                                 name ? length : 0);
+        for (const replay_function& r : replay_functions)
+        {
+            if (traced == r.name)
+            {
+                f.function = &r;
+            }
+        }
+        if (!f.function)
+        {
+            std::cerr << "gl_replay: can't replay " << traced << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (header.failed)
+    {
+        std::cerr << "gl_replay: " << argv[1] << " is truncated" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    eng::headless_context context;
+    std::string           error;
+    if (!context.create(
+            error, static_cast<int>(width), static_cast<int>(height)))
+    {
+        std::cerr << "gl_replay: no context: " << error << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (gladLoadGLES2Loader(eng::headless_context::get_proc_address) == 0)
+    {
+        std::cerr << "gl_replay: failed to initialize glad" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    replay_state            s(header);
+    std::vector<frame_time> frames;
+    double                  frame_calls_ns = 0.0;
+    std::uint64_t           calls          = 0;
+    while (!s.in.done() && !s.in.failed)
+    {
+        const auto id = s.in.value<std::uint16_t>();
+        if (id == eng::frame_record)
+        {
+            const clock::time_point start = clock::now();
+            glFinish();
+            frames.push_back(
+                { frame_calls_ns * 1e-6,
+                  std::chrono::duration<double, std::milli>(clock::now() -
+                                                            start)
+                      .count() });
+            frame_calls_ns = 0.0;
+        }
+        else if (id == eng::mapped_record)
+        {
+            const auto          buffer = s.in.value<std::uint32_t>();
+            const auto          offset = s.in.value<std::uint64_t>();
+            const auto          size   = s.in.value<std::uint32_t>();
+            const std::uint8_t* data   = s.in.bytes(size);
+            for (const mapping& m : s.mappings)
+            {
+                if (data && m.buffer == buffer)
+                {
+                    std::memcpy(m.data + offset, data, size);
+                    break;
+                }
+            }
+        }
+        else if (id < functions.size())
+        {
+            function_time& f  = functions[id];
+            const double   ns = f.function->run(s, f.function->name);
+            ++f.calls;
+            f.total_ns += ns;
+            f.max_ns = std::max(f.max_ns, ns);
+            frame_calls_ns += ns;
+            ++calls;
+        }
+        else
+        {
+            s.in.failed = true;
+        }
+    }
+
+    std::cout << argv[1] << ": " << width << "x" << height << ", "
+              << frames.size() << " frames, " << calls << " calls\n";
+    if (s.missing)
+    {
+        std::cout << "stopped: this context has no " << s.missing << "\n";
+    }
+    else if (s.in.failed)
+    {
+        std::cout << "stopped: the trace ends inside a record\n";
+    }
+    if (s.names_differed != 0)
+    {
+        std::cout << s.names_differed
+                  << " created names or uniform locations differ from the "
+                     "trace, the replay may not draw the same\n";
+    }
+    report(functions, frames, listed);
+    return s.in.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,436 @@
+#include "gl_trace.hxx"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "gl_trace_format.hxx"
+
+namespace eng
+{
+namespace
+{
+// a buffer mapping the application may still be writing to
+struct mapped_range
+{
+    GLuint        buffer;
+    std::uint8_t* data;
+    GLsizeiptr    length;
+    GLbitfield    access;
+};
+
+struct pointer_arg
+{
+    trace_pointer kind;
+    std::size_t   size;
+};
+
+class trace_writer
+{
+public:
+    explicit trace_writer(std::FILE* f)
+        : file(f)
+    {
+        buffer.reserve(flush_size * 2);
+    }
+    ~trace_writer()
+    {
+        flush();
+        std::fclose(file);
+    }
+
+    void bytes(const void* p, std::size_t n)
+    {
+        const auto* b = static_cast<const std::uint8_t*>(p);
+        buffer.insert(buffer.end(), b, b + n);
+        if (buffer.size() >= flush_size)
+        {
+            flush();
+        }
+    }
+    template <typename T>
+    void value(T v)
+    {
+        bytes(&v, sizeof(v));
+    }
+    void flush()
+    {
+        std::fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+    }
+    // state the writer needs to size data, kept out of the trace
+    GLint integer(GLenum name) const
+    {
+        GLint v = 0;
+        get_integer(name, &v);
+        return v;
+    }
+
+    PFNGLGETINTEGERVPROC      get_integer = nullptr;
+    std::vector<mapped_range> mappings;
+
+private:
+    static constexpr std::size_t flush_size = 1 << 20;
+
+    std::FILE*                file;
+    std::vector<std::uint8_t> buffer;
+};
+
+std::unique_ptr<trace_writer> writer;
+
+// 0 for targets without a binding query, asking would raise an error the
+// application then sees
+GLuint bound_buffer(GLenum target)
+{
+    const GLenum binding = gl_buffer_binding(target);
+    return binding == GL_NONE ? 0
+                              : static_cast<GLuint>(writer->integer(binding));
+}
+
+// the mapping of the buffer bound to target
+mapped_range* find_mapping(GLenum target)
+{
+    const GLuint buffer = bound_buffer(target);
+    for (mapped_range& m : writer->mappings)
+    {
+        if (m.buffer == buffer)
+        {
+            return &m;
+        }
+    }
+    return nullptr;
+}
+
+void write_mapped(const mapped_range& m, GLintptr offset, GLsizeiptr length)
+{
+    writer->value(mapped_record);
+    writer->value(static_cast<std::uint32_t>(m.buffer));
+    writer->value(static_cast<std::uint64_t>(offset));
+    writer->value(static_cast<std::uint32_t>(length));
+    writer->bytes(m.data + offset, static_cast<std::size_t>(length));
+}
+
+// glShaderSource strings as one block, each one cut to its length and
+// terminated so replay needs no lengths
+void write_sources(GLsizei              count,
+                   const GLchar* const* strings,
+                   const GLint*         lengths)
+{
+    std::vector<char> block;
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        const std::size_t n = lengths && lengths[i] >= 0
+                                  ? static_cast<std::size_t>(lengths[i])
+                                  : std::strlen(strings[i]);
+        block.insert(block.end(), strings[i], strings[i] + n);
+        block.push_back('\0');
+    }
+    writer->value(trace_pointer::data);
+    writer->value(static_cast<std::uint32_t>(block.size()));
+    writer->bytes(block.data(), block.size());
+}
+
+// how much a pointer argument of C points to. Constant pointers without a
+// size rule are offsets into bound buffers, everything the engine draws
+// with. Output sizes only matter where the call writes a lot
+template <gl_traced C, std::size_t I, typename Args>
+pointer_arg describe_pointer(const Args& a)
+{
+    using T = std::tuple_element_t<I, Args>;
+    using G = gl_traced;
+    if constexpr (C == G::fn_glBufferData && I == 2)
+    {
+        return { trace_pointer::data,
+                 static_cast<std::size_t>(std::get<1>(a)) };
+    }
+    else if constexpr (C == G::fn_glBufferSubData && I == 3)
+    {
+        return { trace_pointer::data,
+                 static_cast<std::size_t>(std::get<2>(a)) };
+    }
+    else if constexpr (C == G::fn_glTexSubImage2D && I == 8)
+    {
+        if (writer->integer(GL_PIXEL_UNPACK_BUFFER_BINDING) != 0)
+        {
+            return { trace_pointer::offset, 0 };
+        }
+        return { trace_pointer::data,
+                 gl_image_size(std::get<4>(a),
+                               std::get<5>(a),
+                               std::get<6>(a),
+                               std::get<7>(a),
+                               writer->integer(GL_UNPACK_ALIGNMENT),
+                               writer->integer(GL_UNPACK_ROW_LENGTH)) };
+    }
+    else if constexpr (C == G::fn_glReadPixels && I == 6)
+    {
+        if (writer->integer(GL_PIXEL_PACK_BUFFER_BINDING) != 0)
+        {
+            return { trace_pointer::offset, 0 };
+        }
+        return { trace_pointer::output,
+                 gl_image_size(std::get<2>(a),
+                               std::get<3>(a),
+                               std::get<4>(a),
+                               std::get<5>(a),
+                               writer->integer(GL_PACK_ALIGNMENT),
+                               writer->integer(GL_PACK_ROW_LENGTH)) };
+    }
+    else if constexpr (C == G::fn_glUniformMatrix3fv && I == 3)
+    {
+        return { trace_pointer::data,
+                 static_cast<std::size_t>(std::get<1>(a)) * 9 *
+                     sizeof(GLfloat) };
+    }
+    else if constexpr (C == G::fn_glUniformMatrix4fv && I == 3)
+    {
+        return { trace_pointer::data,
+                 static_cast<std::size_t>(std::get<1>(a)) * 16 *
+                     sizeof(GLfloat) };
+    }
+    else if constexpr ((C == G::fn_glDeleteBuffers ||
+                        C == G::fn_glDeleteFramebuffers ||
+                        C == G::fn_glDeleteQueries ||
+                        C == G::fn_glDeleteRenderbuffers ||
+                        C == G::fn_glDeleteTextures ||
+                        C == G::fn_glDeleteVertexArrays) &&
+                       I == 1)
+    {
+        return { trace_pointer::data,
+                 static_cast<std::size_t>(std::get<0>(a)) * sizeof(GLuint) };
+    }
+    else if constexpr (std::is_same_v<T, const GLchar*>)
+    {
+        return { trace_pointer::data, std::strlen(std::get<I>(a)) + 1 };
+    }
+    else if constexpr (std::is_const_v<std::remove_pointer_t<T>>)
+    {
+        return { trace_pointer::offset, 0 };
+    }
+    else
+    {
+        return { trace_pointer::output, 0 };
+    }
+}
+
+template <gl_traced C, std::size_t I, typename Args>
+void write_arg(const Args& a)
+{
+    using T    = std::tuple_element_t<I, Args>;
+    const T& v = std::get<I>(a);
+    if constexpr (std::is_same_v<T, GLsync>)
+    {
+        writer->value(static_cast<std::uint64_t>(
+            reinterpret_cast<std::uintptr_t>(v)));
+    }
+    else if constexpr (!std::is_pointer_v<T>)
+    {
+        writer->value(v);
+    }
+    else if constexpr (C == gl_traced::fn_glShaderSource && I == 3)
+    {
+        // the lengths were applied to the strings before them
+        writer->value(trace_pointer::null);
+    }
+    else
+    {
+        if (v == nullptr)
+        {
+            writer->value(trace_pointer::null);
+            return;
+        }
+        if constexpr (C == gl_traced::fn_glShaderSource && I == 2)
+        {
+            write_sources(std::get<1>(a), v, std::get<3>(a));
+            return;
+        }
+        else
+        {
+            const pointer_arg p = describe_pointer<C, I>(a);
+            writer->value(p.kind);
+            if (p.kind == trace_pointer::offset)
+            {
+                writer->value(static_cast<std::uint64_t>(
+                    reinterpret_cast<std::uintptr_t>(v)));
+                return;
+            }
+            writer->value(static_cast<std::uint32_t>(p.size));
+            if (p.kind == trace_pointer::data)
+            {
+                writer->bytes(v, p.size);
+            }
+        }
+    }
+}
+
+template <gl_traced C, typename Args, std::size_t... I>
+void write_args(const Args& a, std::index_sequence<I...>)
+{
+    (write_arg<C, I>(a), ...);
+}
+
+// what the application wrote into a mapping reaches the trace when GL
+// would see it, ahead of the call that publishes it
+template <gl_traced C, typename Args>
+void before_call(const Args& a)
+{
+    if constexpr (C == gl_traced::fn_glFlushMappedBufferRange)
+    {
+        if (const mapped_range* m = find_mapping(std::get<0>(a)))
+        {
+            write_mapped(*m, std::get<1>(a), std::get<2>(a));
+        }
+    }
+    else if constexpr (C == gl_traced::fn_glUnmapBuffer)
+    {
+        if (mapped_range* m = find_mapping(std::get<0>(a)))
+        {
+            if ((m->access & GL_MAP_WRITE_BIT) &&
+                !(m->access & GL_MAP_FLUSH_EXPLICIT_BIT))
+            {
+                write_mapped(*m, 0, m->length);
+            }
+            *m = writer->mappings.back();
+            writer->mappings.pop_back();
+        }
+    }
+}
+
+template <gl_traced C, typename Args, typename R>
+void after_call(const Args& a, R result)
+{
+    if constexpr (C == gl_traced::fn_glMapBufferRange)
+    {
+        if (result)
+        {
+            writer->mappings.push_back({ bound_buffer(std::get<0>(a)),
+                                         static_cast<std::uint8_t*>(result),
+                                         std::get<2>(a),
+                                         std::get<3>(a) });
+        }
+    }
+}
+
+template <typename R>
+void write_result(R result)
+{
+    if constexpr (std::is_same_v<R, GLsync>)
+    {
+        writer->value(static_cast<std::uint64_t>(
+            reinterpret_cast<std::uintptr_t>(result)));
+    }
+    else if constexpr (!std::is_pointer_v<R>)
+    {
+        writer->value(result);
+    }
+}
+
+// stands in for the glad pointer at Slot while tracing, real is what was
+// loaded there
+template <gl_traced C,
+          auto*      Slot,
+          typename F = std::remove_pointer_t<decltype(Slot)>>
+struct traced;
+
+template <gl_traced C, auto* Slot, typename R, typename... A>
+struct traced<C, Slot, R(APIENTRY*)(A...)>
+{
+    static inline R(APIENTRY* real)(A...) = nullptr;
+
+    static R APIENTRY call(A... args)
+    {
+        const std::tuple<A...> a(args...);
+        before_call<C>(a);
+        writer->value(static_cast<std::uint16_t>(C));
+        write_args<C>(a, std::index_sequence_for<A...>());
+        if constexpr (std::is_void_v<R>)
+        {
+            real(args...);
+        }
+        else
+        {
+            const R result = real(args...);
+            write_result(result);
+            after_call<C>(a, result);
+            return result;
+        }
+    }
+};
+
+#define OM_GL_TRACE_NAME(name) #name,
+constexpr const char* traced_names[] = { OM_GL_TRACED_FUNCTIONS(
+    OM_GL_TRACE_NAME) };
+#undef OM_GL_TRACE_NAME
+} // namespace
+
+bool start_gl_trace(const std::string& path, int width, int height)
+{
+    if (writer)
+    {
+        return false;
+    }
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        return false;
+    }
+    writer              = std::make_unique<trace_writer>(file);
+    writer->get_integer = glad_glGetIntegerv;
+
+    writer->bytes(gl_trace_magic, sizeof(gl_trace_magic));
+    writer->value(static_cast<std::uint32_t>(width));
+    writer->value(static_cast<std::uint32_t>(height));
+    writer->value(static_cast<std::uint16_t>(gl_traced::count));
+    for (const char* name : traced_names)
+    {
+        const std::size_t length = std::strlen(name);
+        writer->value(static_cast<std::uint8_t>(length));
+        writer->bytes(name, length);
+    }
+
+    // functions the context doesn't have stay null, the engine tests them
+#define OM_GL_TRACE_INSTALL(name)                                              \
+    if (glad_##name)                                                           \
+    {                                                                          \
+        using wrapper = traced<gl_traced::fn_##name, &glad_##name>;            \
+        wrapper::real = glad_##name;                                           \
+        glad_##name   = &wrapper::call;                                        \
+    }
+    OM_GL_TRACED_FUNCTIONS(OM_GL_TRACE_INSTALL)
+#undef OM_GL_TRACE_INSTALL
+    return true;
+}
+
+void gl_trace_frame()
+{
+    if (writer)
+    {
+        writer->value(frame_record);
+        // a crash still leaves every finished frame on disk
+        writer->flush();
+    }
+}
+
+void stop_gl_trace()
+{
+    if (!writer)
+    {
+        return;
+    }
+#define OM_GL_TRACE_RESTORE(name)                                              \
+    {                                                                          \
+        using wrapper = traced<gl_traced::fn_##name, &glad_##name>;            \
+        if (wrapper::real)                                                     \
+        {                                                                      \
+            glad_##name   = wrapper::real;                                     \
+            wrapper::real = nullptr;                                           \
+        }                                                                      \
+    }
+    OM_GL_TRACED_FUNCTIONS(OM_GL_TRACE_RESTORE)
+#undef OM_GL_TRACE_RESTORE
+    writer.reset();
+}
+} // namespace eng
@@ -0,0 +1,19 @@
+#ifndef OPENGL_WINDOW_GL_TRACE_HXX
+#define OPENGL_WINDOW_GL_TRACE_HXX
+#include <string>
+
+namespace eng
+{
+// records every GL call with its arguments and the data it uploads into a
+// file gl_replay plays back, see gl_trace_format.hxx. Swaps the pointers
+// gladLoadGLES2Loader loaded for recording wrappers, so it has to start
+// right after loading, before the first GL call, and costs nothing while
+// off. width and height are the size of the default framebuffer. GL thread
+// only, false when the file can't be written
+bool start_gl_trace(const std::string& path, int width, int height);
+// marks the end of a presented frame, nothing when not tracing
+void gl_trace_frame();
+// puts the loaded pointers back and closes the file
+void stop_gl_trace();
+} // namespace eng
+#endif // OPENGL_WINDOW_GL_TRACE_HXX
@@ -0,0 +1,252 @@
+#ifndef OPENGL_WINDOW_GL_TRACE_FORMAT_HXX
+#define OPENGL_WINDOW_GL_TRACE_FORMAT_HXX
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+#include "glad/glad.h"
+
+// what gl_trace writes and gl_replay reads, in native byte order:
+//   header  "OMGLTRC2", u32 width, u32 height of the default framebuffer,
+//           u16 function count, per function u8 length and its name
+//   call    u16 index into the header names, the arguments in order, then
+//           the return value
+//   frame   u16 frame_record, written once per presented frame
+//   mapped  u16 mapped_record, u32 name of the mapped buffer, u64 offset
+//           into the mapping, u32 size and the bytes the application wrote
+//           there, ahead of the glFlushMappedBufferRange or glUnmapBuffer
+//           that publishes them
+// scalars are stored at their own size, GLsync as u64. Every other pointer
+// starts with a trace_pointer byte:
+//   null    nothing follows
+//   offset  u64, the value is an offset into a bound buffer
+//   data    u32 size and the bytes it points to
+//   output  u32 size the call may write, GL writes there and nobody reads it
+// pointers returned by GL are not stored, except GLsync
+
+// every GL function the engine calls, add new ones here or they bypass the
+// trace. Debug output setup is left out, replay has no use for it
+#define OM_GL_TRACED_FUNCTIONS(X)                                              \
+    X(glActiveTexture)                                                         \
+    X(glAttachShader)                                                          \
+    X(glBeginQuery)                                                            \
+    X(glBindBuffer)                                                            \
+    X(glBindBufferBase)                                                        \
+    X(glBindFramebuffer)                                                       \
+    X(glBindRenderbuffer)                                                      \
+    X(glBindTexture)                                                           \
+    X(glBindVertexArray)                                                       \
+    X(glBlendFunc)                                                             \
+    X(glBufferData)                                                            \
+    X(glBufferSubData)                                                         \
+    X(glCheckFramebufferStatus)                                                \
+    X(glClear)                                                                 \
+    X(glClearColor)                                                            \
+    X(glClientWaitSync)                                                        \
+    X(glCompileShader)                                                         \
+    X(glCreateProgram)                                                         \
+    X(glCreateShader)                                                          \
+    X(glDeleteBuffers)                                                         \
+    X(glDeleteFramebuffers)                                                    \
+    X(glDeleteProgram)                                                         \
+    X(glDeleteQueries)                                                         \
+    X(glDeleteRenderbuffers)                                                   \
+    X(glDeleteShader)                                                          \
+    X(glDeleteSync)                                                            \
+    X(glDeleteTextures)                                                        \
+    X(glDeleteVertexArrays)                                                    \
+    X(glDisable)                                                               \
+    X(glDispatchCompute)                                                       \
+    X(glDispatchComputeIndirect)                                               \
+    X(glDrawArrays)                                                            \
+    X(glDrawArraysIndirect)                                                    \
+    X(glDrawArraysInstanced)                                                   \
+    X(glDrawElements)                                                          \
+    X(glDrawElementsBaseVertex)                                                \
+    X(glEnable)                                                                \
+    X(glEnableVertexAttribArray)                                               \
+    X(glEndQuery)                                                              \
+    X(glFenceSync)                                                             \
+    X(glFinish)                                                                \
+    X(glFlushMappedBufferRange)                                                \
+    X(glFramebufferRenderbuffer)                                               \
+    X(glFramebufferTexture2D)                                                  \
+    X(glGenBuffers)                                                            \
+    X(glGenFramebuffers)                                                       \
+    X(glGenQueries)                                                            \
+    X(glGenRenderbuffers)                                                      \
+    X(glGenTextures)                                                           \
+    X(glGenVertexArrays)                                                       \
+    X(glGetError)                                                              \
+    X(glGetIntegerv)                                                           \
+    X(glGetProgramInfoLog)                                                     \
+    X(glGetProgramiv)                                                          \
+    X(glGetQueryObjectuiv)                                                     \
+    X(glGetShaderInfoLog)                                                      \
+    X(glGetShaderiv)                                                           \
+    X(glGetString)                                                             \
+    X(glGetStringi)                                                            \
+    X(glGetUniformLocation)                                                    \
+    X(glLinkProgram)                                                           \
+    X(glMapBufferRange)                                                        \
+    X(glMemoryBarrier)                                                         \
+    X(glPixelStorei)                                                           \
+    X(glReadPixels)                                                            \
+    X(glRenderbufferStorage)                                                   \
+    X(glShaderSource)                                                          \
+    X(glTexParameteri)                                                         \
+    X(glTexStorage2D)                                                          \
+    X(glTexSubImage2D)                                                         \
+    X(glUniform1f)                                                             \
+    X(glUniform1i)                                                             \
+    X(glUniform1ui)                                                            \
+    X(glUniform2f)                                                             \
+    X(glUniform3f)                                                             \
+    X(glUniform4f)                                                             \
+    X(glUniformMatrix3fv)                                                      \
+    X(glUniformMatrix4fv)                                                      \
+    X(glUnmapBuffer)                                                           \
+    X(glUseProgram)                                                            \
+    X(glVertexAttribDivisor)                                                   \
+    X(glVertexAttribPointer)                                                   \
+    X(glViewport)
+
+namespace eng
+{
+#define OM_GL_TRACED_ENUM(name) fn_##name,
+enum class gl_traced : std::uint16_t
+{
+    OM_GL_TRACED_FUNCTIONS(OM_GL_TRACED_ENUM) count
+};
+#undef OM_GL_TRACED_ENUM
+
+constexpr char          gl_trace_magic[8] = { 'O', 'M', 'G', 'L',
+                                              'T', 'R', 'C', '2' };
+constexpr std::uint16_t frame_record      = 0xffff;
+constexpr std::uint16_t mapped_record     = 0xfffe;
+
+enum class trace_pointer : std::uint8_t
+{
+    null,
+    offset,
+    data,
+    output
+};
+
+// the glGetIntegerv name of the buffer bound to target, mappings are told
+// apart by buffer since several on one target can be open at once
+inline GLenum gl_buffer_binding(GLenum target)
+{
+    switch (target)
+    {
+        case GL_ARRAY_BUFFER:
+            return GL_ARRAY_BUFFER_BINDING;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            return GL_ELEMENT_ARRAY_BUFFER_BINDING;
+        case GL_UNIFORM_BUFFER:
+            return GL_UNIFORM_BUFFER_BINDING;
+        case GL_SHADER_STORAGE_BUFFER:
+            return GL_SHADER_STORAGE_BUFFER_BINDING;
+        case GL_PIXEL_PACK_BUFFER:
+            return GL_PIXEL_PACK_BUFFER_BINDING;
+        case GL_PIXEL_UNPACK_BUFFER:
+            return GL_PIXEL_UNPACK_BUFFER_BINDING;
+        case GL_COPY_READ_BUFFER:
+            return GL_COPY_READ_BUFFER_BINDING;
+        case GL_COPY_WRITE_BUFFER:
+            return GL_COPY_WRITE_BUFFER_BINDING;
+        case GL_DRAW_INDIRECT_BUFFER:
+            return GL_DRAW_INDIRECT_BUFFER_BINDING;
+        case GL_DISPATCH_INDIRECT_BUFFER:
+            return GL_DISPATCH_INDIRECT_BUFFER_BINDING;
+        case GL_ATOMIC_COUNTER_BUFFER:
+            return GL_ATOMIC_COUNTER_BUFFER_BINDING;
+        case GL_TRANSFORM_FEEDBACK_BUFFER:
+            return GL_TRANSFORM_FEEDBACK_BUFFER_BINDING;
+        case GL_TEXTURE_BUFFER:
+            return GL_TEXTURE_BUFFER_BINDING;
+        default:
+            return GL_NONE;
+    }
+}
+
+// return and argument types of a glad function pointer type
+template <typename F>
+struct gl_signature;
+template <typename R, typename... A>
+struct gl_signature<R(APIENTRY*)(A...)>
+{
+    using result = R;
+    using args   = std::tuple<A...>;
+};
+
+// bytes glTexSubImage2D reads or glReadPixels writes for a w x h image,
+// with rows of row_length pixels (0 means w) padded to alignment
+inline std::size_t gl_image_size(GLsizei width,
+                                 GLsizei height,
+                                 GLenum  format,
+                                 GLenum  type,
+                                 GLint   alignment,
+                                 GLint   row_length)
+{
+    std::size_t pixel = 0;
+    switch (type)
+    {
+        case GL_UNSIGNED_SHORT_5_6_5:
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+        case GL_UNSIGNED_SHORT_5_5_5_1:
+            pixel = 2;
+            break;
+        case GL_UNSIGNED_INT_2_10_10_10_REV:
+        case GL_UNSIGNED_INT_10F_11F_11F_REV:
+        case GL_UNSIGNED_INT_5_9_9_9_REV:
+        case GL_UNSIGNED_INT_24_8:
+            pixel = 4;
+            break;
+        default:
+        {
+            std::size_t component = 1;
+            if (type == GL_SHORT || type == GL_UNSIGNED_SHORT ||
+                type == GL_HALF_FLOAT)
+            {
+                component = 2;
+            }
+            else if (type == GL_INT || type == GL_UNSIGNED_INT ||
+                     type == GL_FLOAT)
+            {
+                component = 4;
+            }
+            std::size_t components = 4;
+            if (format == GL_RED || format == GL_RED_INTEGER ||
+                format == GL_ALPHA || format == GL_LUMINANCE ||
+                format == GL_DEPTH_COMPONENT)
+            {
+                components = 1;
+            }
+            else if (format == GL_RG || format == GL_RG_INTEGER ||
+                     format == GL_LUMINANCE_ALPHA)
+            {
+                components = 2;
+            }
+            else if (format == GL_RGB || format == GL_RGB_INTEGER)
+            {
+                components = 3;
+            }
+            pixel = component * components;
+        }
+    }
+    if (width <= 0 || height <= 0)
+    {
+        return 0;
+    }
+    const std::size_t a   = alignment > 0 ? alignment : 1;
+    const std::size_t row = (static_cast<std::size_t>(
+                                 row_length > 0 ? row_length : width) *
+                                 pixel +
+                             a - 1) /
+                            a * a;
+    return row * (height - 1) + pixel * width;
+}
+} // namespace eng
+#endif // OPENGL_WINDOW_GL_TRACE_FORMAT_HXX
@@ -0,0 +1,270 @@
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "stb_image.h"
+
+#include "engine.hxx"
+#include "frame_capture.hxx"
+#include "gpu_particles.hxx"
+#include "image_diff.hxx"
+#include "png.hxx"
+
+// renders scripted scenes headless and compares each frame with a stored
+// reference PNG:
+//   golden_images [--update] [reference_dir] [output_dir]
+// --update writes the references instead. A scene passes when at most
+// allowed_over of its pixels differ by more than tolerance per channel and
+// the block SSIM stays above min_ssim. Failures write the rendered frame
+// and a heatmap of the differences to output_dir. Runs from the directory
+// holding the shaders and images, like the game
+
+namespace
+{
+constexpr int    tolerance    = 2;
+constexpr double allowed_over = 0.001;
+constexpr double min_ssim     = 0.99;
+
+struct scene
+{
+    const char*                       name;
+    std::function<void(eng::engine&)> draw;
+};
+
+// the game's tank quad: corners at -1 and -0.9, texture flipped in y
+void draw_tank_quad(eng::engine& engine, int texture, glm::mat4 transform)
+{
+    eng::vertex   v4 = { -0.9f, -0.9f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f };
+    eng::vertex   v5 = { -0.9f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f };
+    eng::vertex   v6 = { -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+    eng::vertex   v7 = { -1.0f, -0.9f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f };
+    eng::triangle t3(v4, v5, v6);
+    eng::triangle t4(v7, v6, v5);
+    engine.draw_texture(t3, t4, texture, transform);
+}
+
+// compute only adds the scenes that need GLES 3.1 compute shaders
+std::vector<scene> make_scenes(
+    int fone, int tank, int font, int ttf_font, bool compute)
+{
+    std::vector<scene> scenes;
+    scenes.push_back({ "tank",
+                       [=](eng::engine& e)
+                       {
+                           e.set_camera(eng::camera());
+                           draw_tank_quad(e, tank, glm::mat4(1.f));
+                       } });
+    // alternating textures, overlapping quads and the camera zoomed out,
+    // the case sprite batching and texture bind caching must keep intact
+    scenes.push_back({ "sprite_grid",
+                       [=](eng::engine& e)
+                       {
+                           eng::camera c;
+                           c.zoom = 0.5f;
+                           e.set_camera(c);
+                           for (int i = 0; i < 200; ++i)
+                           {
+                               const glm::vec3 at(0.15f * (i % 20) - 1.f,
+                                                  0.2f * (i / 20) - 1.f,
+                                                  0.f);
+                               draw_tank_quad(
+                                   e,
+                                   i % 3 ? tank : fone,
+                                   glm::translate(glm::mat4(1.f), at));
+                           }
+                       } });
+    scenes.push_back({ "text",
+                       [=](eng::engine& e)
+                       {
+                           eng::camera screen;
+                           screen.extent =
+                               glm::vec2(eng::width, eng::height);
+                           screen.position = screen.extent * 0.5f;
+                           e.set_camera(screen);
+                           e.draw_text(font,
+                                       "Golden 0123456789\nWASD to drive",
+                                       glm::vec2(16.f, 64.f),
+                                       40.f,
+                                       glm::vec3(1.f, 0.8f, 0.2f));
+                       } });
+    // the signed distance field atlas truetype_font builds from a real font
+    scenes.push_back({ "text_ttf",
+                       [=](eng::engine& e)
+                       {
+                           eng::camera screen;
+                           screen.extent =
+                               glm::vec2(eng::width, eng::height);
+                           screen.position = screen.extent * 0.5f;
+                           e.set_camera(screen);
+                           e.draw_text(ttf_font,
+                                       "Golden 0123456789\nWASD to drive",
+                                       glm::vec2(16.f, 64.f),
+                                       40.f,
+                                       glm::vec3(0.2f, 0.8f, 1.f));
+                           e.draw_text(ttf_font,
+                                       "small print",
+                                       glm::vec2(16.f, 200.f),
+                                       12.f,
+                                       glm::vec3(1.f));
+                       } });
+    // the compute simulated system after half a second of fixed steps, its
+    // spawn seed is fixed so every run emits the same particles
+    if (compute)
+    {
+        scenes.push_back({ "gpu_particles",
+                           [=](eng::engine& e)
+                           {
+                               eng::particle_emitter_desc desc;
+                               desc.capacity = 2048;
+                               desc.rate     = 600.f;
+                               desc.gravity  = glm::vec2(0.f, -0.4f);
+                               eng::gpu_particle_system particles(desc);
+                               particles.emit_burst(glm::vec2(0.f, 0.3f), 256);
+                               e.set_camera(eng::camera());
+                               for (int step = 0; step < 30; ++step)
+                               {
+                                   particles.update(1.f / 60.f);
+                               }
+                               e.draw_particles(particles);
+                           } });
+    }
+    return scenes;
+}
+
+// draws the scene, captures the presented frame and swaps until the
+// readback arrived. Rows come back top down like the PNGs. The consumer
+// shares ownership of the result in case it runs after we gave up
+bool render(eng::engine&               engine,
+            const scene&               s,
+            std::vector<std::uint8_t>& pixels)
+{
+    struct capture_result
+    {
+        std::atomic<bool>         ready{ false };
+        std::vector<std::uint8_t> pixels;
+    };
+    auto result = std::make_shared<capture_result>();
+    s.draw(engine);
+    engine.capture_frame(
+        [result](const eng::captured_image& image)
+        {
+            const std::size_t row = static_cast<std::size_t>(image.width) * 4;
+            result->pixels.resize(row * image.height);
+            for (int y = 0; y < image.height; ++y)
+            {
+                std::memcpy(result->pixels.data() + row * y,
+                            image.pixels + row * (image.height - 1 - y),
+                            row);
+            }
+            result->ready = true;
+        });
+    for (int frame = 0; frame < 16 && !result->ready; ++frame)
+    {
+        engine.swap_buff();
+    }
+    if (!result->ready)
+    {
+        return false;
+    }
+    pixels = std::move(result->pixels);
+    return true;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const bool update = argc > 1 && std::strcmp(argv[1], "--update") == 0;
+    const int  arg    = update ? 2 : 1;
+
+    const std::string reference_dir = argc > arg ? argv[arg] : "golden";
+    const std::string output_dir    = argc > arg + 1 ? argv[arg + 1] : ".";
+
+    std::unique_ptr<eng::engine, void (*)(eng::engine*)> engine(
+        eng::create_engine(), eng::destroy_engine);
+    eng::engine_config config;
+    config.headless = true;
+    if (!engine->initialize_engine(config))
+    {
+        std::cerr << "golden_images: needs a headless EGL context"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::error_code ignored;
+    if (update)
+    {
+        std::filesystem::create_directories(reference_dir, ignored);
+    }
+    const std::vector<int> textures =
+        engine->load_textures({ "fone.png", "tank.png" });
+    const int font     = engine->load_font("", 48.f);
+    const int ttf_font = engine->load_font("SourceCodePro-Regular.ttf", 48.f);
+
+    int failed = 0;
+    for (const scene& s :
+         make_scenes(textures[0],
+                     textures[1],
+                     font,
+                     ttf_font,
+                     engine->compute_supported()))
+    {
+        const std::string reference = reference_dir + "/" + s.name + ".png";
+        std::vector<std::uint8_t> actual;
+        if (!render(*engine, s, actual))
+        {
+            std::cout << "FAIL " << s.name << ": frame never read back"
+                      << std::endl;
+            ++failed;
+            continue;
+        }
+        if (update)
+        {
+            const bool written = eng::write_png(reference,
+                                                eng::width,
+                                                eng::height,
+                                                actual.data(),
+                                                eng::width * 4);
+            std::cout << (written ? "wrote " : "FAIL can't write ")
+                      << reference << std::endl;
+            failed += !written;
+            continue;
+        }
+
+        int           w        = 0;
+        int           h        = 0;
+        int           channels = 0;
+        std::uint8_t* expected =
+            stbi_load(reference.c_str(), &w, &h, &channels, 4);
+        if (!expected || w != eng::width || h != eng::height)
+        {
+            std::cout << "FAIL " << s.name << ": no reference " << reference
+                      << std::endl;
+            stbi_image_free(expected);
+            ++failed;
+            continue;
+        }
+        std::vector<std::uint8_t>   heatmap;
+        const eng::image_difference d = eng::compare_images(
+            expected, actual.data(), w, h, tolerance, &heatmap);
+        stbi_image_free(expected);
+
+        const double over = static_cast<double>(d.pixels_over) / d.pixels;
+        const bool   pass = over <= allowed_over && d.ssim >= min_ssim;
+        std::cout << (pass ? "PASS " : "FAIL ") << s.name << ": "
+                  << d.pixels_over << " pixels over tolerance, max delta "
+                  << d.max_delta << ", ssim " << d.ssim << std::endl;
+        if (!pass)
+        {
+            const std::string base = output_dir + "/" + s.name;
+            eng::write_png(base + "_actual.png", w, h, actual.data(), w * 4);
+            eng::write_png(base + "_diff.png", w, h, heatmap.data(), w * 4);
+            ++failed;
+        }
+    }
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,214 @@
+#include "gpu_particles.hxx"
+
+#include <algorithm>
+#include <cmath>
+
+#include "gl_check.hxx"
+#include "render_stats.hxx"
+#include "shader.hxx"
+
+namespace eng
+{
+// std430 layout shared with the particles_*.comp shaders
+struct gpu_particle
+{
+    float x;
+    float y;
+    float age;
+    float life;
+    float vx;
+    float vy;
+    float pad[2];
+};
+static_assert(sizeof(gpu_particle) == 32, "must match the shader struct");
+
+struct gpu_particle_state
+{
+    GLuint count_in;
+    GLuint count_out;
+    GLuint capacity;
+    GLuint seed;
+    GLuint dispatch_args[4]; // num_groups_x, y, z, unused
+    GLuint draw_args[4];     // count, instance_count, first, reserved
+};
+
+static constexpr GLintptr dispatch_args_offset = 16;
+static constexpr GLintptr draw_args_offset     = 32;
+static constexpr GLuint   group_size           = 64;
+
+gpu_particle_system::gpu_particle_system(const particle_emitter_desc& desc)
+    : config(desc)
+{
+    simulate_pass = std::make_unique<ComputeShader>("particles_simulate.comp");
+    emit_pass     = std::make_unique<ComputeShader>("particles_emit.comp");
+    finalize_pass = std::make_unique<ComputeShader>("particles_finalize.comp");
+    draw_shader   = std::make_unique<Shader>(
+        "particle.vert", "particle.frag", "#define GPU_PARTICLES\n");
+
+    const GLsizeiptr bytes =
+        static_cast<GLsizeiptr>(config.capacity * sizeof(gpu_particle));
+    glGenBuffers(2, particles);
+    for (GLuint buffer : particles)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, GL_DYNAMIC_COPY);
+    }
+    const gpu_particle_state initial = {
+        0,   0, static_cast<GLuint>(config.capacity), 0, { 0, 1, 1, 0 },
+        { 4, 0, 0, 0 }
+    };
+    glGenBuffers(1, &state);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, state);
+    glBufferData(
+        GL_SHADER_STORAGE_BUFFER, sizeof(initial), &initial, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    OM_GL_CHECK(glBindBuffer)
+    gpu_memory_bytes() += 2 * bytes + sizeof(initial);
+
+    const float corners[] = { -0.5f, -0.5f, 0.5f, -0.5f,
+                              -0.5f, 0.5f,  0.5f, 0.5f };
+    glGenBuffers(1, &quad_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    // one vertex array per storage buffer so draw only has to pick one
+    glGenVertexArrays(2, vao);
+    for (int i = 0; i < 2; ++i)
+    {
+        glBindVertexArray(vao[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+        glVertexAttribPointer(
+            0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+        glEnableVertexAttribArray(0);
+        // x, y, age, life straight out of the storage buffer
+        glBindBuffer(GL_ARRAY_BUFFER, particles[i]);
+        glVertexAttribPointer(
+            1, 4, GL_FLOAT, GL_FALSE, sizeof(gpu_particle), nullptr);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    OM_GL_CHECK(glBindBuffer)
+}
+
+gpu_particle_system::~gpu_particle_system()
+{
+    glDeleteVertexArrays(2, vao);
+    glDeleteBuffers(1, &quad_vbo);
+    glDeleteBuffers(1, &state);
+    glDeleteBuffers(2, particles);
+    gpu_memory_bytes() -=
+        2 * config.capacity * sizeof(gpu_particle) + sizeof(gpu_particle_state);
+}
+
+void gpu_particle_system::emit_burst(glm::vec2 at, std::size_t n)
+{
+    // more than capacity would be dropped by the shader anyway
+    n = std::min(n, config.capacity);
+    if (n != 0)
+    {
+        bursts.push_back({ at, static_cast<std::uint32_t>(n) });
+    }
+}
+
+void gpu_particle_system::emit(const burst& b)
+{
+    // xorshift32 so every burst gets a different sequence
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    emit_pass->use();
+    emit_pass->setUint("emit_count", b.count);
+    emit_pass->setUint("emit_seed", seed);
+    emit_pass->setVec2("origin", b.at.x, b.at.y);
+    emit_pass->setFloat("direction",
+                        std::atan2(config.direction.y, config.direction.x));
+    emit_pass->setFloat("spread", config.spread);
+    emit_pass->setVec2("speed_range", config.speed_min, config.speed_max);
+    emit_pass->setVec2("life_range", config.life_min, config.life_max);
+    glDispatchCompute((b.count + group_size - 1) / group_size, 1, 1);
+}
+
+void gpu_particle_system::update(float dt)
+{
+    if (config.rate > 0.f)
+    {
+        spawn_debt += config.rate * dt;
+        const float whole = std::floor(spawn_debt);
+        spawn_debt -= whole;
+        emit_burst(position, static_cast<std::size_t>(whole));
+    }
+
+    const int next = 1 - current;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particles[current]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, particles[next]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, state);
+
+    // survivors are appended to the next buffer, sized by the previous
+    // finalize pass without a CPU round trip
+    simulate_pass->use();
+    simulate_pass->setFloat("dt", dt);
+    simulate_pass->setVec2("gravity", config.gravity.x, config.gravity.y);
+    simulate_pass->setFloat("drag", config.drag);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, state);
+    glDispatchComputeIndirect(dispatch_args_offset);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // new particles go after the survivors
+    for (const burst& b : bursts)
+    {
+        emit(b);
+    }
+    if (!bursts.empty())
+    {
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+    bursts.clear();
+
+    finalize_pass->use();
+    glDispatchCompute(1, 1, 1);
+    // the next simulate pass and draw read what finalize and the passes
+    // before it wrote
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT |
+                    GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+    OM_GL_CHECK(glBindBuffer)
+
+    current = next;
+}
+
+void gpu_particle_system::draw()
+{
+    draw_shader->use();
+    draw_shader->setFloat("size_start", config.size_start);
+    draw_shader->setFloat("size_end", config.size_end);
+    draw_shader->setVec4("color_start",
+                         config.color_start.x,
+                         config.color_start.y,
+                         config.color_start.z,
+                         config.color_start.w);
+    draw_shader->setVec4("color_end",
+                         config.color_end.x,
+                         config.color_end.y,
+                         config.color_end.z,
+                         config.color_end.w);
+    draw_shader->setInt("textured", config.texture != 0);
+    draw_shader->setInt("ourTexture", 0);
+    if (config.texture != 0)
+    {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, config.texture);
+        count_texture_bind();
+    }
+
+    glBindVertexArray(vao[current]);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, state);
+    glDrawArraysIndirect(GL_TRIANGLE_STRIP,
+                         reinterpret_cast<const void*>(draw_args_offset));
+    OM_GL_CHECK(glDrawArraysIndirect)
+    count_indirect_draw();
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
+} // namespace eng
@@ -0,0 +1,67 @@
+#ifndef OPENGL_WINDOW_GPU_PARTICLES_HXX
+#define OPENGL_WINDOW_GPU_PARTICLES_HXX
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glad/glad.h"
+
+#include "particles.hxx"
+
+namespace eng
+{
+struct ComputeShader;
+struct Shader;
+
+// particle_emitter that lives entirely on the GPU: compute shaders age,
+// integrate and compact the particles between two ping-pong storage buffers
+// and the live count never comes back to the CPU, dispatch and draw sizes
+// are read from an indirect argument buffer, needs GLES 3.1
+class gpu_particle_system
+{
+public:
+    explicit gpu_particle_system(const particle_emitter_desc& desc);
+    ~gpu_particle_system();
+
+    gpu_particle_system(const gpu_particle_system&)            = delete;
+    gpu_particle_system& operator=(const gpu_particle_system&) = delete;
+
+    // queued, spawned by the next update
+    void emit_burst(glm::vec2 at, std::size_t n);
+    // spawns desc.rate particles per second at position and runs the
+    // simulation passes
+    void update(float dt);
+    // one instanced indirect draw, the camera block must be bound
+    void draw();
+
+    glm::vec2                    position{ 0.f, 0.f };
+    const particle_emitter_desc& desc() const { return config; }
+
+private:
+    struct burst
+    {
+        glm::vec2     at;
+        std::uint32_t count;
+    };
+
+    void emit(const burst& b);
+
+    particle_emitter_desc          config;
+    std::unique_ptr<ComputeShader> simulate_pass;
+    std::unique_ptr<ComputeShader> emit_pass;
+    std::unique_ptr<ComputeShader> finalize_pass;
+    std::unique_ptr<Shader>        draw_shader;
+
+    // particles[current] holds the live particles, the other one is written
+    // by the next update
+    GLuint             particles[2] = { 0, 0 };
+    GLuint             state        = 0;
+    GLuint             quad_vbo     = 0;
+    GLuint             vao[2]       = { 0, 0 };
+    int                current      = 0;
+    std::vector<burst> bursts;
+    float              spawn_debt = 0.f;
+    std::uint32_t      seed       = 0x9e3779b9u;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_GPU_PARTICLES_HXX
@@ -0,0 +1,109 @@
+#include "gpu_timer.hxx"
+
+#include <cstring>
+
+#include "gl_check.hxx"
+
+// EXT_disjoint_timer_query, the loader is generated without it
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+namespace eng
+{
+gpu_timer::gpu_timer()
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count && !available; ++i)
+    {
+        const char* name =
+            reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        available =
+            name && std::strcmp(name, "GL_EXT_disjoint_timer_query") == 0;
+    }
+    if (available)
+    {
+        glGenQueries(queries, ids);
+        // reading the flag clears it
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    }
+    OM_GL_CHECK(glGetIntegerv)
+}
+
+gpu_timer::~gpu_timer()
+{
+    if (available)
+    {
+        glDeleteQueries(queries, ids);
+    }
+}
+
+void gpu_timer::begin()
+{
+    if (!available || running)
+    {
+        return;
+    }
+    poll();
+    if (issued[next])
+    {
+        return;
+    }
+    glBeginQuery(GL_TIME_ELAPSED_EXT, ids[next]);
+    running = true;
+}
+
+void gpu_timer::end()
+{
+    if (!running)
+    {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED_EXT);
+    issued[next] = true;
+    next         = (next + 1) % queries;
+    running      = false;
+}
+
+void gpu_timer::poll()
+{
+    while (issued[oldest])
+    {
+        GLuint ready = 0;
+        glGetQueryObjectuiv(ids[oldest], GL_QUERY_RESULT_AVAILABLE, &ready);
+        if (!ready)
+        {
+            return;
+        }
+        GLuint ns = 0;
+        glGetQueryObjectuiv(ids[oldest], GL_QUERY_RESULT, &ns);
+        // a power state change or context loss makes every result in
+        // flight meaningless, and the 32 bit read saturates when the real
+        // value does not fit
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+        if (!disjoint && ns != 0xffffffffu)
+        {
+            last_ms = ns / 1.0e6f;
+        }
+        issued[oldest] = false;
+        oldest         = (oldest + 1) % queries;
+    }
+}
+
+bool gpu_timer::latest_ms(float& ms)
+{
+    poll();
+    if (last_ms < 0.f)
+    {
+        return false;
+    }
+    ms = last_ms;
+    return true;
+}
+} // namespace eng
@@ -0,0 +1,44 @@
+#ifndef OPENGL_WINDOW_GPU_TIMER_HXX
+#define OPENGL_WINDOW_GPU_TIMER_HXX
+#include "glad/glad.h"
+
+#include "frame_arena.hxx"
+
+namespace eng
+{
+// GPU time of the commands between begin and end, measured with
+// EXT_disjoint_timer_query. Results arrive frames later and are polled
+// without blocking, latest_ms reports the newest one
+class gpu_timer
+{
+public:
+    static constexpr int queries = frame_arena::frames_in_flight + 1;
+
+    gpu_timer();
+    ~gpu_timer();
+
+    gpu_timer(const gpu_timer&)            = delete;
+    gpu_timer& operator=(const gpu_timer&) = delete;
+
+    // false when the context lacks the extension, begin and end do nothing
+    bool supported() const { return available; }
+
+    // skipped while every query is still in flight
+    void begin();
+    void end();
+    // false until the first result came back
+    bool latest_ms(float& ms);
+
+private:
+    void poll();
+
+    bool   available = false;
+    GLuint ids[queries]{};
+    bool   issued[queries]{};
+    int    next    = 0; // slot of the next begin
+    int    oldest  = 0; // oldest issued slot
+    bool   running = false;
+    float  last_ms = -1.f;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_GPU_TIMER_HXX
@@ -0,0 +1,177 @@
+#include "headless_context.hxx"
+
+#if defined(OPENGL_WINDOW_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+#endif
+
+namespace eng
+{
+#if defined(OPENGL_WINDOW_EGL)
+static bool has_extension(const char* list, const char* name)
+{
+    if (!list)
+    {
+        return false;
+    }
+    const std::size_t length = std::strlen(name);
+    for (const char* p = std::strstr(list, name); p;
+         p             = std::strstr(p + length, name))
+    {
+        // whole words only, one name can be the prefix of another
+        if ((p == list || p[-1] == ' ') &&
+            (p[length] == ' ' || p[length] == '\0'))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static EGLDisplay open_display()
+{
+    const char* client = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (has_extension(client, "EGL_MESA_platform_surfaceless"))
+    {
+        auto get_platform_display =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display)
+        {
+            EGLDisplay d = get_platform_display(
+                EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (d != EGL_NO_DISPLAY && eglInitialize(d, nullptr, nullptr))
+            {
+                return d;
+            }
+        }
+    }
+    EGLDisplay d = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (d != EGL_NO_DISPLAY && eglInitialize(d, nullptr, nullptr))
+    {
+        return d;
+    }
+    return EGL_NO_DISPLAY;
+}
+
+headless_context::~headless_context()
+{
+    if (!display)
+    {
+        return;
+    }
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context)
+    {
+        eglDestroyContext(display, context);
+    }
+    if (surface)
+    {
+        eglDestroySurface(display, surface);
+    }
+    eglTerminate(display);
+}
+
+bool headless_context::create(std::string& error, int width, int height)
+{
+    display = open_display();
+    if (!display)
+    {
+        error = "no EGL display";
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_ES_API))
+    {
+        error = "EGL has no OpenGL ES";
+        return false;
+    }
+    const bool   sized               = width > 0 && height > 0;
+    const EGLint config_attributes[] = { EGL_RENDERABLE_TYPE,
+                                         EGL_OPENGL_ES3_BIT,
+                                         EGL_SURFACE_TYPE,
+                                         EGL_PBUFFER_BIT,
+                                         EGL_RED_SIZE,
+                                         sized ? 8 : 0,
+                                         EGL_GREEN_SIZE,
+                                         sized ? 8 : 0,
+                                         EGL_BLUE_SIZE,
+                                         sized ? 8 : 0,
+                                         EGL_ALPHA_SIZE,
+                                         sized ? 8 : 0,
+                                         EGL_DEPTH_SIZE,
+                                         sized ? 24 : 0,
+                                         EGL_NONE };
+    EGLConfig    config              = nullptr;
+    EGLint       configs             = 0;
+    if (!eglChooseConfig(display, config_attributes, &config, 1, &configs) ||
+        configs == 0)
+    {
+        error = "no EGL config renders GLES 3";
+        return false;
+    }
+    // same version and debug flag the windowed path asks SDL for, then
+    // older minor versions, then the same without the debug flag that EGL
+    // before 1.5 rejects
+    for (int attempt = 0; attempt < 6 && !context; ++attempt)
+    {
+        const EGLint context_attributes[] = { EGL_CONTEXT_MAJOR_VERSION,
+                                              3,
+                                              EGL_CONTEXT_MINOR_VERSION,
+                                              2 - attempt % 3,
+                                              EGL_CONTEXT_OPENGL_DEBUG,
+                                              attempt < 3 ? EGL_TRUE
+                                                          : EGL_FALSE,
+                                              EGL_NONE };
+        context = eglCreateContext(
+            display, config, EGL_NO_CONTEXT, context_attributes);
+    }
+    if (!context)
+    {
+        error = "can't create a GLES 3 context";
+        return false;
+    }
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (sized || !has_extension(extensions, "EGL_KHR_surfaceless_context"))
+    {
+        const EGLint pbuffer_attributes[] = { EGL_WIDTH,
+                                              sized ? width : 1,
+                                              EGL_HEIGHT,
+                                              sized ? height : 1,
+                                              EGL_NONE };
+        surface =
+            eglCreatePbufferSurface(display, config, pbuffer_attributes);
+        if (!surface)
+        {
+            error = "can't create a pbuffer surface";
+            return false;
+        }
+    }
+    if (!eglMakeCurrent(display, surface, surface, context))
+    {
+        error = "can't make the EGL context current";
+        return false;
+    }
+    return true;
+}
+
+void* headless_context::get_proc_address(const char* name)
+{
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+#else
+headless_context::~headless_context() = default;
+
+bool headless_context::create(std::string& error, int, int)
+{
+    error = "built without EGL";
+    return false;
+}
+
+void* headless_context::get_proc_address(const char*)
+{
+    return nullptr;
+}
+#endif
+} // namespace eng
@@ -0,0 +1,36 @@
+#ifndef OPENGL_WINDOW_HEADLESS_CONTEXT_HXX
+#define OPENGL_WINDOW_HEADLESS_CONTEXT_HXX
+#include <string>
+
+namespace eng
+{
+// GLES 3.x context without a window: EGL on Mesa's surfaceless platform
+// when available, the default display otherwise, current without a surface
+// when EGL_KHR_surfaceless_context allows it and on a 1x1 pbuffer when not.
+// Without a size given to create there is no default framebuffer worth
+// drawing to and the engine renders into a framebuffer object instead.
+// Builds without EGL (OPENGL_WINDOW_EGL undefined) only fail create
+class headless_context
+{
+public:
+    headless_context() = default;
+    ~headless_context();
+
+    headless_context(const headless_context&)            = delete;
+    headless_context& operator=(const headless_context&) = delete;
+
+    // makes the context current on the calling thread, error says why not.
+    // A size makes a pbuffer with depth of that size the default
+    // framebuffer, for replaying what a window showed
+    bool create(std::string& error, int width = 0, int height = 0);
+
+    // for gladLoadGLES2Loader
+    static void* get_proc_address(const char* name);
+
+private:
+    void* display = nullptr; // EGLDisplay
+    void* context = nullptr; // EGLContext
+    void* surface = nullptr; // EGLSurface, null when surfaceless
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_HEADLESS_CONTEXT_HXX
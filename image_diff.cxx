@@ -0,0 +1,168 @@
+#include "image_diff.hxx"
+
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace eng
+{
+// per pixel counts and the largest delta, four pixels per SSE2 step
+static void count_over(const std::uint8_t* expected,
+                       const std::uint8_t* actual,
+                       std::size_t         pixels,
+                       int                 tolerance,
+                       image_difference&   out)
+{
+    std::size_t i    = 0;
+    int         peak = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(tolerance));
+    __m128i       vpeak = _mm_setzero_si128();
+    for (; i + 4 <= pixels; i += 4)
+    {
+        const __m128i a = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(expected + i * 4));
+        const __m128i b = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(actual + i * 4));
+        // |a - b| with saturating subtractions both ways
+        const __m128i delta =
+            _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+        vpeak = _mm_max_epu8(vpeak, delta);
+        // bytes within tolerance saturate to zero
+        const __m128i within = _mm_cmpeq_epi8(_mm_subs_epu8(delta, limit),
+                                              _mm_setzero_si128());
+        const int     mask   = _mm_movemask_epi8(within);
+        if (mask == 0xffff)
+        {
+            continue;
+        }
+        for (int p = 0; p < 4; ++p)
+        {
+            out.pixels_over += ((mask >> (p * 4)) & 0xf) != 0xf;
+        }
+    }
+    alignas(16) std::uint8_t lanes[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), vpeak);
+    peak = *std::max_element(lanes, lanes + 16);
+#endif
+    for (; i < pixels; ++i)
+    {
+        bool over = false;
+        for (int c = 0; c < 4; ++c)
+        {
+            const int d = std::abs(expected[i * 4 + c] - actual[i * 4 + c]);
+            peak        = std::max(peak, d);
+            over        = over || d > tolerance;
+        }
+        out.pixels_over += over;
+    }
+    out.max_delta = peak;
+}
+
+static float luma(const std::uint8_t* p)
+{
+    return 0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2];
+}
+
+// SSIM of luma over non overlapping 8x8 blocks, the edge blocks take
+// what is left. Less exact than the gaussian window of the paper but
+// cheap, and it still scores structure apart from brightness shifts
+static double block_ssim(const std::uint8_t* expected,
+                         const std::uint8_t* actual,
+                         int                 width,
+                         int                 height)
+{
+    constexpr double c1    = (0.01 * 255) * (0.01 * 255);
+    constexpr double c2    = (0.03 * 255) * (0.03 * 255);
+    constexpr int    block = 8;
+    double           sum   = 0.0;
+    int              count = 0;
+    for (int by = 0; by < height; by += block)
+    {
+        for (int bx = 0; bx < width; bx += block)
+        {
+            double    ma = 0, mb = 0, va = 0, vb = 0, cov = 0;
+            const int ey = std::min(by + block, height);
+            const int ex = std::min(bx + block, width);
+            const int n  = (ey - by) * (ex - bx);
+            for (int y = by; y < ey; ++y)
+            {
+                for (int x = bx; x < ex; ++x)
+                {
+                    const std::size_t o =
+                        (static_cast<std::size_t>(y) * width + x) * 4;
+                    const double      a = luma(expected + o);
+                    const double      b = luma(actual + o);
+                    ma += a;
+                    mb += b;
+                    va += a * a;
+                    vb += b * b;
+                    cov += a * b;
+                }
+            }
+            ma /= n;
+            mb /= n;
+            va  = va / n - ma * ma;
+            vb  = vb / n - mb * mb;
+            cov = cov / n - ma * mb;
+            sum += ((2 * ma * mb + c1) * (2 * cov + c2)) /
+                   ((ma * ma + mb * mb + c1) * (va + vb + c2));
+            ++count;
+        }
+    }
+    return count ? sum / count : 1.0;
+}
+
+static void fill_heatmap(const std::uint8_t*        expected,
+                         const std::uint8_t*        actual,
+                         std::size_t                pixels,
+                         int                        tolerance,
+                         std::vector<std::uint8_t>& heatmap)
+{
+    heatmap.resize(pixels * 4);
+    for (std::size_t i = 0; i < pixels; ++i)
+    {
+        int d = 0;
+        for (int c = 0; c < 4; ++c)
+        {
+            d = std::max(d, std::abs(expected[i * 4 + c] - actual[i * 4 + c]));
+        }
+        const auto    grey =
+            static_cast<std::uint8_t>(luma(expected + i * 4) / 3);
+        std::uint8_t* out = heatmap.data() + i * 4;
+        if (d > tolerance)
+        {
+            // small differences still show, the largest ones saturate
+            out[0] = static_cast<std::uint8_t>(std::min(255, 128 + d * 4));
+            out[1] = grey;
+            out[2] = grey;
+        }
+        else
+        {
+            out[0] = out[1] = out[2] = grey;
+        }
+        out[3] = 255;
+    }
+}
+
+image_difference compare_images(const std::uint8_t*        expected,
+                                const std::uint8_t*        actual,
+                                int                        width,
+                                int                        height,
+                                int                        tolerance,
+                                std::vector<std::uint8_t>* heatmap)
+{
+    image_difference result;
+    result.pixels = static_cast<std::size_t>(width) * height;
+    count_over(expected, actual, result.pixels, tolerance, result);
+    result.ssim = block_ssim(expected, actual, width, height);
+    if (heatmap)
+    {
+        fill_heatmap(expected, actual, result.pixels, tolerance, *heatmap);
+    }
+    return result;
+}
+} // namespace eng
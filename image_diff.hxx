@@ -0,0 +1,28 @@
+#ifndef OPENGL_WINDOW_IMAGE_DIFF_HXX
+#define OPENGL_WINDOW_IMAGE_DIFF_HXX
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace eng
+{
+struct image_difference
+{
+    std::size_t pixels      = 0;
+    std::size_t pixels_over = 0; // a channel differs by more than allowed
+    int         max_delta   = 0; // largest channel difference
+    double      ssim        = 1; // mean over 8x8 blocks of luma
+};
+
+// compares two top down RGBA8 images of the same size. tolerance is the
+// channel difference still counted as equal, it absorbs rounding between
+// drivers. heatmap, when given, is filled with an RGBA image of expected
+// dimmed to grey and differences over tolerance in red
+image_difference compare_images(const std::uint8_t*        expected,
+                                const std::uint8_t*        actual,
+                                int                        width,
+                                int                        height,
+                                int                        tolerance,
+                                std::vector<std::uint8_t>* heatmap = nullptr);
+} // namespace eng
+#endif // OPENGL_WINDOW_IMAGE_DIFF_HXX
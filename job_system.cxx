@@ -0,0 +1,370 @@
+#include "job_system.hxx"
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace eng
+{
+// room for a std::function or a parallel_for chunk, larger callables fail
+// to compile in make_job instead of allocating
+constexpr std::size_t job_inline_bytes = 48;
+
+struct job
+{
+    alignas(std::max_align_t) unsigned char callable[job_inline_bytes];
+    void (*invoke)(void* callable)  = nullptr;
+    void (*destroy)(void* callable) = nullptr;
+    job_counter* counter            = nullptr;
+    job*         next_free          = nullptr;
+    bool         pooled             = false;
+};
+
+// deque owned by the current thread, null on threads the system does not
+// know about
+static thread_local work_stealing_deque* local_deque  = nullptr;
+static thread_local const job_system*    local_system = nullptr;
+static thread_local unsigned             steal_seed   = 0;
+
+work_stealing_deque::work_stealing_deque()
+    : buffer(new std::atomic<job*>[capacity])
+{
+}
+
+bool work_stealing_deque::push(job* j)
+{
+    const std::int64_t b = bottom.load(std::memory_order_relaxed);
+    const std::int64_t t = top.load(std::memory_order_acquire);
+    if (b - t >= capacity)
+    {
+        return false;
+    }
+    buffer[b & (capacity - 1)].store(j, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+job* work_stealing_deque::pop()
+{
+    const std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t t = top.load(std::memory_order_relaxed);
+    if (t > b)
+    {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    job* j = buffer[b & (capacity - 1)].load(std::memory_order_relaxed);
+    if (t == b)
+    {
+        // last element, race the thieves for it
+        if (!top.compare_exchange_strong(t,
+                                         t + 1,
+                                         std::memory_order_seq_cst,
+                                         std::memory_order_relaxed))
+        {
+            j = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return j;
+}
+
+job* work_stealing_deque::steal()
+{
+    std::int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b)
+    {
+        return nullptr;
+    }
+    job* j = buffer[t & (capacity - 1)].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(
+            t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+    return j;
+}
+
+unsigned job_system::default_worker_count()
+{
+    const unsigned cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 1;
+}
+
+job_system::job_system(unsigned worker_count)
+{
+    deques.reserve(worker_count + 1);
+    for (unsigned i = 0; i <= worker_count; ++i)
+    {
+        deques.push_back(std::make_unique<work_stealing_deque>());
+    }
+    local_deque  = deques[0].get();
+    local_system = this;
+
+    job_storage.reset(new job[pooled_jobs]);
+    for (std::size_t i = 0; i < pooled_jobs; ++i)
+    {
+        job_storage[i].pooled    = true;
+        job_storage[i].next_free = free_jobs;
+        free_jobs                = &job_storage[i];
+    }
+
+    workers.reserve(worker_count);
+    for (unsigned i = 0; i < worker_count; ++i)
+    {
+        workers.emplace_back(&job_system::worker_loop, this, i);
+    }
+}
+
+job_system::~job_system()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stop = true;
+    }
+    sleep_cv.notify_all();
+    for (std::thread& t : workers)
+    {
+        t.join();
+    }
+    if (local_system == this)
+    {
+        local_deque  = nullptr;
+        local_system = nullptr;
+    }
+}
+
+job* job_system::acquire_job()
+{
+    {
+        std::lock_guard<std::mutex> lock(free_mutex);
+        if (job* j = free_jobs)
+        {
+            free_jobs = j->next_free;
+            return j;
+        }
+    }
+    // the pool is exhausted, the job is freed again in release_job
+    return new job;
+}
+
+void job_system::release_job(job* j)
+{
+    j->destroy(j->callable);
+    if (!j->pooled)
+    {
+        delete j;
+        return;
+    }
+    std::lock_guard<std::mutex> lock(free_mutex);
+    j->next_free = free_jobs;
+    free_jobs    = j;
+}
+
+template <typename F>
+job* job_system::make_job(F&& fn, job_counter* counter)
+{
+    using fn_type = std::decay_t<F>;
+    static_assert(sizeof(fn_type) <= job_inline_bytes,
+                  "job callable too large to store inline");
+    static_assert(alignof(fn_type) <= alignof(std::max_align_t),
+                  "job callable over aligned");
+    job* j = acquire_job();
+    new (j->callable) fn_type(std::forward<F>(fn));
+    j->invoke  = [](void* f) { (*static_cast<fn_type*>(f))(); };
+    j->destroy = [](void* f) { static_cast<fn_type*>(f)->~fn_type(); };
+    j->counter = counter;
+    return j;
+}
+
+void job_system::run(job_fn fn, job_counter* counter)
+{
+    if (counter)
+    {
+        std::lock_guard<std::mutex> lock(counter->continuation_mutex);
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    schedule(make_job(std::move(fn), counter));
+}
+
+void job_system::run_after(job_counter& dependency,
+                           job_fn       fn,
+                           job_counter* counter)
+{
+    if (counter)
+    {
+        std::lock_guard<std::mutex> lock(counter->continuation_mutex);
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    job* j = make_job(std::move(fn), counter);
+    {
+        std::lock_guard<std::mutex> lock(dependency.continuation_mutex);
+        if (dependency.pending.load(std::memory_order_relaxed) != 0)
+        {
+            dependency.continuations.push_back(j);
+            return;
+        }
+    }
+    schedule(j);
+}
+
+void job_system::schedule(job* j)
+{
+    queued.fetch_add(1, std::memory_order_release);
+    if (local_system != this || !local_deque->push(j))
+    {
+        std::lock_guard<std::mutex> lock(shared_mutex);
+        shared_queue.push_back(j);
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    sleep_cv.notify_one();
+}
+
+job* job_system::find_job()
+{
+    if (queued.load(std::memory_order_acquire) == 0)
+    {
+        return nullptr;
+    }
+    job* j = nullptr;
+    if (local_system == this)
+    {
+        j = local_deque->pop();
+    }
+    if (!j)
+    {
+        // start stealing at a different victim on every thread
+        const std::size_t count = deques.size();
+        const std::size_t first = steal_seed++ % count;
+        for (std::size_t i = 0; i < count && !j; ++i)
+        {
+            work_stealing_deque* victim = deques[(first + i) % count].get();
+            if (victim != local_deque)
+            {
+                j = victim->steal();
+            }
+        }
+    }
+    if (!j)
+    {
+        std::lock_guard<std::mutex> lock(shared_mutex);
+        if (!shared_queue.empty())
+        {
+            j = shared_queue.front();
+            shared_queue.pop_front();
+        }
+    }
+    if (j)
+    {
+        queued.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return j;
+}
+
+void job_system::execute(job* j)
+{
+    j->invoke(j->callable);
+    job_counter* counter = j->counter;
+    release_job(j);
+    if (counter)
+    {
+        finish(counter);
+    }
+}
+
+void job_system::finish(job_counter* counter)
+{
+    std::vector<job*> ready;
+    {
+        std::lock_guard<std::mutex> lock(counter->continuation_mutex);
+        if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            ready.swap(counter->continuations);
+        }
+    }
+    for (job* j : ready)
+    {
+        schedule(j);
+    }
+}
+
+void job_system::wait(job_counter& counter)
+{
+    while (!counter.done())
+    {
+        if (job* j = find_job())
+        {
+            execute(j);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    // the job that finished last may still hold the lock, the counter must
+    // not go out of scope before it lets go
+    std::lock_guard<std::mutex> lock(counter.continuation_mutex);
+}
+
+void job_system::run_chunks(std::size_t       begin,
+                            std::size_t       end,
+                            std::size_t       grain,
+                            const range_call& call)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+    grain = std::max<std::size_t>(grain, 1);
+    if (end - begin <= grain)
+    {
+        call.invoke(call.fn, begin, end);
+        return;
+    }
+    job_counter counter;
+    // the calling thread keeps the first chunk for itself
+    for (std::size_t b = begin + grain; b < end; b += grain)
+    {
+        const std::size_t e = std::min(end, b + grain);
+        {
+            std::lock_guard<std::mutex> lock(counter.continuation_mutex);
+            counter.pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        schedule(make_job([call, b, e] { call.invoke(call.fn, b, e); },
+                          &counter));
+    }
+    call.invoke(call.fn, begin, std::min(end, begin + grain));
+    wait(counter);
+}
+
+void job_system::worker_loop(unsigned index)
+{
+    local_deque  = deques[index + 1].get();
+    local_system = this;
+    steal_seed   = index + 1;
+
+    while (!stop.load(std::memory_order_acquire))
+    {
+        if (job* j = find_job())
+        {
+            execute(j);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleep_cv.wait(lock,
+                      [this]
+                      {
+                          return stop.load(std::memory_order_relaxed) ||
+                                 queued.load(std::memory_order_relaxed) > 0;
+                      });
+    }
+}
+} // namespace eng
@@ -0,0 +1,140 @@
+#ifndef OPENGL_WINDOW_JOB_SYSTEM_HXX
+#define OPENGL_WINDOW_JOB_SYSTEM_HXX
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace eng
+{
+struct job;
+
+// number of unfinished jobs started with it, jobs queued with
+// job_system::run_after start once it drops to zero
+class job_counter
+{
+public:
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class job_system;
+    std::atomic<int>  pending{ 0 };
+    std::mutex        continuation_mutex;
+    std::vector<job*> continuations;
+};
+
+// Chase-Lev deque: the owning thread pushes and pops at the bottom, any
+// other thread steals from the top
+class work_stealing_deque
+{
+public:
+    static constexpr std::int64_t capacity = 4096;
+
+    work_stealing_deque();
+    bool push(job* j); // owner only, false when full
+    job* pop();        // owner only
+    job* steal();      // any thread
+
+private:
+    alignas(64) std::atomic<std::int64_t> top{ 0 };
+    alignas(64) std::atomic<std::int64_t> bottom{ 0 };
+    std::unique_ptr<std::atomic<job*>[]> buffer;
+};
+
+// jobs come from a fixed pool and keep their callable inline, so running
+// them allocates nothing until more than pooled_jobs are in flight at once
+class job_system
+{
+public:
+    using job_fn = std::function<void()>;
+
+    static constexpr std::size_t pooled_jobs = 4096;
+
+    // the constructing thread becomes a participant: it owns a deque and
+    // executes jobs while it waits
+    explicit job_system(unsigned worker_count = default_worker_count());
+    ~job_system();
+
+    job_system(const job_system&)            = delete;
+    job_system& operator=(const job_system&) = delete;
+
+    // counter is incremented now and decremented when fn has run
+    void run(job_fn fn, job_counter* counter = nullptr);
+    // fn is started once dependency reaches zero
+    void run_after(job_counter& dependency,
+                   job_fn       fn,
+                   job_counter* counter = nullptr);
+    // executes queued jobs on the calling thread until counter is zero
+    void wait(job_counter& counter);
+    // calls fn(chunk_begin, chunk_end) over [begin, end) in chunks of at
+    // most grain indices spread over all threads, returns when every chunk
+    // is done. fn is called by reference, it is neither copied nor wrapped
+    template <typename F>
+    void parallel_for(std::size_t begin,
+                      std::size_t end,
+                      std::size_t grain,
+                      F&&         fn)
+    {
+        using fn_type = std::remove_reference_t<F>;
+        const range_call call{
+            const_cast<void*>(static_cast<const void*>(std::addressof(fn))),
+            [](void* f, std::size_t b, std::size_t e)
+            { (*static_cast<fn_type*>(f))(b, e); }
+        };
+        run_chunks(begin, end, grain, call);
+    }
+
+    unsigned worker_count() const
+    {
+        return static_cast<unsigned>(workers.size());
+    }
+    static unsigned default_worker_count();
+
+private:
+    // a range function by reference, all a parallel_for chunk carries
+    struct range_call
+    {
+        void* fn;
+        void (*invoke)(void* fn, std::size_t begin, std::size_t end);
+    };
+
+    void run_chunks(std::size_t       begin,
+                    std::size_t       end,
+                    std::size_t       grain,
+                    const range_call& call);
+    template <typename F>
+    job* make_job(F&& fn, job_counter* counter);
+    job* acquire_job();
+    void release_job(job* j);
+    void schedule(job* j);
+    job* find_job();
+    void execute(job* j);
+    void finish(job_counter* counter);
+    void worker_loop(unsigned index);
+
+    // deque 0 belongs to the constructing thread, deque i + 1 to worker i
+    std::vector<std::unique_ptr<work_stealing_deque>> deques;
+    std::vector<std::thread>                          workers;
+
+    std::unique_ptr<job[]> job_storage;
+    std::mutex             free_mutex;
+    job*                   free_jobs = nullptr;
+
+    // jobs pushed by threads that own no deque or found theirs full
+    std::mutex       shared_mutex;
+    std::deque<job*> shared_queue;
+
+    std::atomic<int>        queued{ 0 };
+    std::mutex              sleep_mutex;
+    std::condition_variable sleep_cv;
+    std::atomic<bool>       stop{ false };
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_JOB_SYSTEM_HXX
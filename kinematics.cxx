@@ -0,0 +1,313 @@
+#include "kinematics.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "job_system.hxx"
+#include "sprite_renderer.hxx"
+
+namespace eng
+{
+namespace
+{
+constexpr float two_pi = 6.28318531f;
+constexpr int   arrays = 11;
+} // namespace
+
+void unit_kinematics::aligned_free::operator()(float* p) const
+{
+    std::free(p);
+}
+
+unit_kinematics::unit_kinematics(const kinematics_desc& desc,
+                                 std::size_t            capacity)
+    : config(desc)
+    , max_count(capacity)
+{
+    const std::size_t padded = (capacity + lanes - 1) / lanes * lanes;
+    const std::size_t bytes  = padded * sizeof(float) * arrays;
+    void* block = std::aligned_alloc(lanes * sizeof(float), bytes);
+    if (!block)
+    {
+        throw std::bad_alloc();
+    }
+    storage.reset(static_cast<float*>(block));
+    std::fill_n(storage.get(), padded * arrays, 0.f);
+    px           = storage.get();
+    py           = px + padded;
+    prev_x       = py + padded;
+    prev_y       = prev_x + padded;
+    pvx          = prev_y + padded;
+    pvy          = pvx + padded;
+    pax          = pvy + padded;
+    pay          = pax + padded;
+    heading      = pay + padded;
+    prev_heading = heading + padded;
+    spin         = prev_heading + padded;
+}
+
+std::size_t unit_kinematics::add(glm::vec2 position, float angle)
+{
+    if (count == max_count)
+    {
+        return npos;
+    }
+    const std::size_t i = count++;
+    px[i] = prev_x[i] = position.x;
+    py[i] = prev_y[i] = position.y;
+    heading[i] = prev_heading[i] = angle;
+    pvx[i] = pvy[i] = pax[i] = pay[i] = spin[i] = 0.f;
+    return i;
+}
+
+std::size_t unit_kinematics::remove(std::size_t index)
+{
+    --count;
+    if (index == count)
+    {
+        return npos;
+    }
+    for (float* a : { px,
+                      py,
+                      prev_x,
+                      prev_y,
+                      pvx,
+                      pvy,
+                      pax,
+                      pay,
+                      heading,
+                      prev_heading,
+                      spin })
+    {
+        a[index] = a[count];
+    }
+    return count;
+}
+
+void unit_kinematics::set_controls(std::size_t index,
+                                   glm::vec2   acceleration,
+                                   float       angular_velocity)
+{
+    pax[index]  = acceleration.x;
+    pay[index]  = acceleration.y;
+    spin[index] = angular_velocity;
+}
+
+void unit_kinematics::drive(std::size_t index,
+                            float       thrust,
+                            float       angular_velocity)
+{
+    set_controls(index,
+                 glm::vec2(std::cos(heading[index]),
+                           std::sin(heading[index])) *
+                     thrust,
+                 angular_velocity);
+}
+
+void unit_kinematics::set_velocity(std::size_t index, glm::vec2 velocity)
+{
+    pvx[index] = velocity.x;
+    pvy[index] = velocity.y;
+}
+
+int unit_kinematics::take_ticks(float dt)
+{
+    accumulator += dt;
+    int ticks = static_cast<int>(accumulator / config.tick);
+    if (ticks > config.max_ticks)
+    {
+        ticks       = config.max_ticks;
+        accumulator = 0.f;
+    }
+    else
+    {
+        accumulator -= static_cast<float>(ticks) * config.tick;
+    }
+    return ticks;
+}
+
+int unit_kinematics::step(float dt)
+{
+    const int ticks = take_ticks(dt);
+    run_ticks(0, count, ticks);
+    return ticks;
+}
+
+int unit_kinematics::step(float dt, job_system& jobs)
+{
+    const int ticks = take_ticks(dt);
+    // units don't interact, so no job waits for the others between ticks
+    constexpr std::size_t grain = 16384;
+    jobs.parallel_for(0,
+                      count,
+                      grain,
+                      [&](std::size_t begin, std::size_t end)
+                      { run_ticks(begin, end, ticks); });
+    return ticks;
+}
+
+// every tick over a block small enough to stay in L1 before moving on
+void unit_kinematics::run_ticks(std::size_t begin,
+                                std::size_t end,
+                                int         ticks)
+{
+    constexpr std::size_t block = 1024;
+    for (std::size_t b = begin; b < end; b += block)
+    {
+        const std::size_t e = std::min(b + block, end);
+        for (int t = 0; t < ticks; ++t)
+        {
+            integrate(b, e);
+        }
+    }
+}
+
+// v = (v + a * dt) * keep, limited to max_speed; p += v * dt, clamped to
+// the bounds where the velocity into the bound is dropped; the heading
+// turns by spin * dt and is wrapped to [-pi, pi] together with the
+// previous one so blending never crosses the wrap.
+// begin is always a multiple of lanes, reading past end stays inside the
+// padded arrays and only touches unused slots
+void unit_kinematics::integrate(std::size_t begin, std::size_t end)
+{
+    const float     dt   = config.tick;
+    const float     keep = std::max(0.f, 1.f - config.damping * dt);
+    const glm::vec2 lo   = config.bounds_min + glm::vec2(config.radius);
+    const glm::vec2 hi   = config.bounds_max - glm::vec2(config.radius);
+    std::size_t     i    = begin;
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128 vdt    = _mm_set1_ps(dt);
+    const __m128 vkeep  = _mm_set1_ps(keep);
+    const __m128 vmax   = _mm_set1_ps(config.max_speed);
+    const __m128 tiny   = _mm_set1_ps(1e-30f);
+    const __m128 one    = _mm_set1_ps(1.f);
+    const __m128 lox    = _mm_set1_ps(lo.x);
+    const __m128 loy    = _mm_set1_ps(lo.y);
+    const __m128 hix    = _mm_set1_ps(hi.x);
+    const __m128 hiy    = _mm_set1_ps(hi.y);
+    const __m128 turn   = _mm_set1_ps(two_pi);
+    const __m128 inturn = _mm_set1_ps(1.f / two_pi);
+    for (; i < end; i += 4)
+    {
+        __m128 vx = _mm_load_ps(pvx + i);
+        __m128 vy = _mm_load_ps(pvy + i);
+        vx = _mm_mul_ps(_mm_add_ps(vx, _mm_mul_ps(_mm_load_ps(pax + i), vdt)),
+                        vkeep);
+        vy = _mm_mul_ps(_mm_add_ps(vy, _mm_mul_ps(_mm_load_ps(pay + i), vdt)),
+                        vkeep);
+        const __m128 speed = _mm_sqrt_ps(_mm_max_ps(
+            _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), tiny));
+        const __m128 limit = _mm_min_ps(one, _mm_div_ps(vmax, speed));
+        vx                 = _mm_mul_ps(vx, limit);
+        vy                 = _mm_mul_ps(vy, limit);
+
+        const __m128 x  = _mm_load_ps(px + i);
+        const __m128 y  = _mm_load_ps(py + i);
+        const __m128 nx = _mm_add_ps(x, _mm_mul_ps(vx, vdt));
+        const __m128 ny = _mm_add_ps(y, _mm_mul_ps(vy, vdt));
+        const __m128 cx = _mm_min_ps(_mm_max_ps(nx, lox), hix);
+        const __m128 cy = _mm_min_ps(_mm_max_ps(ny, loy), hiy);
+        vx              = _mm_andnot_ps(_mm_cmpneq_ps(cx, nx), vx);
+        vy              = _mm_andnot_ps(_mm_cmpneq_ps(cy, ny), vy);
+        _mm_store_ps(prev_x + i, x);
+        _mm_store_ps(prev_y + i, y);
+        _mm_store_ps(px + i, cx);
+        _mm_store_ps(py + i, cy);
+        _mm_store_ps(pvx + i, vx);
+        _mm_store_ps(pvy + i, vy);
+
+        const __m128 a = _mm_load_ps(heading + i);
+        const __m128 na =
+            _mm_add_ps(a, _mm_mul_ps(_mm_load_ps(spin + i), vdt));
+        const __m128 wrap = _mm_mul_ps(
+            _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(na, inturn))), turn);
+        _mm_store_ps(prev_heading + i, _mm_sub_ps(a, wrap));
+        _mm_store_ps(heading + i, _mm_sub_ps(na, wrap));
+    }
+#else
+    for (; i < end; ++i)
+    {
+        float       vx    = (pvx[i] + pax[i] * dt) * keep;
+        float       vy    = (pvy[i] + pay[i] * dt) * keep;
+        const float speed = std::sqrt(std::max(vx * vx + vy * vy, 1e-30f));
+        const float limit = std::min(1.f, config.max_speed / speed);
+        vx *= limit;
+        vy *= limit;
+
+        const float nx = px[i] + vx * dt;
+        const float ny = py[i] + vy * dt;
+        const float cx = std::min(std::max(nx, lo.x), hi.x);
+        const float cy = std::min(std::max(ny, lo.y), hi.y);
+        prev_x[i]      = px[i];
+        prev_y[i]      = py[i];
+        px[i]          = cx;
+        py[i]          = cy;
+        pvx[i]         = cx != nx ? 0.f : vx;
+        pvy[i]         = cy != ny ? 0.f : vy;
+
+        const float na   = heading[i] + spin[i] * dt;
+        const float wrap = std::nearbyint(na / two_pi) * two_pi;
+        prev_heading[i]  = heading[i] - wrap;
+        heading[i]       = na - wrap;
+    }
+#endif
+}
+
+glm::vec2 unit_kinematics::velocity(std::size_t index) const
+{
+    return glm::vec2(pvx[index], pvy[index]);
+}
+
+glm::vec2 unit_kinematics::position(std::size_t index) const
+{
+    const float t = alpha();
+    return glm::vec2(prev_x[index] + (px[index] - prev_x[index]) * t,
+                     prev_y[index] + (py[index] - prev_y[index]) * t);
+}
+
+float unit_kinematics::angle(std::size_t index) const
+{
+    return prev_heading[index] +
+           (heading[index] - prev_heading[index]) * alpha();
+}
+
+void unit_kinematics::write_transforms(glm::mat4*  out,
+                                       std::size_t first,
+                                       std::size_t n,
+                                       glm::vec2   size,
+                                       float       rotation) const
+{
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        const std::size_t i = first + k;
+        const glm::vec2   p = position(i);
+        const float       a = angle(i) + rotation;
+        const float       c = std::cos(a);
+        const float       s = std::sin(a);
+        glm::mat4&        m = out[k];
+        m    = glm::mat4(1.f);
+        m[0] = glm::vec4(c * size.x, s * size.x, 0.f, 0.f);
+        m[1] = glm::vec4(-s * size.y, c * size.y, 0.f, 0.f);
+        m[3] = glm::vec4(p.x, p.y, 0.f, 1.f);
+    }
+}
+
+void unit_kinematics::write_instances(sprite_instance* out,
+                                      std::size_t      first,
+                                      std::size_t      n,
+                                      glm::vec2        size,
+                                      float            rotation) const
+{
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        place_sprite(
+            out[k], position(first + k), size, angle(first + k) + rotation);
+    }
+}
+} // namespace eng
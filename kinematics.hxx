@@ -0,0 +1,120 @@
+#ifndef OPENGL_WINDOW_KINEMATICS_HXX
+#define OPENGL_WINDOW_KINEMATICS_HXX
+#include <cstddef>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+namespace eng
+{
+class job_system;
+struct sprite_instance;
+
+struct kinematics_desc
+{
+    float tick      = 1.f / 60.f; // seconds per integration step
+    int   max_ticks = 8; // per step call, the rest of a longer hitch is lost
+    float max_speed = 1.f; // world units per second
+    float damping   = 0.f; // share of the velocity lost per second
+    // unit centres stay radius inside the bounds, velocity into a bound is
+    // dropped
+    glm::vec2 bounds_min{ -1e30f, -1e30f };
+    glm::vec2 bounds_max{ 1e30f, 1e30f };
+    float     radius = 0.f;
+};
+
+// position, velocity, acceleration, heading and angular velocity of units
+// as a structure of arrays, integrated on fixed ticks. Units are packed in
+// [0, size()) like sprite_animator, removal moves the last one into the
+// hole. Rendering reads the state blended between the last two ticks
+class unit_kinematics
+{
+public:
+    // arrays are padded to this many floats so the SIMD loop has no tail
+    static constexpr std::size_t lanes = 8;
+    static constexpr std::size_t npos  = static_cast<std::size_t>(-1);
+
+    unit_kinematics(const kinematics_desc& desc, std::size_t capacity);
+
+    std::size_t size() const { return count; }
+    std::size_t capacity() const { return max_count; }
+
+    // angle in radians counter clockwise from +x, npos when full
+    std::size_t add(glm::vec2 position, float angle);
+    // the last unit moves into index, returns the index it came from (the
+    // new size()) or npos when index was the last one
+    std::size_t remove(std::size_t index);
+
+    // world space acceleration and angular velocity, kept until changed
+    void set_controls(std::size_t index,
+                      glm::vec2   acceleration,
+                      float       angular_velocity);
+    // acceleration along the current heading, for units that drive like a
+    // tank. Call again when the heading changed
+    void drive(std::size_t index, float thrust, float angular_velocity);
+    void set_velocity(std::size_t index, glm::vec2 velocity);
+
+    // runs the whole ticks dt and the time left over from the previous
+    // call add up to, returns how many
+    int step(float dt);
+    // same, each job runs every tick over its share of the units
+    int step(float dt, job_system& jobs);
+
+    // how far the time left over is into the next tick, 0 to 1
+    float alpha() const { return accumulator / config.tick; }
+    // state of the last tick
+    glm::vec2 velocity(std::size_t index) const;
+    // blended by alpha between the last two ticks
+    glm::vec2 position(std::size_t index) const;
+    // positions of the last tick, size() of each, for unit_grid::build
+    const float* x() const { return px; }
+    const float* y() const { return py; }
+    float     angle(std::size_t index) const;
+
+    // model matrices of units [first, first + n) for the quad spanning
+    // -0.5 to 0.5: scaled by size, turned by the heading plus rotation, for
+    // art that doesn't face +x, and moved to the blended position
+    void write_transforms(glm::mat4*  out,
+                          std::size_t first,
+                          std::size_t n,
+                          glm::vec2   size,
+                          float       rotation = 0.f) const;
+    // the same placement written into the instanced sprite stream, uv is
+    // left alone
+    void write_instances(sprite_instance* out,
+                         std::size_t      first,
+                         std::size_t      n,
+                         glm::vec2        size,
+                         float            rotation = 0.f) const;
+
+    const kinematics_desc& desc() const { return config; }
+
+private:
+    int  take_ticks(float dt);
+    void run_ticks(std::size_t begin, std::size_t end, int ticks);
+    void integrate(std::size_t begin, std::size_t end);
+
+    struct aligned_free
+    {
+        void operator()(float* p) const;
+    };
+
+    kinematics_desc                        config;
+    std::size_t                            max_count;
+    std::size_t                            count       = 0;
+    float                                  accumulator = 0.f;
+    std::unique_ptr<float[], aligned_free> storage;
+    float*                                 px;
+    float*                                 py;
+    float*                                 prev_x;
+    float*                                 prev_y;
+    float*                                 pvx;
+    float*                                 pvy;
+    float*                                 pax;
+    float*                                 pay;
+    float*                                 heading;
+    float*                                 prev_heading;
+    float*                                 spin;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_KINEMATICS_HXX
@@ -0,0 +1,106 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "job_system.hxx"
+#include "kinematics.hxx"
+
+// integrates a full set of units a tick per frame, each steering with its
+// own acceleration and turn rate inside bounds they keep running into, and
+// emits their model matrices. Reported as units per millisecond
+namespace
+{
+using clock = std::chrono::steady_clock;
+
+struct result
+{
+    double integrate_ms = 0.0; // per frame
+    double emit_ms      = 0.0;
+};
+
+double since(clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(clock::now() - start)
+        .count();
+}
+
+result run(std::size_t count, int frames, eng::job_system* jobs)
+{
+    eng::kinematics_desc desc;
+    desc.max_speed  = 2.f;
+    desc.damping    = 0.5f;
+    desc.bounds_min = glm::vec2(-50.f, -50.f);
+    desc.bounds_max = glm::vec2(50.f, 50.f);
+    desc.radius     = 0.05f;
+    eng::unit_kinematics units(desc, count);
+
+    std::uint32_t seed   = 1u;
+    auto          random = [&]
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return static_cast<float>(seed >> 8) / 16777216.f;
+    };
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const std::size_t u = units.add(
+            glm::vec2(random() * 100.f - 50.f, random() * 100.f - 50.f),
+            random() * 6.f);
+        units.drive(u, 1.f + random() * 3.f, random() * 2.f - 1.f);
+    }
+
+    std::vector<glm::mat4> transforms(count);
+    result                 r;
+    for (int f = 0; f < frames; ++f)
+    {
+        const clock::time_point start = clock::now();
+        if (jobs)
+        {
+            units.step(desc.tick, *jobs);
+        }
+        else
+        {
+            units.step(desc.tick);
+        }
+        r.integrate_ms += since(start);
+
+        const clock::time_point emit = clock::now();
+        units.write_transforms(
+            transforms.data(), 0, count, glm::vec2(0.1f), 0.f);
+        r.emit_ms += since(emit);
+    }
+    r.integrate_ms /= frames;
+    r.emit_ms /= frames;
+    return r;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    // signed so a negative count is rejected instead of wrapping around
+    const long long unit_count = argc > 1 ? std::stoll(argv[1]) : 1000000;
+    const int       frames     = argc > 2 ? std::stoi(argv[2]) : 200;
+    if (unit_count < 1 || frames < 1)
+    {
+        std::cerr << "kinematics_bench: units and frames must be at least 1"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::size_t count = static_cast<std::size_t>(unit_count);
+
+    const result    single = run(count, frames, nullptr);
+    eng::job_system jobs;
+    const result    parallel = run(count, frames, &jobs);
+
+    std::cout << "units " << count << " frames " << frames << std::endl;
+    std::cout << "single   " << count / single.integrate_ms
+              << " units/ms integrated, " << count / single.emit_ms
+              << " matrices/ms emitted" << std::endl;
+    std::cout << "parallel " << count / parallel.integrate_ms
+              << " units/ms integrated with " << jobs.worker_count() + 1
+              << " threads" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,29 @@
+#version 320 es
+
+precision mediump float;
+out vec4 FragColor;
+in vec2  Local;
+in float Age;
+uniform sampler2D ourTexture;
+uniform bool      textured;
+uniform vec4      color_start;
+uniform vec4      color_end;
+void main()
+{
+    vec4 color = mix(color_start, color_end, Age);
+    if (textured)
+    {
+        color *= texture(ourTexture, Local);
+    }
+    else
+    {
+        // soft round dot
+        float d = length(Local - 0.5) * 2.0;
+        color.a *= clamp(1.0 - d * d, 0.0, 1.0);
+    }
+    if (color.a == 0.0)
+    {
+        discard;
+    }
+    FragColor = color;
+}
@@ -0,0 +1,35 @@
+#version 320 es
+
+precision highp float;
+// one unit quad shared by every particle, the rest is per instance
+layout (location = 0) in vec2 aCorner;
+#ifdef GPU_PARTICLES
+layout (location = 1) in vec4 aParticle; // x, y, age, life
+#else
+layout (location = 1) in vec4 aParticle; // x, y, age / life, unused
+#endif
+
+out vec2  Local;
+out float Age;
+
+layout (std140, binding = 0) uniform camera_block
+{
+    mat4 view_projection;
+    vec4 viewport;
+};
+uniform float size_start;
+uniform float size_end;
+
+void main()
+{
+#ifdef GPU_PARTICLES
+    float t = clamp(aParticle.z / aParticle.w, 0.0, 1.0);
+#else
+    float t = aParticle.z;
+#endif
+    float size = mix(size_start, size_end, t);
+    vec2  pos  = aParticle.xy + aCorner * size;
+    gl_Position = view_projection * vec4(pos, 0.0, 1.0);
+    Local = aCorner + 0.5;
+    Age   = t;
+}
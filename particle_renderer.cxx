@@ -0,0 +1,126 @@
+#include "particle_renderer.hxx"
+
+#include <algorithm>
+
+#include "gl_check.hxx"
+#include "particles.hxx"
+#include "render_stats.hxx"
+#include "shader.hxx"
+#include "vertex_ring.hxx"
+
+namespace eng
+{
+struct particle_instance
+{
+    float x;
+    float y;
+    float t; // age / life
+    float pad;
+};
+
+particle_renderer::particle_renderer(std::size_t max_particles_per_frame)
+{
+    shader    = std::make_unique<Shader>("particle.vert", "particle.frag");
+    instances = std::make_unique<vertex_ring>(
+        GL_ARRAY_BUFFER, max_particles_per_frame * sizeof(particle_instance));
+
+    const float corners[] = { -0.5f, -0.5f, 0.5f, -0.5f,
+                              -0.5f, 0.5f,  0.5f, 0.5f };
+    glGenBuffers(1, &quad_vbo);
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(0);
+    // instance attribute, its offset is set per draw
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glBindVertexArray(0);
+    OM_GL_CHECK(glBindVertexArray)
+
+    instances->begin_region();
+}
+
+particle_renderer::~particle_renderer()
+{
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &quad_vbo);
+}
+
+void particle_renderer::begin_frame()
+{
+    instances->begin_region();
+}
+
+void particle_renderer::end_frame()
+{
+    instances->end_region();
+}
+
+std::size_t particle_renderer::draw(const particle_emitter& emitter)
+{
+    const particle_pool& pool = emitter.particles();
+    const std::size_t    budget =
+        instances->region_size() / sizeof(particle_instance);
+    const std::size_t n = std::min(pool.size(), budget);
+    if (n == 0)
+    {
+        return 0;
+    }
+    std::size_t offset;
+    auto*       dst = static_cast<particle_instance*>(instances->allocate(
+        n * sizeof(particle_instance), sizeof(particle_instance), offset));
+    if (!dst)
+    {
+        // the frame's budget is used up, the emitter skips this frame
+        return 0;
+    }
+    const float* x    = pool.x();
+    const float* y    = pool.y();
+    const float* age  = pool.age();
+    const float* life = pool.life();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        dst[i] = { x[i], y[i], std::min(age[i] / life[i], 1.f), 0.f };
+    }
+    instances->unmap();
+
+    const particle_emitter_desc& d = emitter.desc();
+    shader->use();
+    shader->setFloat("size_start", d.size_start);
+    shader->setFloat("size_end", d.size_end);
+    shader->setVec4("color_start",
+                    d.color_start.x,
+                    d.color_start.y,
+                    d.color_start.z,
+                    d.color_start.w);
+    shader->setVec4("color_end",
+                    d.color_end.x,
+                    d.color_end.y,
+                    d.color_end.z,
+                    d.color_end.w);
+    shader->setInt("textured", d.texture != 0);
+    shader->setInt("ourTexture", 0);
+    if (d.texture != 0)
+    {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, d.texture);
+        count_texture_bind();
+    }
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instances->buffer());
+    glVertexAttribPointer(1,
+                          4,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          sizeof(particle_instance),
+                          reinterpret_cast<void*>(offset));
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(n));
+    OM_GL_CHECK(glDrawArraysInstanced)
+    count_draw(2 * n);
+    glBindVertexArray(0);
+    return n;
+}
+} // namespace eng
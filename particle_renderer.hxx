@@ -0,0 +1,36 @@
+#ifndef OPENGL_WINDOW_PARTICLE_RENDERER_HXX
+#define OPENGL_WINDOW_PARTICLE_RENDERER_HXX
+#include <cstddef>
+#include <memory>
+
+#include "glad/glad.h"
+
+namespace eng
+{
+class particle_emitter;
+class vertex_ring;
+struct Shader;
+
+// draws an emitter with one instanced draw call, the per particle data is
+// streamed through a vertex ring
+class particle_renderer
+{
+public:
+    // the ring holds max_particles_per_frame instances per frame in flight,
+    // particles past it are not drawn that frame
+    explicit particle_renderer(std::size_t max_particles_per_frame);
+    ~particle_renderer();
+
+    void begin_frame();
+    void end_frame();
+    // returns the number of particles drawn
+    std::size_t draw(const particle_emitter& emitter);
+
+private:
+    std::unique_ptr<Shader>      shader;
+    std::unique_ptr<vertex_ring> instances;
+    GLuint                       quad_vbo = 0;
+    GLuint                       vao      = 0;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_PARTICLE_RENDERER_HXX
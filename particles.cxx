@@ -0,0 +1,244 @@
+#include "particles.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "job_system.hxx"
+
+namespace eng
+{
+void particle_pool::aligned_free::operator()(float* p) const
+{
+    std::free(p);
+}
+
+particle_pool::particle_pool(std::size_t capacity)
+    : max_count(capacity)
+{
+    const std::size_t padded = (capacity + lanes - 1) / lanes * lanes;
+    const std::size_t bytes  = padded * sizeof(float) * 6;
+    void*             block  = std::aligned_alloc(lanes * sizeof(float), bytes);
+    if (!block)
+    {
+        throw std::bad_alloc();
+    }
+    storage.reset(static_cast<float*>(block));
+    std::fill_n(storage.get(), padded * 6, 0.f);
+    px    = storage.get();
+    py    = px + padded;
+    pvx   = py + padded;
+    pvy   = pvx + padded;
+    page  = pvy + padded;
+    plife = page + padded;
+}
+
+bool particle_pool::spawn(glm::vec2 position, glm::vec2 velocity, float life)
+{
+    if (count == max_count)
+    {
+        return false;
+    }
+    px[count]    = position.x;
+    py[count]    = position.y;
+    pvx[count]   = velocity.x;
+    pvy[count]   = velocity.y;
+    page[count]  = 0.f;
+    plife[count] = life;
+    ++count;
+    return true;
+}
+
+void particle_pool::update(float dt, glm::vec2 gravity, float drag)
+{
+    integrate(0, count, dt, gravity, drag);
+    remove_dead();
+}
+
+void particle_pool::update(float       dt,
+                           glm::vec2   gravity,
+                           float       drag,
+                           job_system& jobs)
+{
+    // 16k particles per job keeps a chunk inside L2 and the job count low
+    constexpr std::size_t grain = 16384;
+    jobs.parallel_for(0,
+                      count,
+                      grain,
+                      [&](std::size_t begin, std::size_t end)
+                      { integrate(begin, end, dt, gravity, drag); });
+    remove_dead();
+}
+
+// v += (gravity - drag * v) * dt; p += v * dt; age += dt
+// begin is always a multiple of lanes, reading past end stays inside the
+// padded arrays and only touches dead slots
+void particle_pool::integrate(std::size_t begin,
+                              std::size_t end,
+                              float       dt,
+                              glm::vec2   gravity,
+                              float       drag)
+{
+    std::size_t i = begin;
+#if defined(__AVX__)
+    const __m256 vdt   = _mm256_set1_ps(dt);
+    const __m256 vdrag = _mm256_set1_ps(drag);
+    const __m256 vgx   = _mm256_set1_ps(gravity.x);
+    const __m256 vgy   = _mm256_set1_ps(gravity.y);
+    for (; i < end; i += 8)
+    {
+        __m256 vx = _mm256_load_ps(pvx + i);
+        __m256 vy = _mm256_load_ps(pvy + i);
+        __m256 ax = _mm256_sub_ps(vgx, _mm256_mul_ps(vdrag, vx));
+        __m256 ay = _mm256_sub_ps(vgy, _mm256_mul_ps(vdrag, vy));
+        vx        = _mm256_add_ps(vx, _mm256_mul_ps(ax, vdt));
+        vy        = _mm256_add_ps(vy, _mm256_mul_ps(ay, vdt));
+        __m256 dx = _mm256_mul_ps(vx, vdt);
+        __m256 dy = _mm256_mul_ps(vy, vdt);
+        _mm256_store_ps(pvx + i, vx);
+        _mm256_store_ps(pvy + i, vy);
+        _mm256_store_ps(px + i, _mm256_add_ps(_mm256_load_ps(px + i), dx));
+        _mm256_store_ps(py + i, _mm256_add_ps(_mm256_load_ps(py + i), dy));
+        _mm256_store_ps(page + i, _mm256_add_ps(_mm256_load_ps(page + i), vdt));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128 vdt   = _mm_set1_ps(dt);
+    const __m128 vdrag = _mm_set1_ps(drag);
+    const __m128 vgx   = _mm_set1_ps(gravity.x);
+    const __m128 vgy   = _mm_set1_ps(gravity.y);
+    for (; i < end; i += 4)
+    {
+        __m128 vx = _mm_load_ps(pvx + i);
+        __m128 vy = _mm_load_ps(pvy + i);
+        __m128 ax = _mm_sub_ps(vgx, _mm_mul_ps(vdrag, vx));
+        __m128 ay = _mm_sub_ps(vgy, _mm_mul_ps(vdrag, vy));
+        vx        = _mm_add_ps(vx, _mm_mul_ps(ax, vdt));
+        vy        = _mm_add_ps(vy, _mm_mul_ps(ay, vdt));
+        _mm_store_ps(pvx + i, vx);
+        _mm_store_ps(pvy + i, vy);
+        __m128 dx = _mm_mul_ps(vx, vdt);
+        __m128 dy = _mm_mul_ps(vy, vdt);
+        _mm_store_ps(px + i, _mm_add_ps(_mm_load_ps(px + i), dx));
+        _mm_store_ps(py + i, _mm_add_ps(_mm_load_ps(py + i), dy));
+        _mm_store_ps(page + i, _mm_add_ps(_mm_load_ps(page + i), vdt));
+    }
+#else
+    for (; i < end; ++i)
+    {
+        pvx[i] += (gravity.x - drag * pvx[i]) * dt;
+        pvy[i] += (gravity.y - drag * pvy[i]) * dt;
+        px[i] += pvx[i] * dt;
+        py[i] += pvy[i] * dt;
+        page[i] += dt;
+    }
+#endif
+}
+
+void particle_pool::remove_dead()
+{
+    std::size_t i = 0;
+    while (i < count)
+    {
+#if defined(__AVX__)
+        // skip whole groups where nothing died
+        if (i + 8 <= count &&
+            _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(page + i),
+                                             _mm256_loadu_ps(plife + i),
+                                             _CMP_GE_OQ)) == 0)
+        {
+            i += 8;
+            continue;
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        if (i + 4 <= count &&
+            _mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(page + i),
+                                         _mm_loadu_ps(plife + i))) == 0)
+        {
+            i += 4;
+            continue;
+        }
+#endif
+        if (page[i] >= plife[i])
+        {
+            // the last particle takes the slot and is checked next
+            --count;
+            px[i]    = px[count];
+            py[i]    = py[count];
+            pvx[i]   = pvx[count];
+            pvy[i]   = pvy[count];
+            page[i]  = page[count];
+            plife[i] = plife[count];
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+particle_emitter::particle_emitter(const particle_emitter_desc& desc)
+    : config(desc)
+    , pool(desc.capacity)
+{
+}
+
+float particle_emitter::random01()
+{
+    // xorshift32, no allocation and no shared state between emitters
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return static_cast<float>(rng >> 8) * (1.f / 16777216.f);
+}
+
+void particle_emitter::emit_burst(glm::vec2 at, std::size_t n)
+{
+    const float base = std::atan2(config.direction.y, config.direction.x);
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        const float angle = base + (random01() - 0.5f) * config.spread;
+        const float speed =
+            glm::mix(config.speed_min, config.speed_max, random01());
+        const float life =
+            glm::mix(config.life_min, config.life_max, random01());
+        if (!pool.spawn(
+                at,
+                glm::vec2(std::cos(angle) * speed, std::sin(angle) * speed),
+                life))
+        {
+            return;
+        }
+    }
+}
+
+void particle_emitter::spawn_continuous(float dt)
+{
+    if (config.rate <= 0.f)
+    {
+        return;
+    }
+    spawn_debt += config.rate * dt;
+    const float whole = std::floor(spawn_debt);
+    spawn_debt -= whole;
+    emit_burst(position, static_cast<std::size_t>(whole));
+}
+
+void particle_emitter::update(float dt)
+{
+    pool.update(dt, config.gravity, config.drag);
+    spawn_continuous(dt);
+}
+
+void particle_emitter::update(float dt, job_system& jobs)
+{
+    pool.update(dt, config.gravity, config.drag, jobs);
+    spawn_continuous(dt);
+}
+} // namespace eng
@@ -0,0 +1,108 @@
+#ifndef OPENGL_WINDOW_PARTICLES_HXX
+#define OPENGL_WINDOW_PARTICLES_HXX
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+namespace eng
+{
+class job_system;
+
+// fixed capacity structure of arrays, live particles are packed in
+// [0, size()) and dead ones are swap-removed during update
+class particle_pool
+{
+public:
+    // arrays are padded to this many floats so the SIMD loop has no tail
+    static constexpr std::size_t lanes = 8;
+
+    explicit particle_pool(std::size_t capacity);
+
+    std::size_t size() const { return count; }
+    std::size_t capacity() const { return max_count; }
+
+    // false when the pool is full
+    bool spawn(glm::vec2 position, glm::vec2 velocity, float life);
+    void clear() { count = 0; }
+
+    // integrates velocity and position, ages particles and removes the ones
+    // whose age reached their life
+    void update(float dt, glm::vec2 gravity, float drag);
+    // same, with integration split over the job system
+    void update(float dt, glm::vec2 gravity, float drag, job_system& jobs);
+
+    const float* x() const { return px; }
+    const float* y() const { return py; }
+    const float* age() const { return page; }
+    const float* life() const { return plife; }
+
+private:
+    void integrate(std::size_t begin,
+                   std::size_t end,
+                   float       dt,
+                   glm::vec2   gravity,
+                   float       drag);
+    void remove_dead();
+
+    struct aligned_free
+    {
+        void operator()(float* p) const;
+    };
+
+    std::size_t                            max_count;
+    std::size_t                            count = 0;
+    std::unique_ptr<float[], aligned_free> storage;
+    float*                                 px;
+    float*                                 py;
+    float*                                 pvx;
+    float*                                 pvy;
+    float*                                 page;
+    float*                                 plife;
+};
+
+struct particle_emitter_desc
+{
+    std::size_t capacity     = 4096;
+    int         texture      = 0;   // 0 draws a soft round dot
+    float       rate         = 0.f; // particles per second, 0 for bursts only
+    float       life_min     = 0.5f;
+    float       life_max     = 1.0f;
+    float       speed_min    = 0.1f;
+    float       speed_max    = 0.5f;
+    float       spread       = 3.14159265f; // radians around direction
+    glm::vec2   direction{ 0.f, 1.f };
+    glm::vec2   gravity{ 0.f, 0.f };
+    float       drag       = 0.f;
+    float       size_start = 0.02f; // world units
+    float       size_end   = 0.06f;
+    glm::vec4   color_start{ 1.f, 0.8f, 0.3f, 1.f };
+    glm::vec4   color_end{ 0.3f, 0.3f, 0.3f, 0.f };
+};
+
+class particle_emitter
+{
+public:
+    explicit particle_emitter(const particle_emitter_desc& desc);
+
+    void emit_burst(glm::vec2 at, std::size_t n);
+    // spawns desc.rate particles per second at position and updates them
+    void update(float dt);
+    void update(float dt, job_system& jobs);
+
+    glm::vec2                    position{ 0.f, 0.f };
+    const particle_emitter_desc& desc() const { return config; }
+    const particle_pool&         particles() const { return pool; }
+
+private:
+    void  spawn_continuous(float dt);
+    float random01();
+
+    particle_emitter_desc config;
+    particle_pool         pool;
+    float                 spawn_debt = 0.f;
+    std::uint32_t         rng        = 0x9e3779b9u;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_PARTICLES_HXX
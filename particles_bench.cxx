@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "job_system.hxx"
+#include "particles.hxx"
+
+// updates a full pool every frame and refills what died, so each frame
+// integrates, ages and compacts the whole capacity
+static double run(eng::particle_pool& pool,
+                  int                 frames,
+                  eng::job_system*    jobs,
+                  std::uint32_t       seed)
+{
+    const float dt    = 1.f / 60.f;
+    auto        fill  = [&]
+    {
+        while (pool.size() < pool.capacity())
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            const float r = static_cast<float>(seed >> 8) / 16777216.f;
+            pool.spawn({ r, 1.f - r }, { r - 0.5f, r }, 0.5f + r * 2.f);
+        }
+    };
+    fill();
+    double total_ms = 0.0;
+    for (int f = 0; f < frames; ++f)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        if (jobs)
+        {
+            pool.update(dt, { 0.f, -1.f }, 0.1f, *jobs);
+        }
+        else
+        {
+            pool.update(dt, { 0.f, -1.f }, 0.1f);
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        total_ms +=
+            std::chrono::duration<double, std::milli>(stop - start).count();
+        fill();
+    }
+    return total_ms / frames;
+}
+
+int main(int argc, char** argv)
+{
+    // signed so a negative count is rejected instead of wrapping around
+    const long long particles = argc > 1 ? std::stoll(argv[1]) : 1000000;
+    const int       frames    = argc > 2 ? std::stoi(argv[2]) : 200;
+    if (particles < 1 || frames < 1)
+    {
+        std::cerr << "particles_bench: particles and frames must be at least 1"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::size_t count = static_cast<std::size_t>(particles);
+
+    eng::particle_pool pool(count);
+    const double       single = run(pool, frames, nullptr, 1u);
+
+    eng::job_system jobs;
+    pool.clear();
+    const double parallel = run(pool, frames, &jobs, 1u);
+
+    std::cout << "particles " << count << " frames " << frames << std::endl;
+    std::cout << "single   " << single << " ms/frame" << std::endl;
+    std::cout << "parallel " << parallel << " ms/frame with "
+              << jobs.worker_count() + 1 << " threads" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include "perf_overlay.hxx"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace eng
+{
+void perf_overlay::toggle()
+{
+    shown = !shown;
+    if (shown)
+    {
+        next            = 0;
+        count           = 0;
+        since_refresh   = 0.f;
+        frames_in_slice = 0;
+        length          = 0;
+    }
+}
+
+void perf_overlay::record(float               frame_ms,
+                          const render_stats& stats,
+                          std::int64_t        gpu_bytes,
+                          float               render_scale,
+                          std::uint64_t       ring_overflows)
+{
+    times[next] = frame_ms;
+    next        = (next + 1) % history;
+    count       = std::min(count + 1, history);
+
+    last_stats     = stats;
+    last_gpu_bytes = gpu_bytes;
+    last_scale     = render_scale;
+    last_overflows = ring_overflows;
+    since_refresh += frame_ms;
+    ++frames_in_slice;
+    if (length == 0 || since_refresh >= 250.f)
+    {
+        refresh();
+        since_refresh   = 0.f;
+        frames_in_slice = 0;
+    }
+}
+
+void perf_overlay::refresh()
+{
+    // the lows are the frame times only 1% and 0.1% of the frames exceed
+    std::copy_n(times, count, scratch);
+    std::sort(scratch, scratch + count);
+    auto percentile = [this](float p)
+    {
+        const std::size_t i = static_cast<std::size_t>(p * (count - 1) + 0.5f);
+        return scratch[i];
+    };
+    const float fps = since_refresh > 0.f
+                          ? 1000.f * frames_in_slice / since_refresh
+                          : 0.f;
+    const int written = std::snprintf(
+        lines,
+        sizeof(lines),
+        "FPS %.1f  scale %.0f%%\n"
+        "1%% low %.2f ms  0.1%% low %.2f ms\n"
+        "draws %u +%u indirect  tris %llu\n"
+        "binds %u tex %u prog  GPU mem %.1f MB\n"
+        "sprite ring overflows %llu",
+        fps,
+        last_scale * 100.f,
+        percentile(0.99f),
+        percentile(0.999f),
+        last_stats.draw_calls,
+        last_stats.indirect_draws,
+        static_cast<unsigned long long>(last_stats.triangles),
+        last_stats.texture_binds,
+        last_stats.program_binds,
+        last_gpu_bytes / (1024.0 * 1024.0),
+        static_cast<unsigned long long>(last_overflows));
+    length = std::min<std::size_t>(std::max(written, 0), sizeof(lines) - 1);
+}
+
+std::size_t perf_overlay::graph_size() const
+{
+    return std::min(count, graph_bars);
+}
+
+float perf_overlay::graph_value(std::size_t i) const
+{
+    const std::size_t n = graph_size();
+    return times[(next + history - n + i) % history];
+}
+} // namespace eng
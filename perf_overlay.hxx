@@ -0,0 +1,56 @@
+#ifndef OPENGL_WINDOW_PERF_OVERLAY_HXX
+#define OPENGL_WINDOW_PERF_OVERLAY_HXX
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "render_stats.hxx"
+
+namespace eng
+{
+// numbers behind the engine's performance overlay. It is only fed while
+// shown, hidden it costs the engine one branch per frame
+class perf_overlay
+{
+public:
+    static constexpr std::size_t history    = 1000; // frames behind the lows
+    static constexpr std::size_t graph_bars = 120;
+
+    bool visible() const { return shown; }
+    // showing starts a fresh history
+    void toggle();
+
+    // once per presented frame, frame_ms is the time since the previous one
+    // and ring_overflows counts the sprite ring regions that ran full so far
+    void record(float               frame_ms,
+                const render_stats& stats,
+                std::int64_t        gpu_bytes,
+                float               render_scale,
+                std::uint64_t       ring_overflows);
+
+    // refreshed four times a second so the text layout cache mostly hits
+    std::string_view text() const { return std::string_view(lines, length); }
+    // frame times in ms of the last graph_size() frames, oldest first
+    std::size_t graph_size() const;
+    float       graph_value(std::size_t i) const;
+
+private:
+    void refresh();
+
+    bool        shown = false;
+    float       times[history];
+    float       scratch[history];
+    std::size_t next  = 0;
+    std::size_t count = 0;
+
+    render_stats  last_stats;
+    std::int64_t  last_gpu_bytes  = 0;
+    float         last_scale      = 1.f;
+    std::uint64_t last_overflows  = 0;
+    float         since_refresh   = 0.f;
+    std::size_t   frames_in_slice = 0;
+    char          lines[256]      = {};
+    std::size_t   length          = 0;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_PERF_OVERLAY_HXX
@@ -0,0 +1,164 @@
+#include "png.hxx"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <vector>
+
+namespace eng
+{
+static const std::array<std::uint32_t, 256>& crc_table()
+{
+    static const std::array<std::uint32_t, 256> table = []
+    {
+        std::array<std::uint32_t, 256> t{};
+        for (std::uint32_t n = 0; n < 256; ++n)
+        {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+            {
+                c = (c & 1u) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+namespace
+{
+// writes chunks and keeps the running CRC of the current one
+class png_stream
+{
+public:
+    explicit png_stream(const std::string& path)
+        : file(path, std::ios::binary)
+    {
+    }
+
+    bool good() const { return static_cast<bool>(file); }
+
+    void begin_chunk(const char* type, std::uint32_t length)
+    {
+        put_u32(length);
+        crc = 0xffffffffu;
+        write(reinterpret_cast<const std::uint8_t*>(type), 4);
+    }
+    void end_chunk() { put_u32(crc ^ 0xffffffffu); }
+
+    void write(const std::uint8_t* data, std::size_t size)
+    {
+        const auto& table = crc_table();
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            crc = table[(crc ^ data[i]) & 0xffu] ^ (crc >> 8);
+        }
+        file.write(reinterpret_cast<const char*>(data),
+                   static_cast<std::streamsize>(size));
+    }
+    void put_u8(std::uint8_t v) { write(&v, 1); }
+    void put_u32(std::uint32_t v)
+    {
+        const std::uint8_t b[4] = { static_cast<std::uint8_t>(v >> 24),
+                                    static_cast<std::uint8_t>(v >> 16),
+                                    static_cast<std::uint8_t>(v >> 8),
+                                    static_cast<std::uint8_t>(v) };
+        write(b, 4);
+    }
+
+private:
+    std::ofstream file;
+    std::uint32_t crc = 0;
+};
+} // namespace
+
+bool write_png(const std::string&  path,
+               int                 width,
+               int                 height,
+               const std::uint8_t* first_row,
+               std::ptrdiff_t      stride)
+{
+    if (width <= 0 || height <= 0 || !first_row)
+    {
+        return false;
+    }
+    png_stream out(path);
+    if (!out.good())
+    {
+        return false;
+    }
+    static const std::uint8_t signature[8] = { 0x89, 'P',  'N',  'G',
+                                               '\r', '\n', 0x1a, '\n' };
+    out.write(signature, sizeof(signature));
+
+    out.begin_chunk("IHDR", 13);
+    out.put_u32(static_cast<std::uint32_t>(width));
+    out.put_u32(static_cast<std::uint32_t>(height));
+    out.put_u8(8); // bits per channel
+    out.put_u8(6); // RGBA
+    out.put_u8(0); // deflate
+    out.put_u8(0); // adaptive filtering, every row uses filter 0
+    out.put_u8(0); // not interlaced
+    out.end_chunk();
+
+    // zlib stream of stored blocks over the filtered rows
+    const std::size_t row_bytes = static_cast<std::size_t>(width) * 4 + 1;
+    const std::size_t raw_bytes = row_bytes * height;
+    constexpr std::size_t max_block = 65535;
+    const std::size_t blocks = (raw_bytes + max_block - 1) / max_block;
+    const std::size_t zlib_bytes = 2 + raw_bytes + blocks * 5 + 4;
+    if (zlib_bytes > 0x7fffffffu)
+    {
+        return false;
+    }
+    out.begin_chunk("IDAT", static_cast<std::uint32_t>(zlib_bytes));
+    out.put_u8(0x78); // deflate, 32k window
+    out.put_u8(0x01); // no preset dictionary, check bits
+
+    std::vector<std::uint8_t> row(row_bytes);
+    std::uint32_t             adler_a = 1;
+    std::uint32_t             adler_b = 0;
+    std::size_t               left_in_block = 0;
+    std::size_t               remaining     = raw_bytes;
+    for (int y = 0; y < height; ++y)
+    {
+        row[0] = 0;
+        std::copy_n(first_row + y * stride, row_bytes - 1, row.begin() + 1);
+        for (const std::uint8_t v : row)
+        {
+            adler_a = (adler_a + v) % 65521u;
+            adler_b = (adler_b + adler_a) % 65521u;
+        }
+        // the row may straddle stored block boundaries
+        std::size_t done = 0;
+        while (done < row_bytes)
+        {
+            if (left_in_block == 0)
+            {
+                left_in_block = std::min(remaining, max_block);
+                const auto len = static_cast<std::uint16_t>(left_in_block);
+                const std::uint8_t header[5] = {
+                    static_cast<std::uint8_t>(remaining <= max_block ? 1 : 0),
+                    static_cast<std::uint8_t>(len),
+                    static_cast<std::uint8_t>(len >> 8),
+                    static_cast<std::uint8_t>(~len),
+                    static_cast<std::uint8_t>(~len >> 8)
+                };
+                out.write(header, sizeof(header));
+            }
+            const std::size_t n = std::min(left_in_block, row_bytes - done);
+            out.write(row.data() + done, n);
+            done += n;
+            left_in_block -= n;
+            remaining -= n;
+        }
+    }
+    out.put_u32((adler_b << 16) | adler_a);
+    out.end_chunk();
+
+    out.begin_chunk("IEND", 0);
+    out.end_chunk();
+    return out.good();
+}
+} // namespace eng
@@ -0,0 +1,20 @@
+#ifndef OPENGL_WINDOW_PNG_HXX
+#define OPENGL_WINDOW_PNG_HXX
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace eng
+{
+// writes 8 bit RGBA pixels as a PNG. The deflate stream uses stored blocks:
+// files are as large as the pixels but writing one costs little more than
+// the copy, which is what screenshots and test output need. stride is the
+// byte distance between rows and may be negative, so bottom up rows from
+// glReadPixels are written without a flipped copy
+bool write_png(const std::string&  path,
+               int                 width,
+               int                 height,
+               const std::uint8_t* first_row,
+               std::ptrdiff_t      stride);
+} // namespace eng
+#endif // OPENGL_WINDOW_PNG_HXX
@@ -0,0 +1,144 @@
+#include "projectiles.hxx"
+
+#include <algorithm>
+#include <cmath>
+
+#include "job_system.hxx"
+#include "sprite_renderer.hxx"
+#include "unit_grid.hxx"
+
+namespace eng
+{
+projectile_pool::projectile_pool(std::size_t capacity)
+    : capacity_(capacity)
+    , free_count(capacity)
+    , px(new float[capacity])
+    , py(new float[capacity])
+    , vx(new float[capacity])
+    , vy(new float[capacity])
+    , life(new float[capacity])
+    , owner(new std::uint32_t[capacity])
+    , alive(new std::uint8_t[capacity]())
+    , free_slots(new std::uint32_t[capacity])
+    , hit_list(new projectile_hit[capacity])
+    , dead(new std::uint32_t[capacity])
+{
+    // slot 0 on top
+    for (std::size_t i = 0; i < capacity; ++i)
+    {
+        free_slots[i] = static_cast<std::uint32_t>(capacity - 1 - i);
+    }
+}
+
+bool projectile_pool::fire(glm::vec2     position,
+                           glm::vec2     velocity,
+                           float         seconds,
+                           std::uint32_t owner_unit)
+{
+    if (free_count == 0)
+    {
+        return false;
+    }
+    const std::uint32_t i = free_slots[--free_count];
+    px[i]                 = position.x;
+    py[i]                 = position.y;
+    vx[i]                 = velocity.x;
+    vy[i]                 = velocity.y;
+    life[i]               = seconds;
+    owner[i]              = owner_unit;
+    alive[i]              = 1;
+    high_water            = std::max<std::size_t>(high_water, i + 1);
+    return true;
+}
+
+void projectile_pool::update(float dt, const unit_grid& grid)
+{
+    hits_used.store(0, std::memory_order_relaxed);
+    dead_used.store(0, std::memory_order_relaxed);
+    update_range(0, high_water, dt, grid);
+    release_dead();
+}
+
+void projectile_pool::update(float dt, const unit_grid& grid, job_system& jobs)
+{
+    hits_used.store(0, std::memory_order_relaxed);
+    dead_used.store(0, std::memory_order_relaxed);
+    // a grid walk per shell, smaller chunks than the plain integrators
+    constexpr std::size_t grain = 2048;
+    jobs.parallel_for(0,
+                      high_water,
+                      grain,
+                      [&](std::size_t begin, std::size_t end)
+                      { update_range(begin, end, dt, grid); });
+    release_dead();
+}
+
+// the segment from the old to the new position is what the shell swept
+// this update, testing only the end point would let a fast shell jump over
+// a unit thinner than its step
+void projectile_pool::update_range(std::size_t      begin,
+                                   std::size_t      end,
+                                   float            dt,
+                                   const unit_grid& grid)
+{
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        if (!alive[i])
+        {
+            continue;
+        }
+        const glm::vec2   from(px[i], py[i]);
+        const glm::vec2   to   = from + glm::vec2(vx[i], vy[i]) * dt;
+        float             t    = 0.f;
+        const std::size_t unit = grid.raycast(from, to, owner[i], t);
+        if (unit != unit_grid::npos)
+        {
+            hit_list[hits_used.fetch_add(1, std::memory_order_relaxed)] = {
+                static_cast<std::uint32_t>(unit), owner[i],
+                from + (to - from) * t
+            };
+        }
+        life[i] -= dt;
+        if (unit != unit_grid::npos || life[i] <= 0.f)
+        {
+            alive[i] = 0;
+            dead[dead_used.fetch_add(1, std::memory_order_relaxed)] =
+                static_cast<std::uint32_t>(i);
+            continue;
+        }
+        px[i] = to.x;
+        py[i] = to.y;
+    }
+}
+
+void projectile_pool::release_dead()
+{
+    const std::size_t n = dead_used.load(std::memory_order_relaxed);
+    for (std::size_t d = 0; d < n; ++d)
+    {
+        free_slots[free_count++] = dead[d];
+    }
+    while (high_water > 0 && !alive[high_water - 1])
+    {
+        --high_water;
+    }
+}
+
+std::size_t projectile_pool::write_instances(sprite_instance* out,
+                                             std::size_t      max,
+                                             glm::vec2        size) const
+{
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < high_water && n < max; ++i)
+    {
+        if (alive[i])
+        {
+            place_sprite(out[n++],
+                         glm::vec2(px[i], py[i]),
+                         size,
+                         std::atan2(vy[i], vx[i]));
+        }
+    }
+    return n;
+}
+} // namespace eng
@@ -0,0 +1,85 @@
+#ifndef OPENGL_WINDOW_PROJECTILES_HXX
+#define OPENGL_WINDOW_PROJECTILES_HXX
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+namespace eng
+{
+class job_system;
+class unit_grid;
+struct sprite_instance;
+
+// a shell that reached a unit box during the last update
+struct projectile_hit
+{
+    std::uint32_t unit;  // index into the arrays the grid was built from
+    std::uint32_t owner; // as passed to fire
+    glm::vec2     point; // where the shell entered the box
+};
+
+// shells in fixed slots with a free list: firing takes the slot freed last
+// and nothing is allocated after construction. Slots stay put while a
+// shell flies, updates walk the arrays up to the highest slot in use
+class projectile_pool
+{
+public:
+    explicit projectile_pool(std::size_t capacity);
+
+    std::size_t size() const { return capacity_ - free_count; }
+    std::size_t capacity() const { return capacity_; }
+
+    // life in seconds, owner is the unit the shell can't hit. False when
+    // every slot is in use
+    bool fire(glm::vec2     position,
+              glm::vec2     velocity,
+              float         life,
+              std::uint32_t owner);
+
+    // moves every shell by dt. The path a shell covers is swept against the
+    // grid's unit boxes, so it stops at the first box in the way however
+    // far it moved, and dies there. Shells also die when their life runs out
+    void update(float dt, const unit_grid& grid);
+    // same, split over the job system
+    void update(float dt, const unit_grid& grid, job_system& jobs);
+
+    // hits of the last update, in no particular order
+    const projectile_hit* hits() const { return hit_list.get(); }
+    std::size_t           hit_count() const { return hits_used; }
+
+    // the live shells as sprites pointing along their flight, up to max of
+    // them, returns how many were written. uv is left alone
+    std::size_t write_instances(sprite_instance* out,
+                                std::size_t      max,
+                                glm::vec2        size) const;
+
+private:
+    void update_range(std::size_t      begin,
+                      std::size_t      end,
+                      float            dt,
+                      const unit_grid& grid);
+    void release_dead();
+
+    std::size_t                       capacity_;
+    std::size_t                       high_water = 0;
+    std::size_t                       free_count;
+    std::unique_ptr<float[]>          px;
+    std::unique_ptr<float[]>          py;
+    std::unique_ptr<float[]>          vx;
+    std::unique_ptr<float[]>          vy;
+    std::unique_ptr<float[]>          life;
+    std::unique_ptr<std::uint32_t[]>  owner;
+    std::unique_ptr<std::uint8_t[]>   alive;
+    std::unique_ptr<std::uint32_t[]>  free_slots; // stack, top is reused next
+    // filled by concurrent update ranges, each entry claimed with one
+    // fetch_add, then the dead slots go back onto the free list
+    std::unique_ptr<projectile_hit[]> hit_list;
+    std::unique_ptr<std::uint32_t[]>  dead;
+    std::atomic<std::size_t>          hits_used{ 0 };
+    std::atomic<std::size_t>          dead_used{ 0 };
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_PROJECTILES_HXX
@@ -0,0 +1,152 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "job_system.hxx"
+#include "kinematics.hxx"
+#include "projectiles.hxx"
+#include "sprite_renderer.hxx"
+#include "unit_grid.hxx"
+
+// keeps a full pool of fast shells in flight over a field of moving units:
+// every frame the units take a tick, the grid is rebuilt from them, the
+// shells are swept against it and refilled to the pool size, and the
+// survivors are written as sprites. Reported as shells per millisecond
+namespace
+{
+using clock = std::chrono::steady_clock;
+
+struct result
+{
+    double grid_ms   = 0.0; // per frame
+    double update_ms = 0.0;
+    double emit_ms   = 0.0;
+    double hits      = 0.0;
+};
+
+double since(clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(clock::now() - start)
+        .count();
+}
+
+result run(std::size_t      shells,
+           std::size_t      unit_count,
+           int              frames,
+           eng::job_system* jobs)
+{
+    const float          half_map = 50.f;
+    eng::kinematics_desc desc;
+    desc.max_speed  = 2.f;
+    desc.bounds_min = glm::vec2(-half_map);
+    desc.bounds_max = glm::vec2(half_map);
+    desc.radius     = 0.1f;
+    eng::unit_kinematics units(desc, unit_count);
+    eng::unit_grid       grid(desc.bounds_min, desc.bounds_max, 1.f);
+    eng::projectile_pool pool(shells);
+
+    std::uint32_t seed   = 1u;
+    auto          random = [&]
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return static_cast<float>(seed >> 8) / 16777216.f;
+    };
+    auto anywhere = [&]
+    {
+        return glm::vec2(random() * 2.f - 1.f, random() * 2.f - 1.f) *
+               half_map;
+    };
+    for (std::size_t i = 0; i < unit_count; ++i)
+    {
+        const std::size_t u = units.add(anywhere(), random() * 6.f);
+        units.drive(u, 1.f + random() * 3.f, random() * 2.f - 1.f);
+    }
+
+    // two cells a tick, a shell tested only where it lands would skip
+    // most of the units on its way
+    const float speed  = 120.f;
+    auto        refill = [&]
+    {
+        while (pool.size() < shells)
+        {
+            const float angle = random() * 6.2831853f;
+            pool.fire(anywhere(),
+                      glm::vec2(std::cos(angle), std::sin(angle)) * speed,
+                      0.5f + random(),
+                      static_cast<std::uint32_t>(-1));
+        }
+    };
+    refill();
+
+    std::vector<eng::sprite_instance> sprites(shells);
+    result                            r;
+    for (int f = 0; f < frames; ++f)
+    {
+        units.step(desc.tick);
+
+        const clock::time_point start = clock::now();
+        grid.build(units.x(), units.y(), units.size(), desc.radius);
+        r.grid_ms += since(start);
+
+        const clock::time_point update = clock::now();
+        if (jobs)
+        {
+            pool.update(desc.tick, grid, *jobs);
+        }
+        else
+        {
+            pool.update(desc.tick, grid);
+        }
+        r.update_ms += since(update);
+        r.hits += static_cast<double>(pool.hit_count());
+
+        const clock::time_point emit = clock::now();
+        pool.write_instances(sprites.data(), shells, glm::vec2(0.2f, 0.05f));
+        r.emit_ms += since(emit);
+        refill();
+    }
+    r.grid_ms /= frames;
+    r.update_ms /= frames;
+    r.emit_ms /= frames;
+    r.hits /= frames;
+    return r;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    // signed so a negative count is rejected instead of wrapping around
+    const long long shell_count = argc > 1 ? std::stoll(argv[1]) : 50000;
+    const long long unit_count  = argc > 2 ? std::stoll(argv[2]) : 10000;
+    const int       frames      = argc > 3 ? std::stoi(argv[3]) : 300;
+    if (shell_count < 1 || unit_count < 1 || frames < 1)
+    {
+        std::cerr
+            << "projectiles_bench: shells, units and frames must be at least 1"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::size_t shells = static_cast<std::size_t>(shell_count);
+    const std::size_t units  = static_cast<std::size_t>(unit_count);
+
+    const result    single = run(shells, units, frames, nullptr);
+    eng::job_system jobs;
+    const result    parallel = run(shells, units, frames, &jobs);
+
+    std::cout << "shells " << shells << " units " << units << " frames "
+              << frames << std::endl;
+    std::cout << "grid     " << single.grid_ms << " ms per rebuild, "
+              << single.hits << " hits per frame" << std::endl;
+    std::cout << "single   " << shells / single.update_ms
+              << " shells/ms swept, " << shells / single.emit_ms
+              << " sprites/ms emitted" << std::endl;
+    std::cout << "parallel " << shells / parallel.update_ms
+              << " shells/ms swept with " << jobs.worker_count() + 1
+              << " threads" << std::endl;
+    return EXIT_SUCCESS;
+}
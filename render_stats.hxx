@@ -0,0 +1,54 @@
+#ifndef OPENGL_WINDOW_RENDER_STATS_HXX
+#define OPENGL_WINDOW_RENDER_STATS_HXX
+#include <cstdint>
+
+namespace eng
+{
+// counters of the frame being recorded, bumped next to every draw call,
+// texture bind and program switch and reset by engine::swap_buff. GL
+// thread only
+struct render_stats
+{
+    std::uint32_t draw_calls     = 0;
+    std::uint32_t indirect_draws = 0; // their size never reaches the CPU
+    std::uint64_t triangles      = 0;
+    std::uint32_t texture_binds  = 0;
+    std::uint32_t program_binds  = 0;
+};
+
+inline render_stats& frame_render_stats()
+{
+    static render_stats stats;
+    return stats;
+}
+
+inline void count_draw(std::uint64_t triangles)
+{
+    ++frame_render_stats().draw_calls;
+    frame_render_stats().triangles += triangles;
+}
+
+inline void count_indirect_draw()
+{
+    ++frame_render_stats().indirect_draws;
+}
+
+inline void count_texture_bind()
+{
+    ++frame_render_stats().texture_binds;
+}
+
+inline void count_program_bind()
+{
+    ++frame_render_stats().program_binds;
+}
+
+// bytes of texture and buffer storage the engine has created and not yet
+// deleted, GLES has no query for what the driver actually uses
+inline std::int64_t& gpu_memory_bytes()
+{
+    static std::int64_t bytes = 0;
+    return bytes;
+}
+} // namespace eng
+#endif // OPENGL_WINDOW_RENDER_STATS_HXX
@@ -0,0 +1,167 @@
+#include "render_target.hxx"
+
+#include <algorithm>
+#include <iostream>
+
+#include "gl_check.hxx"
+#include "render_stats.hxx"
+
+namespace eng
+{
+// bytes per texel of the colour formats a target is likely to use, 4 for
+// anything else
+static std::int64_t texel_bytes(GLenum format)
+{
+    switch (format)
+    {
+        case GL_R8:
+            return 1;
+        case GL_RG8:
+        case GL_R16F:
+            return 2;
+        case GL_RGBA16F:
+            return 8;
+        case GL_RGBA32F:
+            return 16;
+    }
+    return 4;
+}
+
+static std::int64_t target_bytes(const render_target_desc& d)
+{
+    return static_cast<std::int64_t>(d.size.x) * d.size.y *
+           (texel_bytes(d.color_format) + (d.depth ? 4 : 0));
+}
+
+render_target::render_target(const render_target_desc& desc)
+    : description(desc)
+{
+    glGenFramebuffers(1, &fbo);
+    OM_GL_CHECK(glGenFramebuffers)
+    create_attachments();
+}
+
+render_target::~render_target()
+{
+    delete_attachments();
+    glDeleteFramebuffers(1, &fbo);
+}
+
+void render_target::resize(glm::ivec2 size)
+{
+    if (size == description.size)
+    {
+        return;
+    }
+    delete_attachments();
+    description.size = size;
+    create_attachments();
+}
+
+void render_target::create_attachments()
+{
+    const glm::ivec2 s = glm::max(description.size, glm::ivec2(1, 1));
+
+    // immutable storage, a resize makes a new texture
+    glGenTextures(1, &color);
+    glBindTexture(GL_TEXTURE_2D, color);
+    glTexStorage2D(GL_TEXTURE_2D, 1, description.color_format, s.x, s.y);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, description.filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, description.filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    OM_GL_CHECK(glTexParameteri)
+
+    // targets are made and resized mid frame, whatever the frame draws to or
+    // reads from stays bound, the headless window is a framebuffer too
+    GLint drawing = 0;
+    GLint reading = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawing);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &reading);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(
+        GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    if (description.depth)
+    {
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(
+            GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, s.x, s.y);
+        glFramebufferRenderbuffer(
+            GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    }
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "render target " << s.x << "x" << s.y
+                  << " is incomplete: 0x" << std::hex << status << std::dec
+                  << std::endl;
+    }
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(drawing));
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(reading));
+    OM_GL_CHECK(glBindFramebuffer)
+    gpu_memory_bytes() += target_bytes(description);
+}
+
+void render_target::delete_attachments()
+{
+    glDeleteTextures(1, &color);
+    color = 0;
+    if (depth != 0)
+    {
+        glDeleteRenderbuffers(1, &depth);
+        depth = 0;
+    }
+    gpu_memory_bytes() -= target_bytes(description);
+}
+
+render_target& render_target_pool::acquire(const render_target_desc& desc)
+{
+    for (slot& s : slots)
+    {
+        if (!s.in_use && s.target->desc() == desc)
+        {
+            s.in_use    = true;
+            s.last_used = frame;
+            ++counters.reused;
+            return *s.target;
+        }
+    }
+    slots.push_back({ std::make_unique<render_target>(desc), true, frame });
+    ++counters.created;
+    return *slots.back().target;
+}
+
+void render_target_pool::release(const render_target& target)
+{
+    for (slot& s : slots)
+    {
+        if (s.target.get() == &target)
+        {
+            s.in_use = false;
+            return;
+        }
+    }
+}
+
+void render_target_pool::end_frame()
+{
+    ++frame;
+    for (slot& s : slots)
+    {
+        s.in_use = false;
+    }
+    // sizes that went out of use, e.g. after a window or scale change
+    auto idle = [this](const slot& s)
+    { return frame - s.last_used > max_idle_frames; };
+    slots.erase(std::remove_if(slots.begin(), slots.end(), idle), slots.end());
+}
+
+render_target_pool::usage render_target_pool::stats() const
+{
+    usage u = counters;
+    u.live  = slots.size();
+    return u;
+}
+} // namespace eng
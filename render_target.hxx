@@ -0,0 +1,94 @@
+#ifndef OPENGL_WINDOW_RENDER_TARGET_HXX
+#define OPENGL_WINDOW_RENDER_TARGET_HXX
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glad/glad.h"
+
+#include <glm/glm.hpp>
+
+namespace eng
+{
+struct render_target_desc
+{
+    glm::ivec2 size{ 0, 0 };
+    GLenum     color_format = GL_RGBA8; // sized internal format
+    bool       depth        = false;    // 24 bit depth renderbuffer
+    GLenum     filter       = GL_LINEAR; // when sampled as a texture
+
+    bool operator==(const render_target_desc& o) const
+    {
+        return size == o.size && color_format == o.color_format &&
+               depth == o.depth && filter == o.filter;
+    }
+};
+
+// framebuffer with a colour texture and an optional depth renderbuffer.
+// Draw into it through engine::set_render_target, sample color_texture()
+// afterwards
+class render_target
+{
+public:
+    explicit render_target(const render_target_desc& desc);
+    ~render_target();
+
+    render_target(const render_target&)            = delete;
+    render_target& operator=(const render_target&) = delete;
+
+    // reallocates the attachments, the framebuffer name stays the same
+    void resize(glm::ivec2 size);
+
+    GLuint                    framebuffer() const { return fbo; }
+    GLuint                    color_texture() const { return color; }
+    glm::ivec2                size() const { return description.size; }
+    const render_target_desc& desc() const { return description; }
+
+private:
+    void create_attachments();
+    void delete_attachments();
+
+    render_target_desc description;
+    GLuint             fbo   = 0;
+    GLuint             color = 0;
+    GLuint             depth = 0;
+};
+
+// recycles transient targets: acquire hands out an idle target with the
+// same description or creates one, every target acquired during a frame
+// is returned by end_frame. Targets idle for max_idle_frames are deleted,
+// so a steady frame creates no framebuffers at all
+class render_target_pool
+{
+public:
+    static constexpr std::uint64_t max_idle_frames = 60;
+
+    struct usage
+    {
+        std::uint64_t created = 0;
+        std::uint64_t reused  = 0;
+        std::size_t   live    = 0;
+    };
+
+    // valid until end_frame
+    render_target& acquire(const render_target_desc& desc);
+    // returns a target before the end of the frame
+    void release(const render_target& target);
+    void end_frame();
+
+    usage stats() const;
+
+private:
+    struct slot
+    {
+        std::unique_ptr<render_target> target;
+        bool                           in_use    = false;
+        std::uint64_t                  last_used = 0;
+    };
+
+    std::vector<slot> slots;
+    std::uint64_t     frame = 0;
+    usage             counters;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_RENDER_TARGET_HXX
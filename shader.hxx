@@ -0,0 +1,219 @@
+#ifndef OPENGL_WINDOW_SHADER_HXX
+#define OPENGL_WINDOW_SHADER_HXX
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "glad/glad.h"
+
+#include <glm/glm.hpp>
+
+#include "render_stats.hxx"
+
+namespace eng
+{
+struct Shader
+{
+    GLuint ID;
+
+    // defines are inserted after the #version line of both stages, one
+    // "#define NAME" per line, to build variants of the same source
+    Shader(std::string vertexPath,
+           std::string fragmentPath,
+           std::string defines = "")
+    {
+        std::string   vertexCode;
+        std::string   fragmentCode;
+        std::ifstream vShaderFile;
+        std::ifstream fShaderFile;
+        // ensure ifstream objects can throw exceptions:
+        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            // open files
+            vShaderFile.open(vertexPath.c_str());
+            fShaderFile.open(fragmentPath.c_str());
+            std::stringstream vShaderStream, fShaderStream;
+            // read file’s buffer contents into streams
+            vShaderStream << vShaderFile.rdbuf();
+            fShaderStream << fShaderFile.rdbuf();
+            // close file handlers
+            vShaderFile.close();
+            fShaderFile.close();
+            // convert stream into string
+            vertexCode   = add_defines(vShaderStream.str(), defines);
+            fragmentCode = add_defines(fShaderStream.str(), defines);
+        }
+        catch (std::ifstream::failure e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ"
+                      << std::endl;
+        }
+        const char*  vShaderCode = vertexCode.c_str();
+        const char*  fShaderCode = fragmentCode.c_str();
+        unsigned int vertex, fragment;
+        int          success;
+        char         infoLog[512];
+        vertex = glCreateShader(GL_VERTEX_SHADER);
+
+        glShaderSource(vertex, 1, &vShaderCode, NULL);
+        glCompileShader(vertex);
+
+        glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+
+        if (!success)
+        {
+            glGetShaderInfoLog(vertex, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
+                      << infoLog << std::endl;
+        };
+
+        fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fShaderCode, NULL);
+        glCompileShader(fragment);
+        glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(vertex, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
+                      << infoLog << std::endl;
+        };
+        ID = glCreateProgram();
+        glAttachShader(ID, vertex);
+        glAttachShader(ID, fragment);
+        glLinkProgram(ID);
+        glGetProgramiv(ID, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(ID, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
+                      << infoLog << std::endl;
+        }
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+    }
+    void use() const
+    {
+        glUseProgram(ID);
+        count_program_bind();
+    }
+
+    static std::string add_defines(const std::string& code,
+                                   const std::string& defines)
+    {
+        if (defines.empty())
+        {
+            return code;
+        }
+        // #version has to stay the first line
+        std::size_t line_end = code.find('\n');
+        if (line_end == std::string::npos)
+        {
+            line_end = code.size();
+        }
+        return code.substr(0, line_end) + "\n" + defines +
+               code.substr(line_end);
+    }
+
+    void setInt(const std::string& name, int value) const
+    {
+        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    }
+    // ------------------------------------------------------------------------
+    void setFloat(const std::string& name, float value) const
+    {
+        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    }
+    void setMat3(const std::string& name, const glm::mat3& mat) const
+    {
+        glUniformMatrix3fv(
+            glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    }
+    // ------------------------------------------------------------------------
+    void setMat4(const std::string& name, const glm::mat4& mat) const
+    {
+        glUniformMatrix4fv(
+            glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    }
+    void setVec3(const std::string& name, float x, float y, float z) const
+    {
+        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    }
+    void setVec4(
+        const std::string& name, float x, float y, float z, float w) const
+    {
+        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+    }
+};
+
+// single compute stage program, needs a GLES 3.1 context
+struct ComputeShader
+{
+    GLuint ID;
+
+    ComputeShader(std::string computePath, std::string defines = "")
+    {
+        std::string   computeCode;
+        std::ifstream cShaderFile;
+        cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            cShaderFile.open(computePath.c_str());
+            std::stringstream cShaderStream;
+            cShaderStream << cShaderFile.rdbuf();
+            cShaderFile.close();
+            computeCode = Shader::add_defines(cShaderStream.str(), defines);
+        }
+        catch (std::ifstream::failure e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ"
+                      << std::endl;
+        }
+        const char* cShaderCode = computeCode.c_str();
+        int         success;
+        char        infoLog[512];
+        GLuint      compute = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute, 1, &cShaderCode, NULL);
+        glCompileShader(compute);
+        glGetShaderiv(compute, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(compute, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n"
+                      << infoLog << std::endl;
+        }
+        ID = glCreateProgram();
+        glAttachShader(ID, compute);
+        glLinkProgram(ID);
+        glGetProgramiv(ID, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(ID, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
+                      << infoLog << std::endl;
+        }
+        glDeleteShader(compute);
+    }
+    void use() const
+    {
+        glUseProgram(ID);
+        count_program_bind();
+    }
+
+    void setUint(const std::string& name, GLuint value) const
+    {
+        glUniform1ui(glGetUniformLocation(ID, name.c_str()), value);
+    }
+    void setFloat(const std::string& name, float value) const
+    {
+        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    }
+    void setVec2(const std::string& name, float x, float y) const
+    {
+        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+    }
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_SHADER_HXX
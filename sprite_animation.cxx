@@ -0,0 +1,187 @@
+#include "sprite_animation.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "job_system.hxx"
+#include "sprite_renderer.hxx"
+
+namespace eng
+{
+std::uint32_t flipbook_library::add_frame(atlas_rect frame)
+{
+    frame_rects.push_back(frame);
+    return static_cast<std::uint32_t>(frame_rects.size() - 1);
+}
+
+std::uint32_t flipbook_library::add_grid_frames(int columns,
+                                                int rows,
+                                                int first,
+                                                int count)
+{
+    const auto  index  = static_cast<std::uint32_t>(frame_rects.size());
+    const float cell_u = 1.f / static_cast<float>(columns);
+    const float cell_v = 1.f / static_cast<float>(rows);
+    for (int cell = first; cell < first + count; ++cell)
+    {
+        // the top atlas row sits at v = 1, as in tilemap
+        atlas_rect r;
+        r.u0 = static_cast<float>(cell % columns) * cell_u;
+        r.u1 = r.u0 + cell_u;
+        r.v1 = 1.f - static_cast<float>(cell / columns) * cell_v;
+        r.v0 = r.v1 - cell_v;
+        frame_rects.push_back(r);
+    }
+    return index;
+}
+
+std::uint16_t flipbook_library::add_clip(const flipbook_clip& clip)
+{
+    if (clip.frame_count == 0 || clips.size() >= invalid_clip)
+    {
+        return invalid_clip;
+    }
+    clips.push_back(clip);
+    return static_cast<std::uint16_t>(clips.size() - 1);
+}
+
+sprite_animator::sprite_animator(const flipbook_library& library,
+                                 std::size_t             capacity)
+    : library(library)
+    , max_count(capacity)
+    , clip(std::make_unique<std::uint16_t[]>(capacity))
+    , time(std::make_unique<float[]>(capacity))
+    , speed(std::make_unique<float[]>(capacity))
+    , frame(std::make_unique<std::uint32_t[]>(capacity))
+{
+    refresh_timing();
+}
+
+void sprite_animator::refresh_timing()
+{
+    for (std::size_t i = timing.size(); i < library.clip_count(); ++i)
+    {
+        const flipbook_clip& c = library.clip(static_cast<std::uint16_t>(i));
+        clip_timing          t;
+        t.fps         = std::max(c.fps, 0.f);
+        // a clip without a rate holds its first frame
+        t.duration    = t.fps > 0.f ? static_cast<float>(c.frame_count) / t.fps
+                                    : std::numeric_limits<float>::infinity();
+        t.first_frame = c.first_frame;
+        t.last        = c.frame_count - 1;
+        t.loop        = c.loop;
+        timing.push_back(t);
+    }
+}
+
+std::size_t sprite_animator::add(std::uint16_t c, float start_time)
+{
+    refresh_timing();
+    if (count == max_count || c >= timing.size())
+    {
+        return npos;
+    }
+    const std::size_t i = count++;
+    clip[i]             = c;
+    time[i]             = 0.f;
+    speed[i]            = 1.f;
+    advance_range(i, i + 1, start_time);
+    return i;
+}
+
+std::size_t sprite_animator::remove(std::size_t index)
+{
+    --count;
+    if (index == count)
+    {
+        return npos;
+    }
+    clip[index]  = clip[count];
+    time[index]  = time[count];
+    speed[index] = speed[count];
+    frame[index] = frame[count];
+    return count;
+}
+
+void sprite_animator::play(std::size_t index, std::uint16_t c, bool restart)
+{
+    refresh_timing();
+    if ((clip[index] == c && !restart) || c >= timing.size())
+    {
+        return;
+    }
+    clip[index] = c;
+    time[index] = 0.f;
+    advance_range(index, index + 1, 0.f);
+}
+
+void sprite_animator::set_speed(std::size_t index, float s)
+{
+    speed[index] = s;
+}
+
+void sprite_animator::advance(float dt)
+{
+    refresh_timing();
+    advance_range(0, count, dt);
+}
+
+void sprite_animator::advance(float dt, job_system& jobs)
+{
+    refresh_timing();
+    // the loop is a few loads and a multiply per sprite, chunks have to be
+    // large to be worth a job
+    constexpr std::size_t grain = 16384;
+    jobs.parallel_for(0,
+                      count,
+                      grain,
+                      [&](std::size_t begin, std::size_t end)
+                      { advance_range(begin, end, dt); });
+}
+
+// time stays inside [0, duration] so float precision doesn't run out on
+// long loops and the frame, the whole number of frame lengths played, is
+// never negative
+void sprite_animator::advance_range(std::size_t begin,
+                                    std::size_t end,
+                                    float       dt)
+{
+    const clip_timing* clips = timing.data();
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        const clip_timing& c = clips[clip[i]];
+        float              t = time[i] + dt * speed[i];
+        if (t < 0.f || t >= c.duration)
+        {
+            // loops wrap both ways, other clips stop at either end. A clip
+            // without a rate has no end to wrap at
+            const float wrapped = std::fmod(t, c.duration);
+            t = c.loop && c.fps > 0.f
+                    ? (wrapped < 0.f ? wrapped + c.duration : wrapped)
+                    : std::clamp(t, 0.f, c.duration);
+        }
+        time[i] = t;
+        const auto played = static_cast<std::uint32_t>(t * c.fps);
+        frame[i]          = c.first_frame + std::min(played, c.last);
+    }
+}
+
+bool sprite_animator::finished(std::size_t index) const
+{
+    const clip_timing& c = timing[clip[index]];
+    return !c.loop && time[index] >= c.duration;
+}
+
+void sprite_animator::write_uvs(sprite_instance* out,
+                                std::size_t      first,
+                                std::size_t      n) const
+{
+    const atlas_rect*    rects = library.frames();
+    const std::uint32_t* shown = frame.get() + first;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        out[i].uv = rects[shown[i]];
+    }
+}
+} // namespace eng
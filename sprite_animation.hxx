@@ -0,0 +1,123 @@
+#ifndef OPENGL_WINDOW_SPRITE_ANIMATION_HXX
+#define OPENGL_WINDOW_SPRITE_ANIMATION_HXX
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace eng
+{
+class job_system;
+struct sprite_instance;
+
+// part of an atlas in texture coordinates. Images are flipped on load, so
+// v0 is the bottom edge of the rectangle and v1 its top
+struct atlas_rect
+{
+    float u0 = 0.f;
+    float v0 = 0.f;
+    float u1 = 1.f;
+    float v1 = 1.f;
+};
+
+// frame_count consecutive frames of a flipbook_library shown at fps
+struct flipbook_clip
+{
+    std::uint32_t first_frame = 0;
+    std::uint32_t frame_count = 1;
+    float         fps         = 12.f;
+    bool          loop        = true;
+};
+
+// the frames and clips animated sprites refer to, built before animating
+class flipbook_library
+{
+public:
+    static constexpr std::uint16_t invalid_clip = 0xffff;
+
+    // returns the frame index
+    std::uint32_t add_frame(atlas_rect frame);
+    // count cells of a columns x rows atlas starting at cell first, cells
+    // numbered left to right and top to bottom like a tileset. Returns the
+    // index of the first added frame
+    std::uint32_t add_grid_frames(int columns, int rows, int first, int count);
+    // returns the clip id for sprite_animator, invalid_clip for a clip
+    // without frames or when the ids ran out
+    std::uint16_t add_clip(const flipbook_clip& clip);
+
+    const flipbook_clip& clip(std::uint16_t id) const { return clips[id]; }
+    std::size_t          clip_count() const { return clips.size(); }
+    const atlas_rect*    frames() const { return frame_rects.data(); }
+
+private:
+    std::vector<atlas_rect>    frame_rects;
+    std::vector<flipbook_clip> clips;
+};
+
+// playback state of many sprites in packed arrays: sprites live in
+// [0, size()) and the last one moves into a removed slot, like particles.
+// Owners keeping per sprite data next to it mirror the move remove reports
+class sprite_animator
+{
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // the library has to outlive the animator, clips may still be added
+    sprite_animator(const flipbook_library& library, std::size_t capacity);
+
+    std::size_t size() const { return count; }
+    std::size_t capacity() const { return max_count; }
+
+    // starts clip at start_time seconds, returns the sprite index or npos
+    // when full or clip isn't in the library
+    std::size_t add(std::uint16_t clip, float start_time = 0.f);
+    // the last sprite moves into index, returns the index it came from
+    // (the new size()) or npos when index was the last one
+    std::size_t remove(std::size_t index);
+    // switches to clip from its first frame, nothing when it already plays
+    // it unless restart or clip isn't in the library
+    void play(std::size_t index, std::uint16_t clip, bool restart = false);
+    // playback rate, 1 is the clip's own fps, 0 pauses and negative plays
+    // backwards
+    void set_speed(std::size_t index, float speed);
+
+    // advances every sprite by dt seconds and picks its frame
+    void advance(float dt);
+    // same, split over the job system
+    void advance(float dt, job_system& jobs);
+
+    // true once a clip that doesn't loop shows its last frame
+    bool finished(std::size_t index) const;
+    // library frame index each sprite shows
+    const std::uint32_t* frames() const { return frame.get(); }
+    // writes the atlas rectangle of sprite first + i into out[i].uv for
+    // n sprites, the rest of the instances is left alone
+    void write_uvs(sprite_instance* out,
+                   std::size_t      first,
+                   std::size_t      n) const;
+
+private:
+    void refresh_timing();
+    void advance_range(std::size_t begin, std::size_t end, float dt);
+
+    // per clip constants in the layout the advance loop reads
+    struct clip_timing
+    {
+        float         fps;
+        float         duration;
+        std::uint32_t first_frame;
+        std::uint32_t last;
+        bool          loop;
+    };
+
+    const flipbook_library&          library;
+    std::vector<clip_timing>         timing;
+    std::size_t                      max_count;
+    std::size_t                      count = 0;
+    std::unique_ptr<std::uint16_t[]> clip;
+    std::unique_ptr<float[]>         time;
+    std::unique_ptr<float[]>         speed;
+    std::unique_ptr<std::uint32_t[]> frame;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_SPRITE_ANIMATION_HXX
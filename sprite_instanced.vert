@@ -0,0 +1,25 @@
+#version 320 es
+
+precision highp float;
+// one unit quad shared by every sprite, the rest is per instance
+layout (location = 0) in vec2 aCorner;
+layout (location = 1) in vec4 aAxes; // axis_x, axis_y
+layout (location = 2) in vec2 aCenter;
+layout (location = 3) in vec4 aRect; // u0, v0, u1, v1
+
+out vec3 ourColor;
+out vec2 TexCoord;
+
+layout (std140, binding = 0) uniform camera_block
+{
+    mat4 view_projection;
+    vec4 viewport;
+};
+
+void main()
+{
+    vec2 pos = aCenter + aCorner.x * aAxes.xy + aCorner.y * aAxes.zw;
+    gl_Position = view_projection * vec4(pos, 0.0, 1.0);
+    ourColor = vec3(1.0);
+    TexCoord = mix(aRect.xy, aRect.zw, aCorner + 0.5);
+}
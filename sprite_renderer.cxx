@@ -0,0 +1,135 @@
+#include "sprite_renderer.hxx"
+
+#include <cstddef>
+
+#include "gl_check.hxx"
+#include "render_stats.hxx"
+#include "shader.hxx"
+#include "vertex_ring.hxx"
+
+namespace eng
+{
+// attributes 1 to 3 read the instance as two vec4 around a vec2
+static_assert(sizeof(sprite_instance) == 10 * sizeof(float));
+static_assert(offsetof(sprite_instance, axis_y) ==
+              offsetof(sprite_instance, axis_x) + 2 * sizeof(float));
+
+sprite_renderer::sprite_renderer(std::size_t max_sprites_per_frame)
+{
+    // same fragment program as the sprite stream
+    shader =
+        std::make_unique<Shader>("sprite_instanced.vert", "fragment.frag");
+    instances = std::make_unique<vertex_ring>(
+        GL_ARRAY_BUFFER, max_sprites_per_frame * sizeof(sprite_instance));
+
+    const float corners[] = { -0.5f, -0.5f, 0.5f, -0.5f,
+                              -0.5f, 0.5f,  0.5f, 0.5f };
+    glGenBuffers(1, &quad_vbo);
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(0);
+    // instance attributes, their offsets are set per draw
+    for (GLuint a = 1; a <= 3; ++a)
+    {
+        glEnableVertexAttribArray(a);
+        glVertexAttribDivisor(a, 1);
+    }
+    glBindVertexArray(0);
+
+    const unsigned char white_texel[] = { 255, 255, 255, 255 };
+    glGenTextures(1, &white);
+    glBindTexture(GL_TEXTURE_2D, white);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, 1, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                    white_texel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    OM_GL_CHECK(glBindTexture)
+
+    instances->begin_region();
+}
+
+sprite_renderer::~sprite_renderer()
+{
+    glDeleteTextures(1, &white);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &quad_vbo);
+}
+
+void sprite_renderer::begin_frame()
+{
+    instances->begin_region();
+}
+
+void sprite_renderer::end_frame()
+{
+    instances->end_region();
+}
+
+sprite_instance* sprite_renderer::map(std::size_t n)
+{
+    mapped_count = 0;
+    if (n == 0)
+    {
+        return nullptr;
+    }
+    auto* dst = static_cast<sprite_instance*>(instances->allocate(
+        n * sizeof(sprite_instance), sizeof(sprite_instance), mapped_offset));
+    if (dst)
+    {
+        mapped_count = n;
+    }
+    return dst;
+}
+
+std::size_t sprite_renderer::draw(int texture)
+{
+    const std::size_t n = mapped_count;
+    if (n == 0)
+    {
+        return 0;
+    }
+    mapped_count = 0;
+    instances->unmap();
+
+    shader->use();
+    shader->setInt("ourTexture", 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D,
+                  texture ? static_cast<GLuint>(texture) : white);
+    count_texture_bind();
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instances->buffer());
+    const auto field = [&](std::size_t member)
+    { return reinterpret_cast<void*>(mapped_offset + member); };
+    const GLsizei stride = sizeof(sprite_instance);
+    glVertexAttribPointer(1,
+                          4,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          stride,
+                          field(offsetof(sprite_instance, axis_x)));
+    glVertexAttribPointer(2,
+                          2,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          stride,
+                          field(offsetof(sprite_instance, center)));
+    glVertexAttribPointer(3,
+                          4,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          stride,
+                          field(offsetof(sprite_instance, uv)));
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(n));
+    OM_GL_CHECK(glDrawArraysInstanced)
+    count_draw(2 * n);
+    glBindVertexArray(0);
+    return n;
+}
+} // namespace eng
@@ -0,0 +1,71 @@
+#ifndef OPENGL_WINDOW_SPRITE_RENDERER_HXX
+#define OPENGL_WINDOW_SPRITE_RENDERER_HXX
+#include <cmath>
+#include <cstddef>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "glad/glad.h"
+
+#include "sprite_animation.hxx"
+
+namespace eng
+{
+class vertex_ring;
+struct Shader;
+
+// one sprite of the instanced stream, the unit quad around the origin
+// mapped to center + x * axis_x + y * axis_y, so size and rotation are
+// baked into the axes
+struct sprite_instance
+{
+    glm::vec2  axis_x;
+    glm::vec2  axis_y;
+    glm::vec2  center;
+    atlas_rect uv;
+};
+
+// size in world units, angle in radians counter clockwise
+inline void place_sprite(sprite_instance& s,
+                         glm::vec2        center,
+                         glm::vec2        size,
+                         float            angle)
+{
+    const float c = std::cos(angle);
+    const float n = std::sin(angle);
+    s.axis_x      = glm::vec2(c, n) * size.x;
+    s.axis_y      = glm::vec2(-n, c) * size.y;
+    s.center      = center;
+}
+
+// draws sprites sharing a texture with one instanced draw call, the
+// instances are written straight into a vertex ring
+class sprite_renderer
+{
+public:
+    // the ring holds max_sprites_per_frame instances per frame in flight,
+    // map returns null past it
+    explicit sprite_renderer(std::size_t max_sprites_per_frame);
+    ~sprite_renderer();
+
+    void begin_frame();
+    void end_frame();
+    // n instances to fill before draw, null when the frame's budget is
+    // used up
+    sprite_instance* map(std::size_t n);
+    // draws the instances of the last map, returns how many. Texture 0
+    // draws them as plain white quads
+    std::size_t draw(int texture);
+
+private:
+    std::unique_ptr<Shader>      shader;
+    std::unique_ptr<vertex_ring> instances;
+    GLuint                       quad_vbo      = 0;
+    GLuint                       vao           = 0;
+    GLuint                       white         = 0;
+    std::size_t                  mapped_offset = 0;
+    std::size_t                  mapped_count  = 0;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_SPRITE_RENDERER_HXX
@@ -0,0 +1,378 @@
+#include "text.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iterator>
+
+#include "truetype.hxx"
+
+namespace eng
+{
+const glyph& font_atlas::find(unsigned char c) const
+{
+    if (c < first_char || c >= first_char + char_count)
+    {
+        c = '?';
+    }
+    return glyphs[c - first_char];
+}
+
+// texels between the outline and the point where the field saturates,
+// enough for smooth edges well below and above the atlas size
+static constexpr int sdf_padding = 4;
+
+bool load_font_atlas(const std::string& ttf_path,
+                     float              pixel_height,
+                     font_atlas&        out)
+{
+    std::ifstream file(ttf_path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    truetype_font font;
+    if (!font.load(std::vector<std::uint8_t>(
+            (std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>())))
+    {
+        return false;
+    }
+    const float scale = font.scale_for_pixel_height(pixel_height);
+    out.ascent        = font.ascent() * scale / pixel_height;
+    out.line_height =
+        (font.ascent() - font.descent() + font.line_gap()) * scale /
+        pixel_height;
+
+    struct bitmap
+    {
+        glyph_field field;
+        int         x = 0, y = 0;
+    };
+    bitmap bitmaps[font_atlas::char_count];
+
+    // shelf packing into rows of a fixed width atlas
+    const int atlas_width = 1024;
+    int       pen_x = 0, pen_y = 0, shelf = 0;
+    for (int i = 0; i < font_atlas::char_count; ++i)
+    {
+        const int    glyph = font.glyph_index(font_atlas::first_char + i);
+        bitmap&      b     = bitmaps[i];
+        glyph_field& f     = b.field;
+        font.distance_field(
+            glyph, scale, sdf_padding, 128, 128.f / sdf_padding, f);
+        if (pen_x + f.width > atlas_width)
+        {
+            pen_x = 0;
+            pen_y += shelf;
+            shelf = 0;
+        }
+        b.x = pen_x;
+        b.y = pen_y;
+        pen_x += f.width + 1;
+        shelf = std::max(shelf, f.height + 1);
+
+        out.glyphs[i].advance =
+            font.advance_width(glyph) * scale / pixel_height;
+    }
+    // solid block on a row of its own under the glyphs
+    constexpr int solid = 4;
+    out.width           = atlas_width;
+    out.height          = pen_y + shelf + solid;
+    out.pixels.assign(static_cast<std::size_t>(out.width) * out.height, 0);
+    for (int row = out.height - solid; row < out.height; ++row)
+    {
+        std::fill_n(out.pixels.data() + row * out.width, solid, 255);
+    }
+    out.solid_u = solid * 0.5f / out.width;
+    out.solid_v = (out.height - solid * 0.5f) / out.height;
+
+    for (int i = 0; i < font_atlas::char_count; ++i)
+    {
+        const bitmap&      b = bitmaps[i];
+        const glyph_field& f = b.field;
+        glyph&             g = out.glyphs[i];
+        for (int row = 0; row < f.height; ++row)
+        {
+            std::copy_n(f.pixels.data() + row * f.width,
+                        f.width,
+                        out.pixels.data() + (b.y + row) * out.width + b.x);
+        }
+        // field offsets point down from the baseline
+        g.x0 = f.x_offset / pixel_height;
+        g.x1 = (f.x_offset + f.width) / pixel_height;
+        g.y1 = -f.y_offset / pixel_height;
+        g.y0 = -(f.y_offset + f.height) / pixel_height;
+        g.u0 = static_cast<float>(b.x) / out.width;
+        g.v0 = static_cast<float>(b.y) / out.height;
+        g.u1 = static_cast<float>(b.x + f.width) / out.width;
+        g.v1 = static_cast<float>(b.y + f.height) / out.height;
+    }
+    return true;
+}
+
+// columns of the classic 5x7 LCD font, bit 0 is the top row
+static const std::uint8_t builtin_glyphs[font_atlas::char_count][5] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, // space
+    { 0x00, 0x00, 0x5f, 0x00, 0x00 }, // !
+    { 0x00, 0x07, 0x00, 0x07, 0x00 }, // "
+    { 0x14, 0x7f, 0x14, 0x7f, 0x14 }, // #
+    { 0x24, 0x2a, 0x7f, 0x2a, 0x12 }, // $
+    { 0x23, 0x13, 0x08, 0x64, 0x62 }, // %
+    { 0x36, 0x49, 0x55, 0x22, 0x50 }, // &
+    { 0x00, 0x05, 0x03, 0x00, 0x00 }, // quote
+    { 0x00, 0x1c, 0x22, 0x41, 0x00 }, // (
+    { 0x00, 0x41, 0x22, 0x1c, 0x00 }, // )
+    { 0x14, 0x08, 0x3e, 0x08, 0x14 }, // *
+    { 0x08, 0x08, 0x3e, 0x08, 0x08 }, // +
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, // ,
+    { 0x08, 0x08, 0x08, 0x08, 0x08 }, // -
+    { 0x00, 0x60, 0x60, 0x00, 0x00 }, // .
+    { 0x20, 0x10, 0x08, 0x04, 0x02 }, // /
+    { 0x3e, 0x51, 0x49, 0x45, 0x3e }, // 0
+    { 0x00, 0x42, 0x7f, 0x40, 0x00 }, // 1
+    { 0x42, 0x61, 0x51, 0x49, 0x46 }, // 2
+    { 0x21, 0x41, 0x45, 0x4b, 0x31 }, // 3
+    { 0x18, 0x14, 0x12, 0x7f, 0x10 }, // 4
+    { 0x27, 0x45, 0x45, 0x45, 0x39 }, // 5
+    { 0x3c, 0x4a, 0x49, 0x49, 0x30 }, // 6
+    { 0x01, 0x71, 0x09, 0x05, 0x03 }, // 7
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, // 8
+    { 0x06, 0x49, 0x49, 0x29, 0x1e }, // 9
+    { 0x00, 0x36, 0x36, 0x00, 0x00 }, // :
+    { 0x00, 0x56, 0x36, 0x00, 0x00 }, // ;
+    { 0x08, 0x14, 0x22, 0x41, 0x00 }, // <
+    { 0x14, 0x14, 0x14, 0x14, 0x14 }, // =
+    { 0x00, 0x41, 0x22, 0x14, 0x08 }, // >
+    { 0x02, 0x01, 0x51, 0x09, 0x06 }, // ?
+    { 0x32, 0x49, 0x79, 0x41, 0x3e }, // @
+    { 0x7e, 0x11, 0x11, 0x11, 0x7e }, // A
+    { 0x7f, 0x49, 0x49, 0x49, 0x36 }, // B
+    { 0x3e, 0x41, 0x41, 0x41, 0x22 }, // C
+    { 0x7f, 0x41, 0x41, 0x22, 0x1c }, // D
+    { 0x7f, 0x49, 0x49, 0x49, 0x41 }, // E
+    { 0x7f, 0x09, 0x09, 0x09, 0x01 }, // F
+    { 0x3e, 0x41, 0x49, 0x49, 0x7a }, // G
+    { 0x7f, 0x08, 0x08, 0x08, 0x7f }, // H
+    { 0x00, 0x41, 0x7f, 0x41, 0x00 }, // I
+    { 0x20, 0x40, 0x41, 0x3f, 0x01 }, // J
+    { 0x7f, 0x08, 0x14, 0x22, 0x41 }, // K
+    { 0x7f, 0x40, 0x40, 0x40, 0x40 }, // L
+    { 0x7f, 0x02, 0x0c, 0x02, 0x7f }, // M
+    { 0x7f, 0x04, 0x08, 0x10, 0x7f }, // N
+    { 0x3e, 0x41, 0x41, 0x41, 0x3e }, // O
+    { 0x7f, 0x09, 0x09, 0x09, 0x06 }, // P
+    { 0x3e, 0x41, 0x51, 0x21, 0x5e }, // Q
+    { 0x7f, 0x09, 0x19, 0x29, 0x46 }, // R
+    { 0x46, 0x49, 0x49, 0x49, 0x31 }, // S
+    { 0x01, 0x01, 0x7f, 0x01, 0x01 }, // T
+    { 0x3f, 0x40, 0x40, 0x40, 0x3f }, // U
+    { 0x1f, 0x20, 0x40, 0x20, 0x1f }, // V
+    { 0x3f, 0x40, 0x38, 0x40, 0x3f }, // W
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, // X
+    { 0x07, 0x08, 0x70, 0x08, 0x07 }, // Y
+    { 0x61, 0x51, 0x49, 0x45, 0x43 }, // Z
+    { 0x00, 0x7f, 0x41, 0x41, 0x00 }, // [
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, // backslash
+    { 0x00, 0x41, 0x41, 0x7f, 0x00 }, // ]
+    { 0x04, 0x02, 0x01, 0x02, 0x04 }, // ^
+    { 0x40, 0x40, 0x40, 0x40, 0x40 }, // _
+    { 0x00, 0x01, 0x02, 0x04, 0x00 }, // `
+    { 0x20, 0x54, 0x54, 0x54, 0x78 }, // a
+    { 0x7f, 0x48, 0x44, 0x44, 0x38 }, // b
+    { 0x38, 0x44, 0x44, 0x44, 0x20 }, // c
+    { 0x38, 0x44, 0x44, 0x48, 0x7f }, // d
+    { 0x38, 0x54, 0x54, 0x54, 0x18 }, // e
+    { 0x08, 0x7e, 0x09, 0x01, 0x02 }, // f
+    { 0x0c, 0x52, 0x52, 0x52, 0x3e }, // g
+    { 0x7f, 0x08, 0x04, 0x04, 0x78 }, // h
+    { 0x00, 0x44, 0x7d, 0x40, 0x00 }, // i
+    { 0x20, 0x40, 0x44, 0x3d, 0x00 }, // j
+    { 0x7f, 0x10, 0x28, 0x44, 0x00 }, // k
+    { 0x00, 0x41, 0x7f, 0x40, 0x00 }, // l
+    { 0x7c, 0x04, 0x18, 0x04, 0x78 }, // m
+    { 0x7c, 0x08, 0x04, 0x04, 0x78 }, // n
+    { 0x38, 0x44, 0x44, 0x44, 0x38 }, // o
+    { 0x7c, 0x14, 0x14, 0x14, 0x08 }, // p
+    { 0x08, 0x14, 0x14, 0x18, 0x7c }, // q
+    { 0x7c, 0x08, 0x04, 0x04, 0x08 }, // r
+    { 0x48, 0x54, 0x54, 0x54, 0x20 }, // s
+    { 0x04, 0x3f, 0x44, 0x40, 0x20 }, // t
+    { 0x3c, 0x40, 0x40, 0x20, 0x7c }, // u
+    { 0x1c, 0x20, 0x40, 0x20, 0x1c }, // v
+    { 0x3c, 0x40, 0x30, 0x40, 0x3c }, // w
+    { 0x44, 0x28, 0x10, 0x28, 0x44 }, // x
+    { 0x0c, 0x50, 0x50, 0x50, 0x3c }, // y
+    { 0x44, 0x64, 0x54, 0x4c, 0x44 }, // z
+    { 0x00, 0x08, 0x36, 0x41, 0x00 }, // {
+    { 0x00, 0x00, 0x7f, 0x00, 0x00 }, // |
+    { 0x00, 0x41, 0x36, 0x08, 0x00 }, // }
+    { 0x10, 0x08, 0x08, 0x10, 0x08 }, // ~
+};
+
+void builtin_font_atlas(font_atlas& out)
+{
+    // every font pixel becomes scale x scale texels so the field has room
+    // to describe the square corners
+    constexpr int scale   = 6;
+    constexpr int cell_w  = 5 * scale + 2 * sdf_padding;
+    constexpr int cell_h  = 7 * scale + 2 * sdf_padding;
+    constexpr int columns = 16;
+    // one spare cell for the solid block
+    constexpr int rows = font_atlas::char_count / columns + 1;
+    // 7 rows of glyph plus one of spacing make an em
+    constexpr float em = 8.f * scale;
+
+    out.width  = columns * cell_w;
+    out.height = rows * cell_h;
+    out.pixels.assign(static_cast<std::size_t>(out.width) * out.height, 0);
+    out.ascent      = 7.f * scale / em;
+    out.line_height = 9.f * scale / em;
+
+    for (int i = 0; i < font_atlas::char_count; ++i)
+    {
+        const std::uint8_t* columns_bits = builtin_glyphs[i];
+        auto inside = [columns_bits](int x, int y)
+        {
+            if (x < 0 || y < 0 || x >= 5 * scale || y >= 7 * scale)
+            {
+                return false;
+            }
+            return ((columns_bits[x / scale] >> (y / scale)) & 1) != 0;
+        };
+        const int cell_x = (i % columns) * cell_w;
+        const int cell_y = (i / columns) * cell_h;
+        for (int y = 0; y < cell_h; ++y)
+        {
+            for (int x = 0; x < cell_w; ++x)
+            {
+                const int  gx = x - sdf_padding;
+                const int  gy = y - sdf_padding;
+                const bool in = inside(gx, gy);
+                // nearest texel of the other kind, the outline runs half a
+                // texel before it
+                int best = (sdf_padding + 1) * (sdf_padding + 1);
+                for (int dy = -sdf_padding; dy <= sdf_padding; ++dy)
+                {
+                    for (int dx = -sdf_padding; dx <= sdf_padding; ++dx)
+                    {
+                        if (inside(gx + dx, gy + dy) != in)
+                        {
+                            best = std::min(best, dx * dx + dy * dy);
+                        }
+                    }
+                }
+                const float distance =
+                    std::min(std::sqrt(static_cast<float>(best)) - 0.5f,
+                             static_cast<float>(sdf_padding));
+                const float value =
+                    128.f + (in ? distance : -distance) * 127.f / sdf_padding;
+                out.pixels[(cell_y + y) * out.width + cell_x + x] =
+                    static_cast<std::uint8_t>(std::clamp(value, 0.f, 255.f));
+            }
+        }
+
+        glyph& g  = out.glyphs[i];
+        g.x0      = -sdf_padding / em;
+        g.x1      = (5.f * scale + sdf_padding) / em;
+        g.y0      = -sdf_padding / em;
+        g.y1      = (7.f * scale + sdf_padding) / em;
+        g.u0      = static_cast<float>(cell_x) / out.width;
+        g.v0      = static_cast<float>(cell_y) / out.height;
+        g.u1      = static_cast<float>(cell_x + cell_w) / out.width;
+        g.v1      = static_cast<float>(cell_y + cell_h) / out.height;
+        g.advance = 6.f * scale / em;
+    }
+
+    // the cell after the last glyph is free, fill it for solid quads
+    const int solid_x = (font_atlas::char_count % columns) * cell_w;
+    const int solid_y = (font_atlas::char_count / columns) * cell_h;
+    for (int y = 0; y < cell_h; ++y)
+    {
+        std::fill_n(out.pixels.data() + (solid_y + y) * out.width + solid_x,
+                    cell_w,
+                    255);
+    }
+    out.solid_u = (solid_x + cell_w * 0.5f) / out.width;
+    out.solid_v = (solid_y + cell_h * 0.5f) / out.height;
+}
+
+const std::vector<glyph_quad>& text_layout_cache::layout(
+    int font_id, const font_atlas& font, std::string_view text)
+{
+    ++clock;
+    const auto found = index.find(key{ font_id, text });
+    if (found != index.end())
+    {
+        ++hit_count;
+        entry& e    = entries[found->second];
+        e.last_used = clock;
+        return e.quads;
+    }
+    ++miss_count;
+
+    // a recycled slot hands its index node to the new key
+    decltype(index)::node_type node;
+    entry*                     slot = nullptr;
+    if (entries.size() < slots)
+    {
+        if (entries.empty())
+        {
+            entries.reserve(slots);
+            index.reserve(slots);
+        }
+        slot = &entries.emplace_back();
+    }
+    else
+    {
+        slot = &*std::min_element(entries.begin(),
+                                  entries.end(),
+                                  [](const entry& a, const entry& b)
+                                  { return a.last_used < b.last_used; });
+        node = index.extract(key{ slot->font, slot->text });
+    }
+    slot->font      = font_id;
+    slot->last_used = clock;
+    slot->text.assign(text.data(), text.size());
+    slot->quads.clear();
+
+    const key         k{ font_id, slot->text };
+    const std::size_t at = static_cast<std::size_t>(slot - entries.data());
+    if (node)
+    {
+        node.key()    = k;
+        node.mapped() = at;
+        index.insert(std::move(node));
+    }
+    else
+    {
+        index.emplace(k, at);
+    }
+    float pen_x = 0.f;
+    float pen_y = -font.ascent;
+    for (const char ch : text)
+    {
+        if (ch == '\n')
+        {
+            pen_x = 0.f;
+            pen_y -= font.line_height;
+            continue;
+        }
+        const glyph& g = font.find(static_cast<unsigned char>(ch));
+        if (ch != ' ')
+        {
+            slot->quads.push_back({ pen_x + g.x0,
+                                    pen_y + g.y0,
+                                    pen_x + g.x1,
+                                    pen_y + g.y1,
+                                    g.u0,
+                                    g.v0,
+                                    g.u1,
+                                    g.v1 });
+        }
+        pen_x += g.advance;
+    }
+    return slot->quads;
+}
+} // namespace eng
@@ -0,0 +1,19 @@
+#version 320 es
+
+precision mediump float;
+out vec4 FragColor;
+in vec3 ourColor;
+in vec2 TexCoord;
+uniform sampler2D ourTexture;
+void main()
+{
+    // the atlas holds a distance field with the outline at 0.5, fwidth
+    // keeps the edge one pixel wide at any text size
+    float d     = texture(ourTexture, TexCoord).r;
+    float w     = max(fwidth(d), 1.0 / 255.0);
+    float alpha = smoothstep(0.5 - w, 0.5 + w, d);
+    if (alpha <= 0.0) {
+        discard;
+    }
+    FragColor = vec4(ourColor, alpha);
+}
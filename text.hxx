@@ -0,0 +1,111 @@
+#ifndef OPENGL_WINDOW_TEXT_HXX
+#define OPENGL_WINDOW_TEXT_HXX
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace eng
+{
+// glyph rectangle relative to the pen on the baseline, in ems with y up,
+// and its corners in the atlas with v growing down the rows
+struct glyph
+{
+    float x0, y0, x1, y1;
+    float u0, v0, u1, v1;
+    float advance;
+};
+
+// signed distance field of the printable ASCII range, one byte per texel,
+// 128 on the glyph outline and growing towards the inside
+struct font_atlas
+{
+    static constexpr int first_char = 32;
+    static constexpr int char_count = 95;
+
+    int                       width  = 0;
+    int                       height = 0;
+    std::vector<std::uint8_t> pixels;
+    float                     ascent      = 1.f; // ems
+    float                     line_height = 1.f; // ems
+    glyph                     glyphs[char_count];
+    // middle of a block that is inside everywhere, quads sampling only it
+    // come out solid with the text program
+    float solid_u = 0.f;
+    float solid_v = 0.f;
+
+    // characters outside the atlas show up as '?'
+    const glyph& find(unsigned char c) const;
+};
+
+// rasterizes a TrueType font with truetype_font, pixel_height is the em size
+// in atlas texels. False when the file can not be read or isn't a font
+bool load_font_atlas(const std::string& ttf_path,
+                     float              pixel_height,
+                     font_atlas&        out);
+// 5x7 pixel font compiled into the engine, always available
+void builtin_font_atlas(font_atlas& out);
+
+struct glyph_quad
+{
+    float x0, y0, x1, y1;
+    float u0, v0, u1, v1;
+};
+
+// laid out strings, keyed by font and text, so a HUD that redraws the same
+// labels every frame only walks the glyphs once. A hit is one hash lookup,
+// only a miss on a full cache scans for the least recently used slot. Slots
+// and index nodes are recycled with their storage, after warming up a miss
+// does not allocate either
+class text_layout_cache
+{
+public:
+    static constexpr std::size_t slots = 256;
+
+    // quads in ems, the first line's top at y = 0 and lines going down,
+    // valid until the next call
+    const std::vector<glyph_quad>& layout(int               font_id,
+                                          const font_atlas& font,
+                                          std::string_view  text);
+
+    std::uint64_t hits() const { return hit_count; }
+    std::uint64_t misses() const { return miss_count; }
+
+private:
+    struct entry
+    {
+        int                     font = 0;
+        std::string             text;
+        std::vector<glyph_quad> quads;
+        std::uint64_t           last_used = 0;
+    };
+    // text views the string of its entry, entries never move once reserved
+    struct key
+    {
+        int              font;
+        std::string_view text;
+
+        bool operator==(const key& k) const
+        {
+            return font == k.font && text == k.text;
+        }
+    };
+    struct key_hash
+    {
+        std::size_t operator()(const key& k) const
+        {
+            return std::hash<std::string_view>()(k.text) ^
+                   static_cast<std::size_t>(k.font);
+        }
+    };
+
+    std::vector<entry>                             entries;
+    std::unordered_map<key, std::size_t, key_hash> index; // entry of a key
+    std::uint64_t                                  clock      = 0;
+    std::uint64_t                                  hit_count  = 0;
+    std::uint64_t                                  miss_count = 0;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_TEXT_HXX
@@ -0,0 +1,350 @@
+#include "tilemap.hxx"
+
+#include <algorithm>
+#include <cmath>
+
+#include "gl_check.hxx"
+#include "render_stats.hxx"
+#include "shader.hxx"
+
+namespace eng
+{
+static std::int64_t chunk_key(int cx, int cy)
+{
+    return (static_cast<std::int64_t>(cx) << 32) |
+           static_cast<std::uint32_t>(cy);
+}
+static int chunk_key_x(std::int64_t key)
+{
+    return static_cast<int>(key >> 32);
+}
+static int chunk_key_y(std::int64_t key)
+{
+    return static_cast<int>(static_cast<std::uint32_t>(key));
+}
+// four vertices for every six indices
+static std::int64_t chunk_vertex_bytes(int index_count)
+{
+    return static_cast<std::int64_t>(index_count) / 6 * 4 * sizeof(vertex);
+}
+
+tilemap::tilemap(glm::ivec2   size_in_tiles,
+                 glm::vec2    tile_size,
+                 glm::vec2    origin,
+                 tileset      set,
+                 chunk_loader loader)
+    : size_in_tiles(size_in_tiles)
+    , size_in_chunks((size_in_tiles.x + chunk_size - 1) / chunk_size,
+                     (size_in_tiles.y + chunk_size - 1) / chunk_size)
+    , tile_size(tile_size)
+    , origin(origin)
+    , set(set)
+    , loader(std::move(loader))
+{
+    shader = std::make_unique<Shader>("vertex.vert", "fragment.frag");
+
+    // every chunk shares one index buffer, tile quads are laid out like the
+    // quads of engine::draw_texture: top right, bottom right, bottom left,
+    // top left
+    std::vector<std::uint16_t> indices;
+    indices.reserve(chunk_size * chunk_size * 6);
+    for (int q = 0; q < chunk_size * chunk_size; ++q)
+    {
+        const std::uint16_t base = static_cast<std::uint16_t>(q * 4);
+        for (std::uint16_t i : { 0, 1, 3, 1, 2, 3 })
+        {
+            indices.push_back(base + i);
+        }
+    }
+    glGenBuffers(1, &ebo);
+    OM_GL_CHECK(glGenBuffers)
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 indices.size() * sizeof(std::uint16_t),
+                 indices.data(),
+                 GL_STATIC_DRAW);
+    OM_GL_CHECK(glBufferData)
+
+    worker = std::thread(&tilemap::stream_loop, this);
+}
+
+tilemap::~tilemap()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stop = true;
+    }
+    queue_cv.notify_all();
+    worker.join();
+
+    for (auto& [key, c] : chunks)
+    {
+        release(c);
+    }
+    glDeleteBuffers(1, &ebo);
+}
+
+glm::ivec4 tilemap::chunk_range(glm::vec2 view_min, glm::vec2 view_max) const
+{
+    const glm::vec2 chunk_world = tile_size * static_cast<float>(chunk_size);
+    const glm::vec2 lo          = glm::floor((view_min - origin) / chunk_world);
+    const glm::vec2 hi          = glm::floor((view_max - origin) / chunk_world);
+    return { std::max(0, static_cast<int>(lo.x)),
+             std::max(0, static_cast<int>(lo.y)),
+             std::min(size_in_chunks.x - 1, static_cast<int>(hi.x)),
+             std::min(size_in_chunks.y - 1, static_cast<int>(hi.y)) };
+}
+
+bool tilemap::in_range(glm::ivec4 range, int cx, int cy)
+{
+    return cx >= range.x && cy >= range.y && cx <= range.z && cy <= range.w;
+}
+
+void tilemap::update(glm::vec2 view_min, glm::vec2 view_max)
+{
+    visible = chunk_range(view_min, view_max);
+    // chunks one ring outside the view stay resident, so moving back and
+    // forth over a chunk border does not rebuild it every frame
+    const glm::ivec4 keep{
+        visible.x - 1, visible.y - 1, visible.z + 1, visible.w + 1
+    };
+
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        ready.swap(built);
+
+        auto stale = std::remove_if(
+            to_build.begin(),
+            to_build.end(),
+            [&](std::int64_t key)
+            { return !in_range(keep, chunk_key_x(key), chunk_key_y(key)); });
+        for (auto it = stale; it != to_build.end(); ++it)
+        {
+            requested.erase(*it);
+        }
+        to_build.erase(stale, to_build.end());
+
+        for (int cy = visible.y; cy <= visible.w; ++cy)
+        {
+            for (int cx = visible.x; cx <= visible.z; ++cx)
+            {
+                const std::int64_t key = chunk_key(cx, cy);
+                if (chunks.count(key) == 0 && requested.count(key) == 0)
+                {
+                    requested[key] = true;
+                    to_build.push_back(key);
+                    queued = true;
+                }
+            }
+        }
+    }
+    if (queued)
+    {
+        queue_cv.notify_one();
+    }
+
+    for (built_chunk& b : ready)
+    {
+        if (requested.erase(b.key) != 0 &&
+            in_range(keep, chunk_key_x(b.key), chunk_key_y(b.key)))
+        {
+            upload(b);
+        }
+    }
+    ready.clear();
+
+    for (auto it = chunks.begin(); it != chunks.end();)
+    {
+        if (!in_range(keep, chunk_key_x(it->first), chunk_key_y(it->first)))
+        {
+            release(it->second);
+            it = chunks.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void tilemap::update(const camera& cam)
+{
+    glm::vec2 view_min;
+    glm::vec2 view_max;
+    cam.visible_rect(view_min, view_max);
+    update(view_min, view_max);
+}
+
+void tilemap::draw()
+{
+    shader->use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, set.texture);
+    count_texture_bind();
+    shader->setInt("ourTexture", 0);
+    shader->setMat4("transform", glm::mat4(1.0f));
+    OM_GL_CHECK(glUniformMatrix4fv)
+
+    for (int cy = visible.y; cy <= visible.w; ++cy)
+    {
+        for (int cx = visible.x; cx <= visible.z; ++cx)
+        {
+            auto it = chunks.find(chunk_key(cx, cy));
+            if (it == chunks.end() || it->second.index_count == 0)
+            {
+                continue;
+            }
+            glBindVertexArray(it->second.vao);
+            glDrawElements(GL_TRIANGLES,
+                           it->second.index_count,
+                           GL_UNSIGNED_SHORT,
+                           nullptr);
+            OM_GL_CHECK(glDrawElements)
+            count_draw(it->second.index_count / 3);
+        }
+    }
+    glBindVertexArray(0);
+}
+
+void tilemap::stream_loop()
+{
+    for (;;)
+    {
+        std::int64_t key;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cv.wait(lock, [this] { return stop || !to_build.empty(); });
+            if (stop)
+            {
+                return;
+            }
+            key = to_build.front();
+            to_build.pop_front();
+        }
+
+        built_chunk b{ key, {} };
+        build_chunk(chunk_key_x(key), chunk_key_y(key), b.vertices);
+
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        built.push_back(std::move(b));
+    }
+}
+
+void tilemap::build_chunk(int cx, int cy, std::vector<vertex>& out) const
+{
+    std::vector<std::uint16_t> tiles(chunk_size * chunk_size, empty_tile);
+    loader(cx, cy, tiles.data());
+
+    const int   first_x = cx * chunk_size;
+    const int   first_y = cy * chunk_size;
+    const int   tiles_x = std::min(chunk_size, size_in_tiles.x - first_x);
+    const int   tiles_y = std::min(chunk_size, size_in_tiles.y - first_y);
+    const float cell_u  = 1.f / static_cast<float>(set.columns);
+    const float cell_v  = 1.f / static_cast<float>(set.rows);
+
+    out.reserve(tiles_x * tiles_y * 4);
+    for (int y = 0; y < tiles_y; ++y)
+    {
+        for (int x = 0; x < tiles_x; ++x)
+        {
+            const std::uint16_t tile = tiles[y * chunk_size + x];
+            if (tile == empty_tile)
+            {
+                continue;
+            }
+            const int col = tile % set.columns;
+            const int row = tile / set.columns;
+            // images are flipped on load, the top atlas row sits at v = 1
+            const float u0 = col * cell_u;
+            const float u1 = u0 + cell_u;
+            const float v1 = 1.f - row * cell_v;
+            const float v0 = v1 - cell_v;
+
+            const float x0 = origin.x + (first_x + x) * tile_size.x;
+            const float y0 = origin.y + (first_y + y) * tile_size.y;
+            const float x1 = x0 + tile_size.x;
+            const float y1 = y0 + tile_size.y;
+
+            out.push_back({ x1, y1, 0.f, 1.f, 1.f, 1.f, u1, v1 });
+            out.push_back({ x1, y0, 0.f, 1.f, 1.f, 1.f, u1, v0 });
+            out.push_back({ x0, y0, 0.f, 1.f, 1.f, 1.f, u0, v0 });
+            out.push_back({ x0, y1, 0.f, 1.f, 1.f, 1.f, u0, v1 });
+        }
+    }
+}
+
+void tilemap::upload(built_chunk& b)
+{
+    chunk c;
+    c.index_count = static_cast<int>(b.vertices.size() / 4 * 6);
+    if (c.index_count != 0)
+    {
+        glGenVertexArrays(1, &c.vao);
+        glGenBuffers(1, &c.vbo);
+        glBindVertexArray(c.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, c.vbo);
+        glBufferData(GL_ARRAY_BUFFER,
+                     b.vertices.size() * sizeof(vertex),
+                     b.vertices.data(),
+                     GL_STATIC_DRAW);
+        gpu_memory_bytes() += chunk_vertex_bytes(c.index_count);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+
+        glVertexAttribPointer(
+            0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1,
+                              3,
+                              GL_FLOAT,
+                              GL_FALSE,
+                              sizeof(vertex),
+                              (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2,
+                              2,
+                              GL_FLOAT,
+                              GL_FALSE,
+                              sizeof(vertex),
+                              (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glBindVertexArray(0);
+        OM_GL_CHECK(glBindVertexArray)
+    }
+    chunks[b.key] = c;
+}
+
+void tilemap::release(chunk& c)
+{
+    if (c.vao != 0)
+    {
+        glDeleteVertexArrays(1, &c.vao);
+        glDeleteBuffers(1, &c.vbo);
+        gpu_memory_bytes() -= chunk_vertex_bytes(c.index_count);
+    }
+    c = chunk();
+}
+
+tilemap::chunk_loader make_grid_loader(std::vector<std::uint16_t> grid,
+                                       glm::ivec2                 size)
+{
+    auto shared = std::make_shared<const std::vector<std::uint16_t>>(
+        std::move(grid));
+    return [shared, size](int cx, int cy, std::uint16_t* tiles)
+    {
+        for (int y = 0; y < tilemap::chunk_size; ++y)
+        {
+            const int ty = cy * tilemap::chunk_size + y;
+            for (int x = 0; x < tilemap::chunk_size; ++x)
+            {
+                const int tx = cx * tilemap::chunk_size + x;
+                if (tx < size.x && ty < size.y)
+                {
+                    tiles[y * tilemap::chunk_size + x] =
+                        (*shared)[ty * size.x + tx];
+                }
+            }
+        }
+    };
+}
+} // namespace eng
@@ -0,0 +1,106 @@
+#ifndef OPENGL_WINDOW_TILEMAP_HXX
+#define OPENGL_WINDOW_TILEMAP_HXX
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "engine.hxx"
+
+namespace eng
+{
+struct Shader;
+
+// atlas of equally sized tiles, index 0 is the top left cell and indices
+// grow left to right, top to bottom
+struct tileset
+{
+    int texture = 0; // handle returned by engine::load_texture
+    int columns = 1;
+    int rows    = 1;
+};
+
+class tilemap
+{
+public:
+    static constexpr int           chunk_size = 32; // tiles per chunk side
+    static constexpr std::uint16_t empty_tile = 0xFFFF;
+
+    // fills chunk_size * chunk_size tile indices (row major, bottom row
+    // first) of the chunk, called from the streaming thread
+    using chunk_loader =
+        std::function<void(int chunk_x, int chunk_y, std::uint16_t* tiles)>;
+
+    tilemap(glm::ivec2   size_in_tiles,
+            glm::vec2    tile_size,
+            glm::vec2    origin,
+            tileset      set,
+            chunk_loader loader);
+    ~tilemap();
+
+    tilemap(const tilemap&)            = delete;
+    tilemap& operator=(const tilemap&) = delete;
+
+    // requests chunks intersecting the view rectangle (world units), uploads
+    // chunks the streaming thread has finished and frees chunks that left
+    // the view
+    void update(glm::vec2 view_min, glm::vec2 view_max);
+    void update(const camera& cam);
+    void draw();
+
+    std::size_t resident_chunks() const { return chunks.size(); }
+
+private:
+    struct chunk
+    {
+        unsigned int vao         = 0;
+        unsigned int vbo         = 0;
+        int          index_count = 0;
+    };
+    struct built_chunk
+    {
+        std::int64_t        key;
+        std::vector<vertex> vertices;
+    };
+
+    void        stream_loop();
+    void        build_chunk(int cx, int cy, std::vector<vertex>& out) const;
+    void        upload(built_chunk& b);
+    void        release(chunk& c);
+    glm::ivec4  chunk_range(glm::vec2 view_min, glm::vec2 view_max) const;
+    static bool in_range(glm::ivec4 range, int cx, int cy);
+
+    glm::ivec2   size_in_tiles;
+    glm::ivec2   size_in_chunks;
+    glm::vec2    tile_size;
+    glm::vec2    origin;
+    tileset      set;
+    chunk_loader loader;
+
+    std::unordered_map<std::int64_t, chunk> chunks;
+    std::unordered_map<std::int64_t, bool>  requested;
+    glm::ivec4                              visible{ 0, 0, -1, -1 };
+    unsigned int                            ebo = 0;
+    std::unique_ptr<Shader>                 shader;
+
+    std::mutex               queue_mutex;
+    std::condition_variable  queue_cv;
+    std::deque<std::int64_t> to_build;
+    std::vector<built_chunk> built;
+    std::vector<built_chunk> ready; // render thread side of built
+    bool                     stop = false;
+    std::thread              worker;
+};
+
+// loader over a tile index grid held in memory, row major bottom row first
+tilemap::chunk_loader make_grid_loader(std::vector<std::uint16_t> grid,
+                                       glm::ivec2                 size);
+} // namespace eng
+#endif // OPENGL_WINDOW_TILEMAP_HXX
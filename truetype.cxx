@@ -0,0 +1,494 @@
+#include "truetype.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace eng
+{
+std::uint8_t truetype_font::u8(std::uint32_t at) const
+{
+    return at < bytes.size() ? bytes[at] : 0;
+}
+
+std::uint16_t truetype_font::u16(std::uint32_t at) const
+{
+    return static_cast<std::uint16_t>(u8(at) << 8 | u8(at + 1));
+}
+
+std::uint32_t truetype_font::u32(std::uint32_t at) const
+{
+    return static_cast<std::uint32_t>(u16(at)) << 16 | u16(at + 2);
+}
+
+std::uint32_t truetype_font::table(const char tag[4]) const
+{
+    const int tables = u16(face + 4);
+    for (int i = 0; i < tables; ++i)
+    {
+        const std::uint32_t record = face + 12 + 16 * i;
+        if (record + 16 <= bytes.size() &&
+            std::memcmp(bytes.data() + record, tag, 4) == 0)
+        {
+            return u32(record + 8);
+        }
+    }
+    return 0;
+}
+
+bool truetype_font::load(std::vector<std::uint8_t> data)
+{
+    bytes = std::move(data);
+    face  = 0;
+    if (bytes.size() >= 12 && std::memcmp(bytes.data(), "ttcf", 4) == 0)
+    {
+        face = u32(12);
+    }
+    const std::uint32_t cmap = table("cmap");
+    const std::uint32_t head = table("head");
+    const std::uint32_t hhea = table("hhea");
+    const std::uint32_t maxp = table("maxp");
+    hmtx                     = table("hmtx");
+    loca                     = table("loca");
+    glyf                     = table("glyf");
+    // CFF fonts have neither loca nor glyf
+    if (!cmap || !head || !hhea || !maxp || !hmtx || !loca || !glyf)
+    {
+        return false;
+    }
+    glyph_count = u16(maxp + 4);
+    long_loca   = s16(head + 50) != 0;
+    ascender    = s16(hhea + 4);
+    descender   = s16(hhea + 6);
+    gap         = s16(hhea + 8);
+    h_metrics   = u16(hhea + 34);
+
+    // a full unicode table beats the basic plane one
+    cmap_subtable = 0;
+    bool full     = false;
+    for (int i = 0, n = u16(cmap + 2); i < n && !full; ++i)
+    {
+        const std::uint32_t record   = cmap + 4 + 8 * i;
+        const int           platform = u16(record);
+        const int           encoding = u16(record + 2);
+        const bool          windows  = platform == 3;
+        if (platform == 0 || (windows && (encoding == 1 || encoding == 10)))
+        {
+            cmap_subtable = cmap + u32(record + 4);
+            full          = windows ? encoding == 10 : encoding >= 4;
+        }
+    }
+    return cmap_subtable != 0 && glyph_count != 0 && ascender != descender;
+}
+
+int truetype_font::glyph_index(std::uint32_t codepoint) const
+{
+    const std::uint32_t t     = cmap_subtable;
+    std::uint32_t       glyph = 0;
+    switch (u16(t))
+    {
+        case 0:
+            glyph = codepoint < 256 ? u8(t + 6 + codepoint) : 0;
+            break;
+        case 4:
+        {
+            if (codepoint > 0xffff)
+            {
+                break;
+            }
+            const std::uint32_t segments2 = u16(t + 6);
+            const std::uint32_t ends      = t + 14;
+            const std::uint32_t starts    = ends + segments2 + 2;
+            const std::uint32_t deltas    = starts + segments2;
+            const std::uint32_t ranges    = deltas + segments2;
+            // end codes are sorted, find the first one not below codepoint
+            std::uint32_t lo = 0, hi = segments2 / 2;
+            while (lo < hi)
+            {
+                const std::uint32_t mid = (lo + hi) / 2;
+                if (u16(ends + 2 * mid) < codepoint)
+                {
+                    lo = mid + 1;
+                }
+                else
+                {
+                    hi = mid;
+                }
+            }
+            if (lo == segments2 / 2 || codepoint < u16(starts + 2 * lo))
+            {
+                break;
+            }
+            const std::uint32_t delta = u16(deltas + 2 * lo);
+            const std::uint32_t range = u16(ranges + 2 * lo);
+            if (range == 0)
+            {
+                glyph = (codepoint + delta) & 0xffff;
+                break;
+            }
+            glyph = u16(ranges + 2 * lo + range +
+                        2 * (codepoint - u16(starts + 2 * lo)));
+            glyph = glyph ? (glyph + delta) & 0xffff : 0;
+            break;
+        }
+        case 6:
+        {
+            const std::uint32_t first = u16(t + 6);
+            if (codepoint >= first && codepoint - first < u16(t + 8))
+            {
+                glyph = u16(t + 10 + 2 * (codepoint - first));
+            }
+            break;
+        }
+        case 12:
+        {
+            std::uint32_t lo = 0, hi = u32(t + 12);
+            while (lo < hi)
+            {
+                const std::uint32_t mid   = (lo + hi) / 2;
+                const std::uint32_t group = t + 16 + 12 * mid;
+                if (codepoint < u32(group))
+                {
+                    hi = mid;
+                }
+                else if (codepoint > u32(group + 4))
+                {
+                    lo = mid + 1;
+                }
+                else
+                {
+                    glyph = u32(group + 8) + codepoint - u32(group);
+                    break;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return glyph < static_cast<std::uint32_t>(glyph_count)
+               ? static_cast<int>(glyph)
+               : 0;
+}
+
+float truetype_font::scale_for_pixel_height(float pixels) const
+{
+    return pixels / static_cast<float>(ascender - descender);
+}
+
+int truetype_font::advance_width(int glyph) const
+{
+    if (h_metrics == 0 || glyph < 0)
+    {
+        return 0;
+    }
+    // glyphs past the last long metric repeat its advance
+    return u16(hmtx + 4 * std::min(glyph, h_metrics - 1));
+}
+
+std::uint32_t truetype_font::glyph_offset(int            glyph,
+                                          std::uint32_t& length) const
+{
+    length = 0;
+    if (glyph < 0 || glyph >= glyph_count)
+    {
+        return 0;
+    }
+    const std::uint32_t from = long_loca ? u32(loca + 4 * glyph)
+                                         : 2u * u16(loca + 2 * glyph);
+    const std::uint32_t to   = long_loca ? u32(loca + 4 * glyph + 4)
+                                         : 2u * u16(loca + 2 * glyph + 2);
+    length = to > from ? to - from : 0;
+    return glyf + from;
+}
+
+void truetype_font::outline(int                   glyph,
+                            const float           m[6],
+                            float                 tolerance,
+                            int                   depth,
+                            std::vector<segment>& out) const
+{
+    std::uint32_t       length = 0;
+    const std::uint32_t at     = glyph_offset(glyph, length);
+    if (length == 0)
+    {
+        return;
+    }
+    const int contours = s16(at);
+    if (contours < 0)
+    {
+        // composite: each component is another glyph under a 2x2 matrix and
+        // an offset. Components placed by matching points are rare and
+        // left at the origin
+        if (depth >= 8)
+        {
+            return;
+        }
+        std::uint32_t p = at + 10;
+        std::uint16_t flags;
+        do
+        {
+            flags           = u16(p);
+            const int child = u16(p + 2);
+            float     dx = 0.f, dy = 0.f;
+            p += 4;
+            if (flags & 0x0001)
+            {
+                dx = s16(p);
+                dy = s16(p + 2);
+                p += 4;
+            }
+            else
+            {
+                dx = static_cast<std::int8_t>(u8(p));
+                dy = static_cast<std::int8_t>(u8(p + 1));
+                p += 2;
+            }
+            if (!(flags & 0x0002))
+            {
+                dx = dy = 0.f;
+            }
+            auto f2dot14 = [this](std::uint32_t a) { return s16(a) / 16384.f; };
+            float c[4]   = { 1.f, 0.f, 0.f, 1.f };
+            if (flags & 0x0008)
+            {
+                c[0] = c[3] = f2dot14(p);
+                p += 2;
+            }
+            else if (flags & 0x0040)
+            {
+                c[0] = f2dot14(p);
+                c[3] = f2dot14(p + 2);
+                p += 4;
+            }
+            else if (flags & 0x0080)
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    c[i] = f2dot14(p + 2 * i);
+                }
+                p += 8;
+            }
+            const float combined[6] = {
+                m[0] * c[0] + m[2] * c[1],      m[1] * c[0] + m[3] * c[1],
+                m[0] * c[2] + m[2] * c[3],      m[1] * c[2] + m[3] * c[3],
+                m[0] * dx + m[2] * dy + m[4],   m[1] * dx + m[3] * dy + m[5],
+            };
+            outline(child, combined, tolerance, depth + 1, out);
+        } while (flags & 0x0020);
+        return;
+    }
+    if (contours == 0)
+    {
+        return;
+    }
+
+    struct point
+    {
+        float x, y;
+        bool  on;
+    };
+    const std::uint32_t ends   = at + 10;
+    const int           points = u16(ends + 2 * (contours - 1)) + 1;
+    std::uint32_t       p      = ends + 2 * contours;
+    p += 2 + u16(p); // instructions
+
+    // flags with their repeat counts expanded
+    std::vector<point> pts(static_cast<std::size_t>(points));
+    std::vector<std::uint8_t> flags(pts.size());
+    for (int i = 0; i < points;)
+    {
+        const std::uint8_t f = u8(p++);
+        int                n = 1;
+        if (f & 0x08)
+        {
+            n += u8(p++);
+        }
+        for (; n > 0 && i < points; --n)
+        {
+            flags[i++] = f;
+        }
+    }
+    // coordinates are deltas, short ones carry their sign in the flags
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        const std::uint8_t short_bit = axis ? 0x04 : 0x02;
+        const std::uint8_t same_bit  = axis ? 0x20 : 0x10;
+        int                value     = 0;
+        for (int i = 0; i < points; ++i)
+        {
+            if (flags[i] & short_bit)
+            {
+                const int d = u8(p++);
+                value += flags[i] & same_bit ? d : -d;
+            }
+            else if (!(flags[i] & same_bit))
+            {
+                value += s16(p);
+                p += 2;
+            }
+            (axis ? pts[i].y : pts[i].x) = static_cast<float>(value);
+        }
+    }
+    for (int i = 0; i < points; ++i)
+    {
+        const float x = pts[i].x;
+        const float y = pts[i].y;
+        pts[i].x      = m[0] * x + m[2] * y + m[4];
+        pts[i].y      = m[1] * x + m[3] * y + m[5];
+        pts[i].on     = flags[i] & 0x01;
+    }
+
+    auto line = [&out](point a, point b)
+    { out.push_back({ a.x, a.y, b.x, b.y }); };
+    auto curve = [&](point a, point c, point b)
+    {
+        // a quadratic strays |a - 2c + b| / 4 from its chord, split in n
+        // that deviation drops by n squared
+        const float dx    = a.x - 2.f * c.x + b.x;
+        const float dy    = a.y - 2.f * c.y + b.y;
+        const float error = std::sqrt(dx * dx + dy * dy) / 4.f;
+        const int   n     = std::clamp(
+            static_cast<int>(std::ceil(std::sqrt(error / tolerance))), 1, 64);
+        point prev = a;
+        for (int i = 1; i <= n; ++i)
+        {
+            const float t = static_cast<float>(i) / n;
+            const float s = 1.f - t;
+            const point q = { s * s * a.x + 2.f * s * t * c.x + t * t * b.x,
+                              s * s * a.y + 2.f * s * t * c.y + t * t * b.y,
+                              true };
+            line(prev, q);
+            prev = q;
+        }
+    };
+
+    std::vector<point> ring;
+    int                first = 0;
+    for (int c = 0; c < contours; ++c)
+    {
+        const int last = u16(ends + 2 * c);
+        if (last < first || last >= points)
+        {
+            break;
+        }
+        // two off curve points in a row imply an on curve one between them
+        ring.clear();
+        const int n = last - first + 1;
+        for (int i = 0; i < n; ++i)
+        {
+            const point a = pts[first + i];
+            const point b = pts[first + (i + 1) % n];
+            ring.push_back(a);
+            if (!a.on && !b.on)
+            {
+                ring.push_back(
+                    { (a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f, true });
+            }
+        }
+        first = last + 1;
+
+        const auto start = std::find_if(
+            ring.begin(), ring.end(), [](point q) { return q.on; });
+        if (n < 2 || start == ring.end())
+        {
+            continue;
+        }
+        const std::size_t s     = start - ring.begin();
+        const std::size_t count = ring.size();
+        for (std::size_t i = 0; i < count;)
+        {
+            const point a = ring[(s + i) % count];
+            const point b = ring[(s + i + 1) % count];
+            if (b.on)
+            {
+                line(a, b);
+                i += 1;
+            }
+            else
+            {
+                curve(a, b, ring[(s + i + 2) % count]);
+                i += 2;
+            }
+        }
+    }
+}
+
+void truetype_font::distance_field(int          glyph,
+                                   float        scale,
+                                   int          padding,
+                                   std::uint8_t on_edge,
+                                   float        pixel_dist_scale,
+                                   glyph_field& out) const
+{
+    out = glyph_field();
+    std::uint32_t       length = 0;
+    const std::uint32_t at     = glyph_offset(glyph, length);
+    if (length == 0 || scale <= 0.f)
+    {
+        return;
+    }
+    // the box in pixels, y pointing down
+    const int x0 = static_cast<int>(std::floor(s16(at + 2) * scale));
+    const int y0 = static_cast<int>(std::floor(-s16(at + 8) * scale));
+    const int x1 = static_cast<int>(std::ceil(s16(at + 6) * scale));
+    const int y1 = static_cast<int>(std::ceil(-s16(at + 4) * scale));
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+    std::vector<segment> lines;
+    const float          m[6] = { scale, 0.f, 0.f, -scale, 0.f, 0.f };
+    outline(glyph, m, 1.f / 64.f, 0, lines);
+    if (lines.empty())
+    {
+        return;
+    }
+
+    out.x_offset = x0 - padding;
+    out.y_offset = y0 - padding;
+    out.width    = x1 - x0 + 2 * padding;
+    out.height   = y1 - y0 + 2 * padding;
+    out.pixels.resize(static_cast<std::size_t>(out.width) * out.height);
+    for (int y = 0; y < out.height; ++y)
+    {
+        const float py = out.y_offset + y + 0.5f;
+        for (int x = 0; x < out.width; ++x)
+        {
+            const float px      = out.x_offset + x + 0.5f;
+            float       nearest = std::numeric_limits<float>::max();
+            int         winding = 0;
+            for (const segment& l : lines)
+            {
+                const float ex  = l.x1 - l.x0;
+                const float ey  = l.y1 - l.y0;
+                const float wx  = px - l.x0;
+                const float wy  = py - l.y0;
+                const float len = ex * ex + ey * ey;
+                const float t =
+                    len > 0.f ? std::clamp((wx * ex + wy * ey) / len, 0.f, 1.f)
+                              : 0.f;
+                const float dx = wx - t * ex;
+                const float dy = wy - t * ey;
+                nearest        = std::min(nearest, dx * dx + dy * dy);
+                // nonzero rule along a ray towards +x
+                const float side = ex * wy - ey * wx;
+                if (l.y0 <= py && py < l.y1 && side > 0.f)
+                {
+                    ++winding;
+                }
+                else if (l.y1 <= py && py < l.y0 && side < 0.f)
+                {
+                    --winding;
+                }
+            }
+            const float distance =
+                winding ? std::sqrt(nearest) : -std::sqrt(nearest);
+            const float value = on_edge + pixel_dist_scale * distance;
+            out.pixels[static_cast<std::size_t>(y) * out.width + x] =
+                static_cast<std::uint8_t>(std::clamp(value, 0.f, 255.f));
+        }
+    }
+}
+} // namespace eng
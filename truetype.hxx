@@ -0,0 +1,87 @@
+#ifndef OPENGL_WINDOW_TRUETYPE_HXX
+#define OPENGL_WINDOW_TRUETYPE_HXX
+#include <cstdint>
+#include <vector>
+
+namespace eng
+{
+// signed distance field of one glyph in pixels, rows top down
+struct glyph_field
+{
+    std::vector<std::uint8_t> pixels; // width * height, empty for blanks
+    int                       width    = 0;
+    int                       height   = 0;
+    int                       x_offset = 0; // top left corner from the pen,
+    int                       y_offset = 0; // y pointing down
+};
+
+// the parts of a TrueType font a text atlas needs: metrics, the cmap and the
+// quadratic outlines of the glyf table. Fonts with CFF outlines are rejected
+// and a collection only opens its first face. All values are in font units
+// unless named otherwise
+class truetype_font
+{
+public:
+    // false when data isn't a TrueType font with glyf outlines
+    bool load(std::vector<std::uint8_t> data);
+
+    // 0, the missing glyph, for codepoints the font does not map
+    int glyph_index(std::uint32_t codepoint) const;
+    // pixels per font unit for a font whose ascent to descent spans pixels
+    float scale_for_pixel_height(float pixels) const;
+
+    int ascent() const { return ascender; }
+    int descent() const { return descender; } // negative below the baseline
+    int line_gap() const { return gap; }
+    int advance_width(int glyph) const;
+
+    // padding pixels of field around the outline, a pixel on the outline
+    // stores on_edge and every pixel further inside adds pixel_dist_scale
+    void distance_field(int          glyph,
+                        float        scale,
+                        int          padding,
+                        std::uint8_t on_edge,
+                        float        pixel_dist_scale,
+                        glyph_field& out) const;
+
+private:
+    struct segment
+    {
+        float x0, y0, x1, y1;
+    };
+
+    std::uint32_t table(const char tag[4]) const;
+    std::uint32_t glyph_offset(int glyph, std::uint32_t& length) const;
+    // appends the outline under the 2x3 matrix m, flattened to lines that
+    // stray at most tolerance from the curves
+    void outline(int                   glyph,
+                 const float           m[6],
+                 float                 tolerance,
+                 int                   depth,
+                 std::vector<segment>& out) const;
+
+    // reads past the end return 0, a broken font draws garbage but never
+    // reads outside its bytes
+    std::uint8_t  u8(std::uint32_t at) const;
+    std::uint16_t u16(std::uint32_t at) const;
+    std::uint32_t u32(std::uint32_t at) const;
+    std::int16_t  s16(std::uint32_t at) const
+    {
+        return static_cast<std::int16_t>(u16(at));
+    }
+
+    std::vector<std::uint8_t> bytes;
+    std::uint32_t             face          = 0; // table directory offset
+    std::uint32_t             cmap_subtable = 0;
+    std::uint32_t             loca          = 0;
+    std::uint32_t             glyf          = 0;
+    std::uint32_t             hmtx          = 0;
+    bool                      long_loca     = false;
+    int                       glyph_count   = 0;
+    int                       h_metrics     = 0;
+    int                       ascender      = 0;
+    int                       descender     = 0;
+    int                       gap           = 0;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_TRUETYPE_HXX
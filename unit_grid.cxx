@@ -0,0 +1,229 @@
+#include "unit_grid.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace eng
+{
+namespace
+{
+constexpr float infinity = std::numeric_limits<float>::infinity();
+
+// fraction of the segment a + d * t, t in [t0, t1], where it enters the box,
+// the slab test: false when it misses
+bool clip_segment(glm::vec2 a,
+                  glm::vec2 d,
+                  glm::vec2 box_min,
+                  glm::vec2 box_max,
+                  float&    t0,
+                  float&    t1)
+{
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        if (d[axis] == 0.f)
+        {
+            if (a[axis] < box_min[axis] || a[axis] > box_max[axis])
+            {
+                return false;
+            }
+            continue;
+        }
+        const float inv  = 1.f / d[axis];
+        float       near = (box_min[axis] - a[axis]) * inv;
+        float       far  = (box_max[axis] - a[axis]) * inv;
+        if (near > far)
+        {
+            std::swap(near, far);
+        }
+        t0 = std::max(t0, near);
+        t1 = std::min(t1, far);
+        if (t0 > t1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+unit_grid::unit_grid(glm::vec2 min_, glm::vec2 max_, float cell_size)
+    : min(min_)
+    , max(max_)
+    , cell(cell_size)
+    , inv_cell(1.f / cell_size)
+{
+    const glm::vec2 extent = max - min;
+    columns = std::max(1, static_cast<int>(std::ceil(extent.x * inv_cell)));
+    rows    = std::max(1, static_cast<int>(std::ceil(extent.y * inv_cell)));
+    cell_start.assign(static_cast<std::size_t>(columns) * rows + 1, 0);
+}
+
+glm::ivec4 unit_grid::cell_range(float x, float y) const
+{
+    const auto column = [this](float v) {
+        const int c = static_cast<int>(std::floor((v - min.x) * inv_cell));
+        return std::clamp(c, 0, columns - 1);
+    };
+    const auto row = [this](float v) {
+        const int r = static_cast<int>(std::floor((v - min.y) * inv_cell));
+        return std::clamp(r, 0, rows - 1);
+    };
+    return glm::ivec4(column(x - half), row(y - half), column(x + half),
+                      row(y + half));
+}
+
+void unit_grid::build(const float* x,
+                      const float* y,
+                      std::size_t  n,
+                      float        half_extent)
+{
+    half       = half_extent;
+    unit_count = n;
+    std::fill(cell_start.begin(), cell_start.end(), 0u);
+
+    // count into cell_start[c + 1], the prefix sum turns counts into starts
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const glm::ivec4 r = cell_range(x[i], y[i]);
+        for (int cy = r.y; cy <= r.w; ++cy)
+        {
+            for (int cx = r.x; cx <= r.z; ++cx)
+            {
+                ++cell_start[static_cast<std::size_t>(cy) * columns + cx + 1];
+                ++total;
+            }
+        }
+    }
+    for (std::size_t c = 1; c < cell_start.size(); ++c)
+    {
+        cell_start[c] += cell_start[c - 1];
+    }
+    if (entries.size() < total)
+    {
+        entries.resize(total);
+    }
+
+    // the second pass fills each cell from its start, cell_start[c] ends up
+    // at the start of cell c + 1 and is shifted back afterwards
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const glm::ivec4 r = cell_range(x[i], y[i]);
+        for (int cy = r.y; cy <= r.w; ++cy)
+        {
+            for (int cx = r.x; cx <= r.z; ++cx)
+            {
+                const std::size_t c = static_cast<std::size_t>(cy) * columns +
+                                      cx;
+                entries[cell_start[c]++] = { static_cast<std::uint32_t>(i),
+                                             x[i], y[i] };
+            }
+        }
+    }
+    for (std::size_t c = cell_start.size() - 1; c > 0; --c)
+    {
+        cell_start[c] = cell_start[c - 1];
+    }
+    cell_start[0] = 0;
+}
+
+std::size_t unit_grid::raycast(glm::vec2   a,
+                               glm::vec2   b,
+                               std::size_t ignore,
+                               float&      t) const
+{
+    const glm::vec2 d = b - a;
+
+    // start walking where the segment enters the grid, a unit box sticking
+    // out of the border cells still only lives in them, so the grid is
+    // grown by the box size for the clip
+    float           t0 = 0.f;
+    float           t1 = 1.f;
+    const glm::vec2 pad(half);
+    if (unit_count == 0 || !clip_segment(a, d, min - pad, max + pad, t0, t1))
+    {
+        return npos;
+    }
+    const glm::vec2 start = a + d * t0;
+    int cx = std::clamp(static_cast<int>(std::floor((start.x - min.x) *
+                                                    inv_cell)),
+                        0, columns - 1);
+    int cy = std::clamp(static_cast<int>(std::floor((start.y - min.y) *
+                                                    inv_cell)),
+                        0, rows - 1);
+
+    // amanatides and woo: the t at which the segment crosses the next
+    // column and row boundary, and the t one cell further takes
+    const int step_x  = d.x > 0.f ? 1 : -1;
+    const int step_y  = d.y > 0.f ? 1 : -1;
+    float     next_x  = infinity;
+    float     next_y  = infinity;
+    float     delta_x = infinity;
+    float     delta_y = infinity;
+    if (d.x != 0.f)
+    {
+        const float edge = min.x + (cx + (step_x > 0 ? 1 : 0)) * cell;
+        next_x           = (edge - a.x) / d.x;
+        delta_x          = cell / std::abs(d.x);
+    }
+    if (d.y != 0.f)
+    {
+        const float edge = min.y + (cy + (step_y > 0 ? 1 : 0)) * cell;
+        next_y           = (edge - a.y) / d.y;
+        delta_y          = cell / std::abs(d.y);
+    }
+
+    std::size_t best   = npos;
+    float       best_t = infinity;
+    for (;;)
+    {
+        const std::size_t c = static_cast<std::size_t>(cy) * columns + cx;
+        for (std::uint32_t e = cell_start[c]; e < cell_start[c + 1]; ++e)
+        {
+            const entry& u = entries[e];
+            if (u.unit == ignore)
+            {
+                continue;
+            }
+            float enter = 0.f;
+            float leave = 1.f;
+            if (clip_segment(a, d, glm::vec2(u.x - half, u.y - half),
+                             glm::vec2(u.x + half, u.y + half), enter, leave) &&
+                enter < best_t)
+            {
+                best   = u.unit;
+                best_t = enter;
+            }
+        }
+
+        // a hit before the segment leaves this cell can't be beaten by a
+        // unit in a later one
+        const float leave_cell = std::min(next_x, next_y);
+        if (best_t <= leave_cell || leave_cell > t1)
+        {
+            break;
+        }
+        if (next_x < next_y)
+        {
+            cx += step_x;
+            next_x += delta_x;
+            if (cx < 0 || cx >= columns)
+            {
+                break;
+            }
+        }
+        else
+        {
+            cy += step_y;
+            next_y += delta_y;
+            if (cy < 0 || cy >= rows)
+            {
+                break;
+            }
+        }
+    }
+    t = best_t;
+    return best;
+}
+} // namespace eng
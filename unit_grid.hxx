@@ -0,0 +1,63 @@
+#ifndef OPENGL_WINDOW_UNIT_GRID_HXX
+#define OPENGL_WINDOW_UNIT_GRID_HXX
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace eng
+{
+// broad phase over square unit boxes: a uniform grid rebuilt every tick
+// with a counting sort, so cells are ranges of one packed array and a
+// build allocates nothing once the arrays have grown. A unit is listed in
+// every cell its box overlaps, a query only walks the cells it touches
+class unit_grid
+{
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // boxes outside [min, max] are listed in the border cells
+    unit_grid(glm::vec2 min, glm::vec2 max, float cell_size);
+
+    // n units at (x[i], y[i]), each a box of half_extent around its centre
+    void build(const float* x,
+               const float* y,
+               std::size_t  n,
+               float        half_extent);
+
+    // the unit whose box the segment from a to b enters first, skipping
+    // unit ignore, npos when none. t receives where along the segment, 0
+    // when a is inside the box. Walks the cells the segment crosses in
+    // order and stops at the first one holding a hit, any segment length
+    std::size_t raycast(glm::vec2   a,
+                        glm::vec2   b,
+                        std::size_t ignore,
+                        float&      t) const;
+
+    std::size_t units() const { return unit_count; }
+    glm::ivec2  cells() const { return glm::ivec2(columns, rows); }
+
+private:
+    struct entry
+    {
+        std::uint32_t unit;
+        float         x;
+        float         y;
+    };
+
+    glm::ivec4 cell_range(float x, float y) const;
+
+    glm::vec2                  min;
+    glm::vec2                  max;
+    float                      cell;
+    float                      inv_cell;
+    int                        columns;
+    int                        rows;
+    float                      half       = 0.f;
+    std::size_t                unit_count = 0;
+    std::vector<std::uint32_t> cell_start; // columns * rows + 1 offsets
+    std::vector<entry>         entries;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_UNIT_GRID_HXX
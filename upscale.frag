@@ -0,0 +1,27 @@
+#version 320 es
+
+precision mediump float;
+out vec4 FragColor;
+in vec2 TexCoord;
+uniform sampler2D scene;
+uniform float sharpness; // 0 to 1
+
+void main()
+{
+    vec3 c = texture(scene, TexCoord).rgb;
+#ifdef SHARPEN
+    // unsharp mask over the neighbours one source texel away, weaker where
+    // the contrast is already high and clamped to their range so edges do
+    // not ring
+    vec2 texel = 1.0 / vec2(textureSize(scene, 0));
+    vec3 n  = texture(scene, TexCoord + vec2(0.0, texel.y)).rgb;
+    vec3 s  = texture(scene, TexCoord - vec2(0.0, texel.y)).rgb;
+    vec3 e  = texture(scene, TexCoord + vec2(texel.x, 0.0)).rgb;
+    vec3 w  = texture(scene, TexCoord - vec2(texel.x, 0.0)).rgb;
+    vec3 lo = min(c, min(min(n, s), min(e, w)));
+    vec3 hi = max(c, max(max(n, s), max(e, w)));
+    vec3 amount = sharpness * (1.0 - (hi - lo));
+    c = clamp(c + (c - 0.25 * (n + s + e + w)) * amount, lo, hi);
+#endif
+    FragColor = vec4(c, 1.0);
+}
@@ -0,0 +1,12 @@
+#version 320 es
+
+precision highp float;
+// one triangle covering the window, no vertex buffer needed
+out vec2 TexCoord;
+
+void main()
+{
+    vec2 p      = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+    TexCoord    = p;
+    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -1,19 +1,33 @@
 #version 320 es
 
 precision mediump float;
+#ifdef COMPACT_VERTEX
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec4 aColor;
+#else
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
+#endif
 layout (location = 2) in vec2 aTexPos;
 
 out vec3 ourColor;
 out vec2 TexCoord;
 
+layout (std140, binding = 0) uniform camera_block
+{
+    mat4 view_projection;
+    vec4 viewport;
+};
 uniform mat4 transform;
 
 void main()
 {
-    gl_Position = transform * vec4(aPos, 1.0);
-    ourColor = aColor;
+#ifdef COMPACT_VERTEX
+    gl_Position = view_projection * transform * vec4(aPos, 0.0, 1.0);
+#else
+    gl_Position = view_projection * transform * vec4(aPos, 1.0);
+#endif
+    ourColor = aColor.rgb;
     TexCoord = aTexPos;
 
 }
@@ -0,0 +1,78 @@
+#ifndef OPENGL_WINDOW_VERTEX_FORMAT_HXX
+#define OPENGL_WINDOW_VERTEX_FORMAT_HXX
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace eng
+{
+// 16 byte sprite vertex used by vertex_layout::compact: z is always 0 for
+// sprites, texture coordinates are half floats so repeating coordinates
+// above 1 keep working, colour is normalized bytes
+struct compact_vertex
+{
+    float         x;
+    float         y;
+    std::uint16_t tx; // half float
+    std::uint16_t ty; // half float
+    std::uint8_t  r;
+    std::uint8_t  g;
+    std::uint8_t  b;
+    std::uint8_t  a;
+};
+static_assert(sizeof(compact_vertex) == 16, "compact_vertex is 16 bytes");
+
+// IEEE 754 binary16, round to nearest even
+inline std::uint16_t float_to_half(float f)
+{
+    std::uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    const std::uint32_t sign     = (x >> 16) & 0x8000u;
+    const std::uint32_t exponent = (x >> 23) & 0xffu;
+    std::uint32_t       mantissa = x & 0x7fffffu;
+
+    if (exponent == 0xffu)
+    {
+        return static_cast<std::uint16_t>(sign | 0x7c00u |
+                                          (mantissa ? 0x200u : 0u));
+    }
+    const int e = static_cast<int>(exponent) - 127 + 15;
+    if (e >= 31)
+    {
+        return static_cast<std::uint16_t>(sign | 0x7c00u);
+    }
+    if (e <= 0)
+    {
+        // subnormal half or zero
+        if (e < -10)
+        {
+            return static_cast<std::uint16_t>(sign);
+        }
+        mantissa |= 0x800000u;
+        const int           shift = 14 - e;
+        std::uint32_t       h     = mantissa >> shift;
+        const std::uint32_t rest  = mantissa & ((1u << shift) - 1u);
+        const std::uint32_t half  = 1u << (shift - 1);
+        if (rest > half || (rest == half && (h & 1u)))
+        {
+            ++h;
+        }
+        return static_cast<std::uint16_t>(sign | h);
+    }
+    std::uint32_t h =
+        sign | (static_cast<std::uint32_t>(e) << 10) | (mantissa >> 13);
+    const std::uint32_t rest = mantissa & 0x1fffu;
+    // a carry out of the mantissa correctly bumps the exponent
+    if (rest > 0x1000u || (rest == 0x1000u && (h & 1u)))
+    {
+        ++h;
+    }
+    return static_cast<std::uint16_t>(h);
+}
+
+inline std::uint8_t float_to_unorm8(float f)
+{
+    return static_cast<std::uint8_t>(std::clamp(f, 0.f, 1.f) * 255.f + 0.5f);
+}
+} // namespace eng
+#endif // OPENGL_WINDOW_VERTEX_FORMAT_HXX
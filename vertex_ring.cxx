@@ -0,0 +1,135 @@
+#include "vertex_ring.hxx"
+
+#include <algorithm>
+
+#include "gl_check.hxx"
+#include "render_stats.hxx"
+
+namespace eng
+{
+vertex_ring::vertex_ring(GLenum target, std::size_t bytes_per_region)
+    : target(target)
+    , region_bytes(bytes_per_region)
+{
+    glGenBuffers(1, &name);
+    OM_GL_CHECK(glGenBuffers)
+    glBindBuffer(target, name);
+    glBufferData(target, region_bytes * regions, nullptr, GL_STREAM_DRAW);
+    OM_GL_CHECK(glBufferData)
+    gpu_memory_bytes() += region_bytes * regions;
+}
+
+vertex_ring::~vertex_ring()
+{
+    unmap();
+    for (GLsync& f : fences)
+    {
+        if (f)
+        {
+            glDeleteSync(f);
+        }
+    }
+    glDeleteBuffers(1, &name);
+    gpu_memory_bytes() -= region_bytes * regions;
+}
+
+void vertex_ring::begin_region()
+{
+    if (open)
+    {
+        end_region();
+    }
+    region = (region + 1) % regions;
+    offset = 0;
+    open   = true;
+
+    if (GLsync f = fences[region])
+    {
+        GLenum status = glClientWaitSync(f, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+        {
+            ++counters.fence_waits;
+            do
+            {
+                status = glClientWaitSync(
+                    f, GL_SYNC_FLUSH_COMMANDS_BIT, 1000 * 1000 * 1000);
+            } while (status == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(f);
+        fences[region] = nullptr;
+    }
+    map_tail();
+}
+
+void* vertex_ring::allocate(std::size_t  size,
+                            std::size_t  align,
+                            std::size_t& out_offset)
+{
+    const std::size_t aligned = (offset + align - 1) / align * align;
+    if (aligned + size > region_bytes)
+    {
+        ++counters.overflows;
+        return nullptr;
+    }
+    if (!open)
+    {
+        return nullptr;
+    }
+    if (!mapped)
+    {
+        map_tail();
+        if (!mapped)
+        {
+            return nullptr;
+        }
+    }
+    offset                 = aligned + size;
+    counters.peak_bytes    = std::max(counters.peak_bytes, offset);
+    const std::size_t base = region * region_bytes;
+    out_offset             = base + aligned;
+    return mapped + (aligned - mapped_from);
+}
+
+void vertex_ring::unmap()
+{
+    if (!mapped)
+    {
+        return;
+    }
+    glBindBuffer(target, name);
+    glUnmapBuffer(target);
+    OM_GL_CHECK(glUnmapBuffer)
+    mapped = nullptr;
+}
+
+void vertex_ring::end_region()
+{
+    unmap();
+    if (!open)
+    {
+        return;
+    }
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    OM_GL_CHECK(glFenceSync)
+    open = false;
+}
+
+void vertex_ring::map_tail()
+{
+    if (offset >= region_bytes)
+    {
+        return;
+    }
+    // the fence of this region has signaled and draws issued from its head
+    // this frame never read past offset, nothing below can be in use
+    glBindBuffer(target, name);
+    mapped_from = offset;
+    mapped      = static_cast<unsigned char*>(
+        glMapBufferRange(target,
+                         region * region_bytes + offset,
+                         region_bytes - offset,
+                         GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                             GL_MAP_INVALIDATE_RANGE_BIT));
+    OM_GL_CHECK(glMapBufferRange)
+}
+} // namespace eng
@@ -0,0 +1,65 @@
+#ifndef OPENGL_WINDOW_VERTEX_RING_HXX
+#define OPENGL_WINDOW_VERTEX_RING_HXX
+#include <cstddef>
+#include <cstdint>
+
+#include "glad/glad.h"
+
+#include "frame_arena.hxx"
+
+namespace eng
+{
+// GL buffer split in regions that the CPU fills through an unsynchronized
+// mapping. A region is fenced once the draws reading it are submitted and
+// is only mapped again after that fence has signaled, so writes never race
+// the GPU and the driver never has to orphan or stall on the buffer.
+class vertex_ring
+{
+public:
+    static constexpr int regions = frame_arena::frames_in_flight;
+
+    struct usage
+    {
+        std::uint64_t fence_waits = 0; // begin_region had to block
+        std::size_t   peak_bytes  = 0; // most bytes written to one region
+        std::uint64_t overflows   = 0; // allocate found the region full
+    };
+
+    // target is GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER
+    vertex_ring(GLenum target, std::size_t bytes_per_region);
+    ~vertex_ring();
+
+    vertex_ring(const vertex_ring&)            = delete;
+    vertex_ring& operator=(const vertex_ring&) = delete;
+
+    // moves to the next region, waits for its fence and maps it
+    void begin_region();
+    // write pointer for size bytes, offset receives the byte offset from
+    // the start of the buffer, null when the region is full
+    void* allocate(std::size_t size, std::size_t align, std::size_t& offset);
+    // draws may read what was written only after the region is unmapped,
+    // later allocations map the untouched rest of the region again
+    void unmap();
+    // unmaps and fences the region, call after its draws were submitted
+    void end_region();
+
+    GLuint      buffer() const { return name; }
+    std::size_t region_size() const { return region_bytes; }
+    usage       stats() const { return counters; }
+
+private:
+    void map_tail();
+
+    GLenum         target;
+    GLuint         name = 0;
+    std::size_t    region_bytes;
+    int            region      = regions - 1;
+    std::size_t    offset      = 0; // next free byte within the region
+    std::size_t    mapped_from = 0; // region offset the mapping starts at
+    unsigned char* mapped      = nullptr;
+    bool           open        = false;
+    GLsync         fences[regions]{};
+    usage          counters;
+};
+} // namespace eng
+#endif // OPENGL_WINDOW_VERTEX_RING_HXX